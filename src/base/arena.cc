@@ -0,0 +1,82 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file is the implementation of Arena.
+*/
+
+#include "src/base/arena.h"
+
+#include <stdlib.h>
+
+const size_t Arena::kDefaultBlockSize;
+const size_t Arena::kDefaultAlignment;
+
+Arena::Arena(size_t block_size)
+  : m_block_size(block_size),
+    m_current(0),
+    m_offset(0),
+    m_used(0),
+    m_reserved(0) {
+  CHECK_GT(m_block_size, 0);
+}
+
+Arena::~Arena() {
+  for (size_t i = 0; i < m_blocks.size(); ++i) {
+    free(m_blocks[i].data);
+  }
+}
+
+void* Arena::Allocate(size_t bytes, size_t align) {
+  CHECK_EQ(align & (align - 1), 0);
+  for (;;) {
+    if (m_current < m_blocks.size()) {
+      Block& block = m_blocks[m_current];
+      uintptr_t begin = reinterpret_cast<uintptr_t>(block.data);
+      uintptr_t ptr = (begin + m_offset + align - 1) & ~(align - 1);
+      if (ptr + bytes <= begin + block.size) {
+        m_offset = ptr + bytes - begin;
+        m_used += bytes;
+        return reinterpret_cast<void*>(ptr);
+      }
+      // Leave the rest of this block, and go on with the next one.
+      if (m_current + 1 < m_blocks.size() || m_offset > 0) {
+        ++m_current;
+        m_offset = 0;
+        continue;
+      }
+    }
+    // No block left can hold this allocation. Note that a large
+    // allocation gets a block of its own.
+    Block block;
+    block.size = bytes + align > m_block_size ?
+                 bytes + align : m_block_size;
+    block.data = static_cast<char*>(malloc(block.size));
+    if (block.data == NULL) {
+      LOG(FATAL) << "Cannot allocate " << block.size
+                 << " bytes for Arena.";
+    }
+    m_reserved += block.size;
+    m_current = m_blocks.size();
+    m_offset = 0;
+    m_blocks.push_back(block);
+  }
+}
+
+void Arena::Reset() {
+  m_current = 0;
+  m_offset = 0;
+  m_used = 0;
+}
@@ -0,0 +1,104 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file defines Arena, a bump allocator that hands out memory
+from a few large blocks and releases all of it at once.
+*/
+
+#ifndef F2M_BASE_ARENA_H_
+#define F2M_BASE_ARENA_H_
+
+#include <stddef.h>
+
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "src/base/common.h"
+
+//------------------------------------------------------------------------------
+// Arena is used to store a large number of small objects that are freed
+// together, such as the parsed rows of a dataset or of a mini-batch.
+// Allocate() only moves a pointer forward inside the current block, and
+// Reset() makes all the memory available again in O(1) without returning
+// the blocks to the system, so an arena that is reset between batches
+// stops calling malloc after the first batch:
+//
+//   Arena arena;
+//   Loop {
+//     arena.Reset();
+//     real_t* X = arena.AllocateArray<real_t>(len);
+//     ...
+//   }
+//
+// Arena never runs destructors, so New() only accepts the types that are
+// trivially destructible. Arena is not thread-safe.
+//------------------------------------------------------------------------------
+class Arena {
+ public:
+  static const size_t kDefaultBlockSize = 1 << 20;
+  static const size_t kDefaultAlignment = 16;
+
+  explicit Arena(size_t block_size = kDefaultBlockSize);
+  ~Arena();
+
+  // Return |bytes| bytes aligned to |align|, which is a power of 2.
+  void* Allocate(size_t bytes, size_t align = kDefaultAlignment);
+
+  // Return an uninitialized array of |num| elements.
+  template <typename T>
+  T* AllocateArray(size_t num) {
+    size_t align = alignof(T) > kDefaultAlignment ?
+                   alignof(T) : kDefaultAlignment;
+    return static_cast<T*>(Allocate(num * sizeof(T), align));
+  }
+
+  // Construct an object in the arena.
+  template <typename T, typename... Args>
+  T* New(Args&&... args) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "Arena never calls the destructor.");
+    void* ptr = Allocate(sizeof(T), alignof(T));
+    return new (ptr) T(std::forward<Args>(args)...);
+  }
+
+  // Release all the allocations, but keep the blocks for reuse.
+  void Reset();
+
+  // The number of bytes handed out since the last Reset().
+  size_t BytesUsed() const { return m_used; }
+
+  // The number of bytes held by the blocks.
+  size_t MemoryUsage() const { return m_reserved; }
+
+ private:
+  struct Block {
+    char* data;
+    size_t size;
+  };
+
+  size_t m_block_size;           // the size of a regular block.
+  std::vector<Block> m_blocks;   // blocks in the order they are used.
+  size_t m_current;              // the block we are allocating from.
+  size_t m_offset;               // first free byte in the current block.
+  size_t m_used;                 // bytes handed out since Reset().
+  size_t m_reserved;             // total size of all blocks.
+
+  DISALLOW_COPY_AND_ASSIGN(Arena);
+};
+
+#endif // F2M_BASE_ARENA_H_
@@ -0,0 +1,74 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file tests arena.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+
+#include "src/base/arena.h"
+
+struct Pair {
+  Pair(int a, int b) : first(a), second(b) {}
+  int first;
+  int second;
+};
+
+TEST(Arena, Allocate) {
+  Arena arena(1024);
+  EXPECT_EQ(arena.MemoryUsage(), 0);
+  char* a = static_cast<char*>(arena.Allocate(10));
+  char* b = static_cast<char*>(arena.Allocate(10));
+  // Bump allocation inside one block.
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % Arena::kDefaultAlignment, 0);
+  EXPECT_EQ(b - a, 16);
+  EXPECT_EQ(arena.BytesUsed(), 20);
+  double* c = arena.AllocateArray<double>(4);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % 16, 0);
+  void* d = arena.Allocate(3, 64);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(d) % 64, 0);
+  EXPECT_EQ(arena.MemoryUsage(), 1024);
+  // A large allocation gets a block of its own.
+  int* e = arena.AllocateArray<int>(1000);
+  for (int i = 0; i < 1000; ++i) e[i] = i;
+  EXPECT_GE(arena.MemoryUsage(), 1024 + 4000);
+  Pair* p = arena.New<Pair>(1, 2);
+  EXPECT_EQ(p->first, 1);
+  EXPECT_EQ(p->second, 2);
+}
+
+TEST(Arena, Reset) {
+  Arena arena(1024);
+  char* first = NULL;
+  size_t memory = 0;
+  for (int round = 0; round < 10; ++round) {
+    arena.Reset();
+    EXPECT_EQ(arena.BytesUsed(), 0);
+    char* ptr = static_cast<char*>(arena.Allocate(100));
+    for (int i = 0; i < 50; ++i) {
+      arena.Allocate(100);
+    }
+    if (round == 0) {
+      first = ptr;
+      memory = arena.MemoryUsage();
+    }
+    // The blocks are reused after Reset().
+    EXPECT_EQ(ptr, first);
+    EXPECT_EQ(arena.MemoryUsage(), memory);
+  }
+}
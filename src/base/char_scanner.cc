@@ -0,0 +1,147 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file implements char_scanner.h with SSE2, and dispatches
+to the AVX2 kernel in char_scanner_avx2.cc when the CPU has AVX2.
+*/
+
+#include "src/base/char_scanner.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "src/base/common.h"
+
+// Defined in char_scanner_avx2.cc.
+#if defined(F2M_USE_AVX2)
+uint64 CharMaskAVX2(const char* block, const char* chars, int num_chars);
+#endif
+
+namespace {
+
+#if defined(F2M_USE_AVX2)
+bool HasAVX2() { return __builtin_cpu_supports("avx2"); }
+#else
+bool HasAVX2() { return false; }
+#endif
+
+// Check the CPU once.
+const bool kUseAVX2 = HasAVX2();
+
+#if defined(__SSE2__)
+
+// Compare 4 x 16 bytes with every character.
+uint64 CharMaskSSE2(const char* block, const char* chars, int num_chars) {
+  const __m128i* p = reinterpret_cast<const __m128i*>(block);
+  __m128i b0 = _mm_loadu_si128(p);
+  __m128i b1 = _mm_loadu_si128(p + 1);
+  __m128i b2 = _mm_loadu_si128(p + 2);
+  __m128i b3 = _mm_loadu_si128(p + 3);
+  __m128i m0 = _mm_setzero_si128();
+  __m128i m1 = _mm_setzero_si128();
+  __m128i m2 = _mm_setzero_si128();
+  __m128i m3 = _mm_setzero_si128();
+  for (int i = 0; i < num_chars; ++i) {
+    __m128i c = _mm_set1_epi8(chars[i]);
+    m0 = _mm_or_si128(m0, _mm_cmpeq_epi8(b0, c));
+    m1 = _mm_or_si128(m1, _mm_cmpeq_epi8(b1, c));
+    m2 = _mm_or_si128(m2, _mm_cmpeq_epi8(b2, c));
+    m3 = _mm_or_si128(m3, _mm_cmpeq_epi8(b3, c));
+  }
+  return static_cast<uint64>(static_cast<uint16>(_mm_movemask_epi8(m0))) |
+         static_cast<uint64>(static_cast<uint16>(_mm_movemask_epi8(m1))) << 16 |
+         static_cast<uint64>(static_cast<uint16>(_mm_movemask_epi8(m2))) << 32 |
+         static_cast<uint64>(static_cast<uint16>(_mm_movemask_epi8(m3))) << 48;
+}
+
+#else
+
+uint64 CharMaskScalar(const char* block, const char* chars, int num_chars) {
+  uint64 mask = 0;
+  for (size_t j = 0; j < CharScanner::kBlockSize; ++j) {
+    for (int i = 0; i < num_chars; ++i) {
+      if (block[j] == chars[i]) mask |= static_cast<uint64>(1) << j;
+    }
+  }
+  return mask;
+}
+
+#endif
+
+inline uint64 CharMask(const char* block, const char* chars, int num_chars) {
+#if defined(F2M_USE_AVX2)
+  if (kUseAVX2) return CharMaskAVX2(block, chars, num_chars);
+#endif
+#if defined(__SSE2__)
+  return CharMaskSSE2(block, chars, num_chars);
+#else
+  return CharMaskScalar(block, chars, num_chars);
+#endif
+}
+
+} // namespace
+
+CharScanner::CharScanner(const char* chars) {
+  CHECK_NOTNULL(chars);
+  m_num_chars = strlen(chars);
+  CHECK_GT(m_num_chars, 0);
+  CHECK_LE(m_num_chars, kMaxChars);
+  memcpy(m_chars, chars, m_num_chars);
+  memset(m_match, 0, sizeof(m_match));
+  for (int i = 0; i < m_num_chars; ++i) {
+    m_match[static_cast<uint8>(chars[i])] = true;
+  }
+}
+
+uint64 CharScanner::Mask(const char* block, const char* end) const {
+  if (end - block >= static_cast<ptrdiff_t>(kBlockSize)) {
+    return CharMask(block, m_chars, m_num_chars);
+  }
+  // The last block of a text is copied, so that we do not read
+  // beyond its end. '\0' is never one of the characters.
+  char tail[kBlockSize];
+  memset(tail, 0, kBlockSize);
+  memcpy(tail, block, end - block);
+  return CharMask(tail, m_chars, m_num_chars);
+}
+
+const char* CharScanner::Find(const char* begin, const char* end) const {
+  for (const char* block = begin; block < end; block += kBlockSize) {
+    uint64 mask = Mask(block, end);
+    if (mask != 0) return block + __builtin_ctzll(mask);
+  }
+  return end;
+}
+
+uint64 CharScanner::Count(const char* begin, const char* end) const {
+  uint64 count = 0;
+  for (const char* block = begin; block < end; block += kBlockSize) {
+    count += __builtin_popcountll(Mask(block, end));
+  }
+  return count;
+}
+
+const char* CharScannerISA() {
+  if (kUseAVX2) return "avx2";
+#if defined(__SSE2__)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
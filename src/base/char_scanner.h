@@ -0,0 +1,97 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file defines CharScanner, which finds delimiters in
+a text 64 bytes at a time.
+*/
+
+#ifndef F2M_BASE_CHAR_SCANNER_H_
+#define F2M_BASE_CHAR_SCANNER_H_
+
+#include <stddef.h>
+
+#include "src/base/common.h"
+
+/* -----------------------------------------------------------------------------
+ * The reader looks for the newlines of a file and the parser looks for the     *
+ * tabs, spaces and colons of a line. Comparing the bytes one by one is slow,   *
+ * so CharScanner compares 64 bytes with every delimiter at once using SSE2     *
+ * or AVX2 (when the CPU supports it), and turns the result into a bitmask of   *
+ * 64 bits. Then a delimiter is found by counting the trailing zeros of the     *
+ * mask, and all the delimiters of a block are walked without reading the       *
+ * bytes again:                                                                 *
+ *                                                                              *
+ *   CharScanner newline("\n");                                                 *
+ *   uint64 num_lines = newline.Count(buf, buf + size);                         *
+ *   const char* eol = newline.Find(buf, buf + size);                           *
+ *                                                                              *
+ *   CharScanner blank(" \t");                                                  *
+ *   blank.Split(line, line + len, [&](const char* begin, const char* end) {    *
+ *     // A token [begin, end) between the spaces and the tabs.                 *
+ *   });                                                                        *
+ *                                                                              *
+ * A CharScanner looks for 1 to kMaxChars different characters, which cannot    *
+ * be '\0'. The scanner never reads beyond |end|.                               *
+ * -----------------------------------------------------------------------------
+ */
+class CharScanner {
+ public:
+  static const int kMaxChars = 4;
+  static const size_t kBlockSize = 64;
+
+  explicit CharScanner(const char* chars);
+
+  // Return true if |c| is one of the characters.
+  bool Match(char c) const { return m_match[static_cast<uint8>(c)]; }
+
+  // Return the first of the characters in [begin, end), or |end|.
+  const char* Find(const char* begin, const char* end) const;
+
+  // Return the number of the characters in [begin, end).
+  uint64 Count(const char* begin, const char* end) const;
+
+  // Call func(token_begin, token_end) for every non-empty
+  // token of [begin, end) between the characters, in order.
+  template <typename Func>
+  void Split(const char* begin, const char* end, Func func) const {
+    const char* token = begin;
+    for (const char* block = begin; block < end; block += kBlockSize) {
+      uint64 mask = Mask(block, end);
+      while (mask != 0) {
+        const char* pos = block + __builtin_ctzll(mask);
+        if (pos > token) func(token, pos);
+        token = pos + 1;
+        mask &= mask - 1;
+      }
+    }
+    if (end > token) func(token, end);
+  }
+
+  // Return the bitmask of the 64 bytes at |block|, whose bit i is
+  // set if block[i] is one of the characters. The bytes at and
+  // beyond |end| are not read, and their bits are not set.
+  uint64 Mask(const char* block, const char* end) const;
+
+ private:
+  int m_num_chars;
+  char m_chars[kMaxChars];
+  bool m_match[256];
+};
+
+// The instruction set used by CharScanner: "avx2", "sse2" or "scalar".
+const char* CharScannerISA();
+
+#endif // F2M_BASE_CHAR_SCANNER_H_
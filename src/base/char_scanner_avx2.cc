@@ -0,0 +1,40 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file implements the AVX2 kernel of char_scanner.h. It is
+compiled with -mavx2, and only called when the CPU has AVX2.
+*/
+
+#include <immintrin.h>
+
+#include "src/base/common.h"
+
+// Compare 2 x 32 bytes with every character.
+uint64 CharMaskAVX2(const char* block, const char* chars, int num_chars) {
+  const __m256i* p = reinterpret_cast<const __m256i*>(block);
+  __m256i b0 = _mm256_loadu_si256(p);
+  __m256i b1 = _mm256_loadu_si256(p + 1);
+  __m256i m0 = _mm256_setzero_si256();
+  __m256i m1 = _mm256_setzero_si256();
+  for (int i = 0; i < num_chars; ++i) {
+    __m256i c = _mm256_set1_epi8(chars[i]);
+    m0 = _mm256_or_si256(m0, _mm256_cmpeq_epi8(b0, c));
+    m1 = _mm256_or_si256(m1, _mm256_cmpeq_epi8(b1, c));
+  }
+  uint32 low = _mm256_movemask_epi8(m0);
+  uint32 high = _mm256_movemask_epi8(m1);
+  return static_cast<uint64>(low) | static_cast<uint64>(high) << 32;
+}
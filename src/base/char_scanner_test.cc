@@ -0,0 +1,124 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file tests char_scanner.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/base/char_scanner.h"
+#include "src/base/logging.h"
+
+using std::string;
+using std::vector;
+
+typedef std::pair<const char*, const char*> Token;
+
+// A random text of letters, delimiters and newlines.
+string MakeText(size_t size) {
+  const char kAlphabet[] = "abc01\t :\n";
+  string text(size, 'a');
+  for (size_t i = 0; i < size; ++i) {
+    text[i] = kAlphabet[rand() % (sizeof(kAlphabet) - 1)];
+  }
+  return text;
+}
+
+vector<Token> SplitBytes(const char* begin, const char* end,
+                         const CharScanner& scanner) {
+  vector<Token> tokens;
+  const char* token = begin;
+  for (const char* p = begin; p < end; ++p) {
+    if (scanner.Match(*p)) {
+      if (p > token) tokens.push_back(Token(token, p));
+      token = p + 1;
+    }
+  }
+  if (end > token) tokens.push_back(Token(token, end));
+  return tokens;
+}
+
+TEST(CharScannerTest, SameAsBytes) {
+  LOG(INFO) << "CharScanner uses " << CharScannerISA();
+  const char* kChars[] = { "\n", " \t", " \t:", "\t :\n" };
+  string text = MakeText(1000);
+  for (int c = 0; c < 4; ++c) {
+    CharScanner scanner(kChars[c]);
+    // Every alignment and every length around the blocks.
+    for (size_t begin = 0; begin < 70; ++begin) {
+      for (size_t end = begin; end < text.size(); end += 7) {
+        const char* b = text.data() + begin;
+        const char* e = text.data() + end;
+        const char* found = b;
+        uint64 count = 0;
+        while (found < e && !scanner.Match(*found)) ++found;
+        for (const char* p = b; p < e; ++p) {
+          if (scanner.Match(*p)) count++;
+        }
+        EXPECT_EQ(scanner.Find(b, e), found);
+        EXPECT_EQ(scanner.Count(b, e), count);
+        vector<Token> tokens;
+        scanner.Split(b, e, [&](const char* token, const char* token_end) {
+          tokens.push_back(Token(token, token_end));
+        });
+        EXPECT_EQ(tokens, SplitBytes(b, e, scanner));
+      }
+    }
+  }
+}
+
+TEST(CharScannerTest, Split) {
+  CharScanner scanner(" \t");
+  string line = "1  3:0.5\t\t10:1 ";
+  vector<string> tokens;
+  scanner.Split(line.data(), line.data() + line.size(),
+                [&](const char* begin, const char* end) {
+    tokens.push_back(string(begin, end));
+  });
+  ASSERT_EQ(tokens.size(), 3);
+  EXPECT_EQ(tokens[0], "1");
+  EXPECT_EQ(tokens[1], "3:0.5");
+  EXPECT_EQ(tokens[2], "10:1");
+  EXPECT_TRUE(scanner.Match('\t'));
+  EXPECT_FALSE(scanner.Match(':'));
+}
+
+TEST(CharScannerTest, NoReadBeyondEnd) {
+  // The text ends right before a page we cannot read.
+  size_t page = sysconf(_SC_PAGESIZE);
+  char* buf = static_cast<char*>(mmap(NULL, 2 * page,
+                                      PROT_READ | PROT_WRITE,
+                                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  ASSERT_NE(buf, MAP_FAILED);
+  ASSERT_EQ(mprotect(buf + page, page, PROT_NONE), 0);
+  memset(buf, 'a', page);
+  CharScanner scanner("\n");
+  for (size_t size = 0; size < 130; ++size) {
+    const char* begin = buf + page - size;
+    EXPECT_EQ(scanner.Find(begin, buf + page), buf + page);
+    EXPECT_EQ(scanner.Count(begin, buf + page), 0);
+  }
+  munmap(buf, 2 * page);
+}
@@ -0,0 +1,127 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file implements fast_math.h with SSE2, and dispatches
+to the AVX2 kernels in fast_math_avx2.cc when the CPU has AVX2.
+*/
+
+#include "src/base/fast_math.h"
+
+#include "src/base/fast_math_kernel.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+#if defined(__SSE2__)
+
+// SSE2 operations on 4 floats.
+struct SSE2Ops {
+  typedef __m128 F;
+  typedef __m128 M;
+  static const size_t kWidth = 4;
+  static F Load(const float* p) { return _mm_loadu_ps(p); }
+  static void Store(float* p, F x) { _mm_storeu_ps(p, x); }
+  static F Set1(float x) { return _mm_set1_ps(x); }
+  static F Add(F a, F b) { return _mm_add_ps(a, b); }
+  static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+  static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+  static F Div(F a, F b) { return _mm_div_ps(a, b); }
+  static F Min(F a, F b) { return _mm_min_ps(a, b); }
+  static F Max(F a, F b) { return _mm_max_ps(a, b); }
+  static F Abs(F a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+  static M Less(F a, F b) { return _mm_cmplt_ps(a, b); }
+  static M Equal(F a, F b) { return _mm_cmpeq_ps(a, b); }
+  static F Select(M mask, F a, F b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+  }
+  static F Round(F a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+  static F Pow2(F n) {
+    __m128i e = _mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127));
+    return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+  }
+  static F Frexp(F x, F* e) {
+    __m128i bits = _mm_castps_si128(x);
+    *e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23),
+                                       _mm_set1_epi32(126)));
+    bits = _mm_and_si128(bits, _mm_set1_epi32(0x807FFFFF));
+    bits = _mm_or_si128(bits, _mm_set1_epi32(0x3F000000));
+    return _mm_castsi128_ps(bits);
+  }
+};
+
+typedef SSE2Ops DefaultOps;
+
+#else
+
+typedef ScalarOps DefaultOps;
+
+#endif
+
+#if defined(F2M_USE_AVX2)
+bool HasAVX2() { return __builtin_cpu_supports("avx2"); }
+#else
+bool HasAVX2() { return false; }
+#endif
+
+// Check the CPU once.
+const bool kUseAVX2 = HasAVX2();
+
+template <class Kernel>
+void Apply(const float* in, float* out, size_t size) {
+  size_t done = ApplyKernel<DefaultOps, Kernel>(in, out, size);
+  ApplyKernel<ScalarOps, Kernel>(in + done, out + done, size - done);
+}
+
+} // namespace
+
+// Defined in fast_math_avx2.cc.
+#if defined(F2M_USE_AVX2)
+void FastSigmoidAVX2(const float* in, float* out, size_t size);
+void FastLog1pExpAVX2(const float* in, float* out, size_t size);
+#endif
+
+void FastSigmoid(const float* in, float* out, size_t size) {
+#if defined(F2M_USE_AVX2)
+  if (kUseAVX2) {
+    FastSigmoidAVX2(in, out, size);
+    return;
+  }
+#endif
+  Apply<SigmoidKernel>(in, out, size);
+}
+
+void FastLog1pExp(const float* in, float* out, size_t size) {
+#if defined(F2M_USE_AVX2)
+  if (kUseAVX2) {
+    FastLog1pExpAVX2(in, out, size);
+    return;
+  }
+#endif
+  Apply<Log1pExpKernel>(in, out, size);
+}
+
+const char* FastMathISA() {
+  if (kUseAVX2) return "avx2";
+#if defined(__SSE2__)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
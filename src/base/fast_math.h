@@ -0,0 +1,48 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file defines vectorized sigmoid and log(1 + exp(x))
+kernels for the loss functions.
+*/
+
+#ifndef F2M_BASE_FAST_MATH_H_
+#define F2M_BASE_FAST_MATH_H_
+
+#include <stddef.h>
+
+/* -----------------------------------------------------------------------------
+ * Computing exp() and log() with libm for every row is slow once the dot       *
+ * products are fast. Instead, the loss functions compute the margins of a      *
+ * whole batch first, and then transform them with a single call:               *
+ *                                                                              *
+ *   FastSigmoid(margin, prob, size);   // prob[i] = 1 / (1 + exp(-margin[i]))  *
+ *   FastLog1pExp(margin, loss, size);  // loss[i] = log(1 + exp(margin[i]))    *
+ *                                                                              *
+ * The kernels use polynomial approximations of exp() and log() on 8 floats     *
+ * at a time with AVX2 (when the CPU supports it) or 4 floats at a time with    *
+ * SSE2. The relative error of FastSigmoid is below 1e-6, and so is the         *
+ * relative error of FastLog1pExp. Both functions never overflow, and |in|      *
+ * can be the same array as |out|.                                              *
+ * -----------------------------------------------------------------------------
+ */
+void FastSigmoid(const float* in, float* out, size_t size);
+void FastLog1pExp(const float* in, float* out, size_t size);
+
+// The instruction set used by the kernels: "avx2", "sse2" or "scalar".
+const char* FastMathISA();
+
+#endif // F2M_BASE_FAST_MATH_H_
@@ -0,0 +1,79 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file implements the AVX2 kernels of fast_math.h. It is
+compiled with -mavx2, and only called when the CPU has AVX2.
+*/
+
+#include <immintrin.h>
+
+#include "src/base/fast_math_kernel.h"
+
+namespace {
+
+// AVX2 operations on 8 floats.
+struct AVX2Ops {
+  typedef __m256 F;
+  typedef __m256 M;
+  static const size_t kWidth = 8;
+  static F Load(const float* p) { return _mm256_loadu_ps(p); }
+  static void Store(float* p, F x) { _mm256_storeu_ps(p, x); }
+  static F Set1(float x) { return _mm256_set1_ps(x); }
+  static F Add(F a, F b) { return _mm256_add_ps(a, b); }
+  static F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+  static F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+  static F Div(F a, F b) { return _mm256_div_ps(a, b); }
+  static F Min(F a, F b) { return _mm256_min_ps(a, b); }
+  static F Max(F a, F b) { return _mm256_max_ps(a, b); }
+  static F Abs(F a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+  static M Less(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static M Equal(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+  static F Select(M mask, F a, F b) { return _mm256_blendv_ps(b, a, mask); }
+  static F Round(F a) {
+    return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT |
+                              _MM_FROUND_NO_EXC);
+  }
+  static F Pow2(F n) {
+    __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n),
+                                 _mm256_set1_epi32(127));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+  }
+  static F Frexp(F x, F* e) {
+    __m256i bits = _mm256_castps_si256(x);
+    *e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23),
+                                             _mm256_set1_epi32(126)));
+    bits = _mm256_and_si256(bits, _mm256_set1_epi32(0x807FFFFF));
+    bits = _mm256_or_si256(bits, _mm256_set1_epi32(0x3F000000));
+    return _mm256_castsi256_ps(bits);
+  }
+};
+
+template <class Kernel>
+void Apply(const float* in, float* out, size_t size) {
+  size_t done = ApplyKernel<AVX2Ops, Kernel>(in, out, size);
+  ApplyKernel<ScalarOps, Kernel>(in + done, out + done, size - done);
+}
+
+} // namespace
+
+void FastSigmoidAVX2(const float* in, float* out, size_t size) {
+  Apply<SigmoidKernel>(in, out, size);
+}
+
+void FastLog1pExpAVX2(const float* in, float* out, size_t size) {
+  Apply<Log1pExpKernel>(in, out, size);
+}
@@ -0,0 +1,77 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file compares the throughput of fast_math.h with libm.
+
+Usage: fast_math_benchmark [size] [repeat]
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <cmath>
+#include <vector>
+
+#include "src/base/fast_math.h"
+#include "src/base/timer.h"
+
+using std::vector;
+
+// Return nanoseconds per element.
+template <typename Func>
+double Measure(Func func, size_t size, int repeat) {
+  func();  // warm up
+  Timer timer;
+  for (int i = 0; i < repeat; ++i) {
+    func();
+  }
+  return timer.Elapsed() * 1e9 / (static_cast<double>(size) * repeat);
+}
+
+int main(int argc, char* argv[]) {
+  size_t size = argc > 1 ? atol(argv[1]) : 1 << 16;
+  int repeat = argc > 2 ? atoi(argv[2]) : 1000;
+  vector<float> in(size), out(size);
+  for (size_t i = 0; i < size; ++i) {
+    in[i] = (rand() / (float) RAND_MAX - 0.5f) * 40.0f;
+  }
+  float* x = in.data();
+  float* y = out.data();
+  double libm_sigmoid = Measure([&]() {
+    for (size_t i = 0; i < size; ++i) {
+      y[i] = 1.0f / (1.0f + expf(-x[i]));
+    }
+  }, size, repeat);
+  double fast_sigmoid = Measure([&]() {
+    FastSigmoid(x, y, size);
+  }, size, repeat);
+  double libm_log1pexp = Measure([&]() {
+    for (size_t i = 0; i < size; ++i) {
+      y[i] = log1pf(expf(x[i]));
+    }
+  }, size, repeat);
+  double fast_log1pexp = Measure([&]() {
+    FastLog1pExp(x, y, size);
+  }, size, repeat);
+  printf("size = %zu, repeat = %d, isa = %s\n", size, repeat, FastMathISA());
+  printf("%-10s %12s %12s %10s\n", "kernel", "libm ns/elem",
+         "fast ns/elem", "speedup");
+  printf("%-10s %12.3f %12.3f %9.2fx\n", "sigmoid",
+         libm_sigmoid, fast_sigmoid, libm_sigmoid / fast_sigmoid);
+  printf("%-10s %12.3f %12.3f %9.2fx\n", "log1pexp",
+         libm_log1pexp, fast_log1pexp, libm_log1pexp / fast_log1pexp);
+  return 0;
+}
@@ -0,0 +1,175 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file implements the kernels of fast_math.h on top of a small
+set of vector operations, so that the same code serves the scalar,
+SSE2 and AVX2 builds. It is included only by the fast_math*.cc files,
+and everything here has internal linkage, because each of these files
+is compiled for a different instruction set.
+*/
+
+#ifndef F2M_BASE_FAST_MATH_KERNEL_H_
+#define F2M_BASE_FAST_MATH_KERNEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+
+namespace {
+
+// Cephes-style constants of expf() and logf().
+const float kExpHigh = 88.3762626647949f;
+const float kExpLow = -87.3365447504019f;
+const float kLog2e = 1.44269504088896341f;
+const float kLn2Hi = 0.693359375f;
+const float kLn2Lo = -2.12194440e-4f;
+const float kSqrtHalf = 0.707106781186547524f;
+
+// Scalar operations. They are used for the tail of an array
+// and on machines without SSE2.
+struct ScalarOps {
+  typedef float F;
+  typedef bool M;
+  static const size_t kWidth = 1;
+  static F Load(const float* p) { return *p; }
+  static void Store(float* p, F x) { *p = x; }
+  static F Set1(float x) { return x; }
+  static F Add(F a, F b) { return a + b; }
+  static F Sub(F a, F b) { return a - b; }
+  static F Mul(F a, F b) { return a * b; }
+  static F Div(F a, F b) { return a / b; }
+  static F Min(F a, F b) { return a < b ? a : b; }
+  static F Max(F a, F b) { return a > b ? a : b; }
+  static F Abs(F a) { return std::fabs(a); }
+  static M Less(F a, F b) { return a < b; }
+  static M Equal(F a, F b) { return a == b; }
+  static F Select(M mask, F a, F b) { return mask ? a : b; }
+  static F Round(F a) { return std::nearbyint(a); }
+  // Return 2^n for an integral n in [-126, 127].
+  static F Pow2(F n) {
+    uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(n) + 127) << 23;
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+  }
+  // Split a positive normal x into m * 2^e, where m is in [0.5, 1).
+  static F Frexp(F x, F* e) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    *e = static_cast<float>(static_cast<int32_t>(bits >> 23) - 126);
+    bits = (bits & 0x807FFFFF) | 0x3F000000;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+  }
+};
+
+// exp(x), clamped to the range of normal floats.
+template <class Ops>
+inline typename Ops::F Exp(typename Ops::F x) {
+  typedef typename Ops::F F;
+  x = Ops::Min(Ops::Max(x, Ops::Set1(kExpLow)), Ops::Set1(kExpHigh));
+  // x = n * ln2 + r, where |r| <= ln2 / 2.
+  F n = Ops::Round(Ops::Mul(x, Ops::Set1(kLog2e)));
+  F r = Ops::Sub(x, Ops::Mul(n, Ops::Set1(kLn2Hi)));
+  r = Ops::Sub(r, Ops::Mul(n, Ops::Set1(kLn2Lo)));
+  F p = Ops::Set1(1.9875691500E-4f);
+  p = Ops::Add(Ops::Mul(p, r), Ops::Set1(1.3981999507E-3f));
+  p = Ops::Add(Ops::Mul(p, r), Ops::Set1(8.3334519073E-3f));
+  p = Ops::Add(Ops::Mul(p, r), Ops::Set1(4.1665795894E-2f));
+  p = Ops::Add(Ops::Mul(p, r), Ops::Set1(1.6666665459E-1f));
+  p = Ops::Add(Ops::Mul(p, r), Ops::Set1(5.0000001201E-1f));
+  p = Ops::Add(Ops::Mul(Ops::Mul(p, r), r), r);
+  p = Ops::Add(p, Ops::Set1(1.0f));
+  return Ops::Mul(p, Ops::Pow2(n));
+}
+
+// log(x) for a positive normal x.
+template <class Ops>
+inline typename Ops::F Log(typename Ops::F x) {
+  typedef typename Ops::F F;
+  typedef typename Ops::M M;
+  F e;
+  F m = Ops::Frexp(x, &e);
+  // Move m into [sqrt(0.5), sqrt(2)), and subtract 1.
+  M small = Ops::Less(m, Ops::Set1(kSqrtHalf));
+  e = Ops::Sub(e, Ops::Select(small, Ops::Set1(1.0f), Ops::Set1(0.0f)));
+  m = Ops::Add(m, Ops::Select(small, m, Ops::Set1(0.0f)));
+  m = Ops::Sub(m, Ops::Set1(1.0f));
+  F z = Ops::Mul(m, m);
+  F p = Ops::Set1(7.0376836292E-2f);
+  p = Ops::Add(Ops::Mul(p, m), Ops::Set1(-1.1514610310E-1f));
+  p = Ops::Add(Ops::Mul(p, m), Ops::Set1(1.1676998740E-1f));
+  p = Ops::Add(Ops::Mul(p, m), Ops::Set1(-1.2420140846E-1f));
+  p = Ops::Add(Ops::Mul(p, m), Ops::Set1(1.4249322787E-1f));
+  p = Ops::Add(Ops::Mul(p, m), Ops::Set1(-1.6668057665E-1f));
+  p = Ops::Add(Ops::Mul(p, m), Ops::Set1(2.0000714765E-1f));
+  p = Ops::Add(Ops::Mul(p, m), Ops::Set1(-2.4999993993E-1f));
+  p = Ops::Add(Ops::Mul(p, m), Ops::Set1(3.3333331174E-1f));
+  F y = Ops::Mul(Ops::Mul(p, m), z);
+  y = Ops::Add(y, Ops::Mul(e, Ops::Set1(kLn2Lo)));
+  y = Ops::Sub(y, Ops::Mul(z, Ops::Set1(0.5f)));
+  return Ops::Add(Ops::Add(m, y), Ops::Mul(e, Ops::Set1(kLn2Hi)));
+}
+
+// 1 / (1 + exp(-x)), computed from exp(-|x|) so it never overflows.
+template <class Ops>
+inline typename Ops::F Sigmoid(typename Ops::F x) {
+  typedef typename Ops::F F;
+  F e = Exp<Ops>(Ops::Sub(Ops::Set1(0.0f), Ops::Abs(x)));
+  F s = Ops::Div(Ops::Set1(1.0f), Ops::Add(Ops::Set1(1.0f), e));
+  return Ops::Select(Ops::Less(x, Ops::Set1(0.0f)), Ops::Mul(e, s), s);
+}
+
+// log(1 + exp(x)) = max(x, 0) + log(1 + exp(-|x|)). We compute
+// log(1 + t) as log(u) * t / (u - 1), where u = 1 + t, which stays
+// accurate when t is tiny.
+template <class Ops>
+inline typename Ops::F Log1pExp(typename Ops::F x) {
+  typedef typename Ops::F F;
+  F t = Exp<Ops>(Ops::Sub(Ops::Set1(0.0f), Ops::Abs(x)));
+  F u = Ops::Add(Ops::Set1(1.0f), t);
+  F d = Ops::Sub(u, Ops::Set1(1.0f));
+  F log1p = Ops::Div(Ops::Mul(Log<Ops>(u), t), d);
+  log1p = Ops::Select(Ops::Equal(d, Ops::Set1(0.0f)), t, log1p);
+  return Ops::Add(Ops::Max(x, Ops::Set1(0.0f)), log1p);
+}
+
+struct SigmoidKernel {
+  template <class Ops>
+  static typename Ops::F Eval(typename Ops::F x) { return Sigmoid<Ops>(x); }
+};
+
+struct Log1pExpKernel {
+  template <class Ops>
+  static typename Ops::F Eval(typename Ops::F x) { return Log1pExp<Ops>(x); }
+};
+
+// Apply the kernel to every full vector of the array, and
+// return the number of elements we have processed.
+template <class Ops, class Kernel>
+inline size_t ApplyKernel(const float* in, float* out, size_t size) {
+  size_t i = 0;
+  for (; i + Ops::kWidth <= size; i += Ops::kWidth) {
+    Ops::Store(out + i, Kernel::template Eval<Ops>(Ops::Load(in + i)));
+  }
+  return i;
+}
+
+} // namespace
+
+#endif // F2M_BASE_FAST_MATH_KERNEL_H_
@@ -0,0 +1,110 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file tests fast_math.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <vector>
+
+#include "src/base/fast_math.h"
+#include "src/base/logging.h"
+
+using std::vector;
+
+const double kMaxRelativeError = 1e-6;
+
+double Sigmoid(double x) {
+  return 1.0 / (1.0 + exp(-x));
+}
+
+double Log1pExp(double x) {
+  return x > 0 ? x + log1p(exp(-x)) : log1p(exp(x));
+}
+
+// Inputs from -100 to 100, and some special values.
+vector<float> MakeInput() {
+  vector<float> in;
+  for (int i = -1000000; i <= 1000000; ++i) {
+    in.push_back(i * 1e-4f);
+  }
+  float special[] = { 0.0f, -0.0f, 1e-30f, -1e-30f, 1e-8f, -1e-8f,
+                      87.0f, -87.0f, 89.0f, -89.0f, 1e10f, -1e10f };
+  for (size_t i = 0; i < sizeof(special) / sizeof(float); ++i) {
+    in.push_back(special[i]);
+  }
+  return in;
+}
+
+TEST(FastMath, SigmoidAccuracy) {
+  vector<float> in = MakeInput();
+  vector<float> out(in.size());
+  FastSigmoid(in.data(), out.data(), in.size());
+  double max_error = 0;
+  for (size_t i = 0; i < in.size(); ++i) {
+    double expected = Sigmoid(in[i]);
+    // The result underflows to 0 below -87.
+    if (expected < 1e-37) {
+      EXPECT_LT(out[i], 1e-37);
+      continue;
+    }
+    double error = fabs(out[i] - expected) / expected;
+    if (error > max_error) max_error = error;
+  }
+  LOG(INFO) << FastMathISA() << " sigmoid max relative error: " << max_error;
+  EXPECT_LT(max_error, kMaxRelativeError);
+}
+
+TEST(FastMath, Log1pExpAccuracy) {
+  vector<float> in = MakeInput();
+  vector<float> out(in.size());
+  FastLog1pExp(in.data(), out.data(), in.size());
+  double max_error = 0;
+  for (size_t i = 0; i < in.size(); ++i) {
+    double expected = Log1pExp(in[i]);
+    if (expected < 1e-37) {
+      EXPECT_LT(out[i], 1e-37);
+      continue;
+    }
+    double error = fabs(out[i] - expected) / expected;
+    if (error > max_error) max_error = error;
+  }
+  LOG(INFO) << FastMathISA() << " log1pexp max relative error: " << max_error;
+  EXPECT_LT(max_error, kMaxRelativeError);
+}
+
+TEST(FastMath, TailAndInPlace) {
+  // Every size up to 2 vectors, so the scalar tail is tested.
+  for (size_t size = 0; size <= 17; ++size) {
+    vector<float> in(size);
+    for (size_t i = 0; i < size; ++i) {
+      in[i] = (i * 1.7f) - 10.0f;
+    }
+    vector<float> out(in);
+    FastSigmoid(out.data(), out.data(), size);
+    for (size_t i = 0; i < size; ++i) {
+      EXPECT_NEAR(out[i], Sigmoid(in[i]), 1e-6);
+    }
+    out = in;
+    FastLog1pExp(out.data(), out.data(), size);
+    for (size_t i = 0; i < size; ++i) {
+      EXPECT_NEAR(out[i], Log1pExp(in[i]), 1e-5);
+    }
+  }
+}
@@ -0,0 +1,198 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file is the implementation of huge_page.h.
+*/
+
+#include "src/base/huge_page.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+const size_t kAlignment = 64;
+const size_t kHugePageSize = 2UL << 20;
+const size_t kGiantPageSize = 1UL << 30;
+
+std::atomic<int> g_policy(HUGE_PAGE_TRANSPARENT);
+
+// A large array is mapped by mmap(), and we remember how it
+// is mapped, so that we can unmap it and report its backing.
+struct Mapping {
+  char* base;       // the address returned by mmap().
+  size_t length;    // the length passed to mmap().
+  PageBacking backing;
+};
+
+std::mutex& MappingLock() {
+  static std::mutex* lock = new std::mutex;
+  return *lock;
+}
+
+std::map<const void*, Mapping>& Mappings() {
+  static std::map<const void*, Mapping>* mappings =
+    new std::map<const void*, Mapping>;
+  return *mappings;
+}
+
+size_t RoundUp(size_t size, size_t unit) {
+  return (size + unit - 1) / unit * unit;
+}
+
+#if defined(__linux__)
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+// Return false if the kernel never backs memory with
+// transparent huge pages.
+bool TransparentHugePagesEnabled() {
+  static const bool enabled = [] {
+    std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string mode;
+    std::getline(file, mode);
+    return file.good() && mode.find("[never]") == std::string::npos;
+  }();
+  return enabled;
+}
+
+// Map explicit huge pages of 2^|page_shift| bytes.
+bool MapHugePages(size_t size, int page_shift, Mapping* mapping) {
+  size_t length = RoundUp(size, 1UL << page_shift);
+  void* ptr = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                   (page_shift << MAP_HUGE_SHIFT), -1, 0);
+  if (ptr == MAP_FAILED) return false;
+  mapping->base = static_cast<char*>(ptr);
+  mapping->length = length;
+  return true;
+}
+
+// Map 4 KB pages aligned to 2 MB, so that the kernel can
+// back the whole range with transparent huge pages.
+void MapPages(size_t size, bool transparent, Mapping* mapping) {
+  size_t length = RoundUp(size, kHugePageSize) + kHugePageSize;
+  void* ptr = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ptr == MAP_FAILED) {
+    LOG(FATAL) << "Cannot allocate " << size << " bytes.";
+  }
+  char* base = static_cast<char*>(ptr);
+  char* aligned = reinterpret_cast<char*>(
+    RoundUp(reinterpret_cast<uintptr_t>(base), kHugePageSize));
+  // Return the unaligned head and tail to the system.
+  if (aligned != base) {
+    munmap(base, aligned - base);
+  }
+  size_t tail = (base + length) - (aligned + length - kHugePageSize);
+  if (tail > 0) {
+    munmap(aligned + length - kHugePageSize, tail);
+  }
+  mapping->base = aligned;
+  mapping->length = length - kHugePageSize;
+  mapping->backing = PAGE_REGULAR;
+  if (transparent && TransparentHugePagesEnabled() &&
+      madvise(aligned, mapping->length, MADV_HUGEPAGE) == 0) {
+    mapping->backing = PAGE_TRANSPARENT_HUGE;
+  }
+}
+
+#endif  // __linux__
+
+}  // namespace
+
+void SetHugePagePolicy(HugePagePolicy policy) {
+  g_policy.store(policy);
+}
+
+HugePagePolicy GetHugePagePolicy() {
+  return static_cast<HugePagePolicy>(g_policy.load());
+}
+
+void* AllocateHugePages(size_t size) {
+#if defined(__linux__)
+  if (size >= kHugePageSize) {
+    HugePagePolicy policy = GetHugePagePolicy();
+    Mapping mapping;
+    if (policy == HUGE_PAGE_1GB && MapHugePages(size, 30, &mapping)) {
+      mapping.backing = PAGE_HUGE_1GB;
+    } else if (policy >= HUGE_PAGE_2MB && MapHugePages(size, 21, &mapping)) {
+      mapping.backing = PAGE_HUGE_2MB;
+    } else {
+      MapPages(size, policy != HUGE_PAGE_NONE, &mapping);
+    }
+    if (policy >= HUGE_PAGE_2MB && mapping.backing < PAGE_HUGE_2MB) {
+      LOG(WARNING) << "No free huge pages for " << (size >> 20)
+                   << " MB, fall back to "
+                   << PageBackingName(mapping.backing) << ".";
+    }
+    std::lock_guard<std::mutex> guard(MappingLock());
+    Mappings()[mapping.base] = mapping;
+    return mapping.base;
+  }
+#endif
+  void* ptr = NULL;
+  if (posix_memalign(&ptr, kAlignment, size > 0 ? size : 1) != 0) {
+    LOG(FATAL) << "Cannot allocate " << size << " bytes.";
+  }
+  return ptr;
+}
+
+void FreeHugePages(void* ptr, size_t size) {
+  if (ptr == NULL) return;
+#if defined(__linux__)
+  if (size >= kHugePageSize) {
+    Mapping mapping;
+    {
+      std::lock_guard<std::mutex> guard(MappingLock());
+      std::map<const void*, Mapping>::iterator it = Mappings().find(ptr);
+      CHECK(it != Mappings().end());
+      mapping = it->second;
+      Mappings().erase(it);
+    }
+    munmap(mapping.base, mapping.length);
+    return;
+  }
+#endif
+  free(ptr);
+}
+
+PageBacking PageBackingOf(const void* ptr) {
+  std::lock_guard<std::mutex> guard(MappingLock());
+  std::map<const void*, Mapping>::const_iterator it = Mappings().find(ptr);
+  return it == Mappings().end() ? PAGE_REGULAR : it->second.backing;
+}
+
+const char* PageBackingName(PageBacking backing) {
+  switch (backing) {
+    case PAGE_TRANSPARENT_HUGE: return "transparent huge pages";
+    case PAGE_HUGE_2MB: return "2 MB huge pages";
+    case PAGE_HUGE_1GB: return "1 GB huge pages";
+    default: return "4 KB pages";
+  }
+}
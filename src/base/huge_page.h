@@ -0,0 +1,111 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file defines HugePageAllocator, which allocates the large
+arrays of the model on huge pages.
+*/
+
+#ifndef F2M_BASE_HUGE_PAGE_H_
+#define F2M_BASE_HUGE_PAGE_H_
+
+#include <stddef.h>
+
+#include <new>
+
+#include "src/base/common.h"
+
+/* -----------------------------------------------------------------------------
+ * The parameters of a large FFM model take many GB and are read by random      *
+ * feature indices, so nearly every access misses the data TLB when the array   *
+ * is mapped with 4 KB pages. An array mapped with 2 MB or 1 GB pages needs far *
+ * fewer TLB entries. We allocate such arrays by:                               *
+ *                                                                              *
+ *   std::vector<real_t, HugePageAllocator<real_t> > params(size);              *
+ *   LOG(INFO) << PageBackingName(PageBackingOf(params.data()));                *
+ *                                                                              *
+ * Arrays smaller than 2 MB come from the heap. A larger array is mapped as     *
+ * the policy asks, and falls back step by step when the system does not have   *
+ * the pages: 1 GB pages -> 2 MB pages -> transparent huge pages -> 4 KB pages. *
+ * Explicit huge pages must be reserved by the administrator, e.g.              *
+ *                                                                              *
+ *   echo 1024 > /proc/sys/vm/nr_hugepages                                      *
+ *                                                                              *
+ * while transparent huge pages only need the kernel to run in the "always"     *
+ * or the "madvise" mode, so HUGE_PAGE_TRANSPARENT is the default policy.       *
+ * -----------------------------------------------------------------------------
+ */
+
+// How we ask for the memory of a large array.
+enum HugePagePolicy {
+  HUGE_PAGE_NONE = 0,       // 4 KB pages.
+  HUGE_PAGE_TRANSPARENT,    // madvise(MADV_HUGEPAGE).
+  HUGE_PAGE_2MB,            // explicit 2 MB pages.
+  HUGE_PAGE_1GB             // explicit 1 GB pages.
+};
+
+// How the memory of an array is actually backed.
+enum PageBacking {
+  PAGE_REGULAR = 0,
+  PAGE_TRANSPARENT_HUGE,
+  PAGE_HUGE_2MB,
+  PAGE_HUGE_1GB
+};
+
+// Set the policy for the arrays allocated later.
+void SetHugePagePolicy(HugePagePolicy policy);
+HugePagePolicy GetHugePagePolicy();
+
+// Allocate |size| bytes aligned to at least 64 bytes.
+// Abort if the memory cannot be allocated.
+void* AllocateHugePages(size_t size);
+
+// Free the memory returned by AllocateHugePages(size).
+void FreeHugePages(void* ptr, size_t size);
+
+// Return the backing of the array that begins at |ptr|.
+PageBacking PageBackingOf(const void* ptr);
+
+const char* PageBackingName(PageBacking backing);
+
+// An allocator for std::vector.
+template <typename T>
+struct HugePageAllocator {
+  typedef T value_type;
+
+  HugePageAllocator() {}
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U>&) {}
+
+  T* allocate(size_t num) {
+    return static_cast<T*>(AllocateHugePages(num * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, size_t num) {
+    FreeHugePages(ptr, num * sizeof(T));
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<U>&) {
+  return false;
+}
+
+#endif // F2M_BASE_HUGE_PAGE_H_
@@ -0,0 +1,79 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file measures random gathers from a large array backed by
+different kinds of pages, which is how the losses read the model.
+
+Usage: huge_page_benchmark [size_in_MB] [num_gathers]
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <random>
+#include <vector>
+
+#include "src/base/huge_page.h"
+#include "src/base/perf_counter.h"
+#include "src/base/timer.h"
+
+using std::vector;
+
+typedef vector<float, HugePageAllocator<float> > Array;
+
+int main(int argc, char* argv[]) {
+  size_t size_mb = argc > 1 ? atol(argv[1]) : 1024;
+  size_t num_gathers = argc > 2 ? atol(argv[2]) : 1 << 24;
+  size_t size = (size_mb << 20) / sizeof(float);
+  vector<uint32> index(num_gathers);
+  std::mt19937_64 rng(2016);
+  for (size_t i = 0; i < num_gathers; ++i) {
+    index[i] = rng() % size;
+  }
+  const HugePagePolicy kPolicies[] = {
+    HUGE_PAGE_NONE, HUGE_PAGE_TRANSPARENT, HUGE_PAGE_2MB, HUGE_PAGE_1GB
+  };
+  const char* kNames[] = { "none", "transparent", "2mb", "1gb" };
+  printf("size = %zu MB, gathers = %zu\n", size_mb, num_gathers);
+  printf("%-12s %-24s %10s %14s\n", "policy", "backing",
+         "ns/gather", "dTLB/gather");
+  PerfCounterGroup counters;
+  for (int p = 0; p < 4; ++p) {
+    SetHugePagePolicy(kPolicies[p]);
+    Array array(size, 1.0f);
+    PageBacking backing = PageBackingOf(array.data());
+    uint64 begin[PERF_NUM_EVENTS], end[PERF_NUM_EVENTS];
+    float sum = 0;
+    counters.Read(begin);
+    Timer timer;
+    for (size_t i = 0; i < num_gathers; ++i) {
+      sum += array[index[i]];
+    }
+    double seconds = timer.Elapsed();
+    counters.Read(end);
+    char tlb[32] = "n/a";
+    if (counters.IsEventAvailable(PERF_DTLB_MISSES)) {
+      snprintf(tlb, sizeof(tlb), "%.4f",
+               (end[PERF_DTLB_MISSES] - begin[PERF_DTLB_MISSES]) /
+               static_cast<double>(num_gathers));
+    }
+    printf("%-12s %-24s %10.2f %14s\n", kNames[p], PageBackingName(backing),
+           seconds * 1e9 / num_gathers, tlb);
+    // Keep the gathers from being optimized away.
+    if (sum < 0) printf("%f\n", sum);
+  }
+  return 0;
+}
@@ -0,0 +1,59 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file tests huge_page.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "src/base/huge_page.h"
+
+typedef std::vector<float, HugePageAllocator<float> > Array;
+
+TEST(HugePage, SmallArray) {
+  Array array(1000, 1.0f);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(array.data()) % 64, 0);
+  EXPECT_EQ(PageBackingOf(array.data()), PAGE_REGULAR);
+}
+
+TEST(HugePage, Fallback) {
+  const HugePagePolicy kPolicies[] = {
+    HUGE_PAGE_NONE, HUGE_PAGE_TRANSPARENT, HUGE_PAGE_2MB, HUGE_PAGE_1GB
+  };
+  for (int p = 0; p < 4; ++p) {
+    SetHugePagePolicy(kPolicies[p]);
+    EXPECT_EQ(GetHugePagePolicy(), kPolicies[p]);
+    // Not a multiple of the page size.
+    Array array((5 << 20) + 7, 1.0f);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(array.data()) % (2 << 20), 0);
+    PageBacking backing = PageBackingOf(array.data());
+    // We never get larger pages than the policy asks.
+    EXPECT_LE(static_cast<int>(backing), static_cast<int>(kPolicies[p]));
+    if (kPolicies[p] == HUGE_PAGE_NONE) {
+      EXPECT_EQ(backing, PAGE_REGULAR);
+    }
+    for (size_t i = 0; i < array.size(); ++i) {
+      ASSERT_EQ(array[i], 1.0f);
+    }
+    array.back() = 2.0f;
+    EXPECT_EQ(array.back(), 2.0f);
+  }
+  SetHugePagePolicy(HUGE_PAGE_TRANSPARENT);
+}
@@ -0,0 +1,114 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file is the implementation of numa_util.h.
+*/
+
+#include "src/base/numa_util.h"
+
+#include <stdint.h>
+#include <unistd.h>
+
+#if defined(F2M_USE_NUMA)
+#include <numa.h>
+#include <numaif.h>
+#endif
+
+#include "src/base/common.h"
+
+#if defined(F2M_USE_NUMA)
+
+namespace {
+
+// Round [ptr, ptr + size) out to whole pages.
+void PageRange(void* ptr, size_t size, void** begin, size_t* length) {
+  uintptr_t page = sysconf(_SC_PAGESIZE);
+  uintptr_t start = reinterpret_cast<uintptr_t>(ptr) & ~(page - 1);
+  uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + size + page - 1) &
+                  ~(page - 1);
+  *begin = reinterpret_cast<void*>(start);
+  *length = end - start;
+}
+
+// Apply |mode| on the nodes of |mask| to the pages of the range,
+// and move the pages that are already there.
+bool Move(void* ptr, size_t size, int mode, struct bitmask* mask) {
+  if (size == 0) return true;
+  void* begin;
+  size_t length;
+  PageRange(ptr, size, &begin, &length);
+  return mbind(begin, length, mode, mask->maskp, mask->size + 1,
+               MPOL_MF_MOVE) == 0;
+}
+
+} // namespace
+
+int NumaNodes() {
+  if (numa_available() < 0) return 1;
+  return numa_num_configured_nodes();
+}
+
+bool PinThreadToNumaNode(int node) {
+  if (numa_available() < 0) return false;
+  CHECK_GE(node, 0);
+  CHECK_LT(node, NumaNodes());
+  return numa_run_on_node(node) == 0;
+}
+
+bool NumaInterleave(void* ptr, size_t size) {
+  if (numa_available() < 0) return false;
+  return Move(ptr, size, MPOL_INTERLEAVE, numa_all_nodes_ptr);
+}
+
+bool NumaBindToNode(void* ptr, size_t size, int node) {
+  if (numa_available() < 0) return false;
+  CHECK_GE(node, 0);
+  CHECK_LT(node, NumaNodes());
+  struct bitmask* mask = numa_allocate_nodemask();
+  numa_bitmask_setbit(mask, node);
+  bool ok = Move(ptr, size, MPOL_BIND, mask);
+  numa_free_nodemask(mask);
+  return ok;
+}
+
+int NumaNodeOfAddress(const void* ptr) {
+  if (numa_available() < 0) return -1;
+  int node = -1;
+  if (get_mempolicy(&node, NULL, 0, const_cast<void*>(ptr),
+                    MPOL_F_NODE | MPOL_F_ADDR) != 0) {
+    return -1;
+  }
+  return node;
+}
+
+#else // without libnuma
+
+int NumaNodes() { return 1; }
+
+bool PinThreadToNumaNode(int node) { return false; }
+
+bool NumaInterleave(void* ptr, size_t size) { return false; }
+
+bool NumaBindToNode(void* ptr, size_t size, int node) { return false; }
+
+int NumaNodeOfAddress(const void* ptr) { return -1; }
+
+#endif
+
+int NumaNodeOfWorker(int worker_id) {
+  return worker_id % NumaNodes();
+}
@@ -0,0 +1,69 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file provides helpers to place threads and memory
+on NUMA nodes.
+*/
+
+#ifndef F2M_BASE_NUMA_UTIL_H_
+#define F2M_BASE_NUMA_UTIL_H_
+
+#include <stddef.h>
+
+/* -----------------------------------------------------------------------------
+ * On a multi-socket machine, memory is first touched by one thread and then    *
+ * lives on the node of that thread, so workers on the other sockets read it    *
+ * through the interconnect. We use these helpers to place memory explicitly:   *
+ *                                                                              *
+ *   // Worker thread i runs on node i % NumaNodes(), and loads its data        *
+ *   // shard after pinning, so the shard is first touched on that node.        *
+ *   PinThreadToNumaNode(NumaNodeOfWorker(i));                                  *
+ *   ReaderOptions options(loop = false, in_memory = true);                     *
+ *   Reader reader(shard_file[i], num_samples, LR, options);                    *
+ *                                                                              *
+ *   // Spread the shared parameters over all the nodes ...                     *
+ *   NumaInterleave(params, size);                                              *
+ *   // ... or keep a replica on every node (see model_average.h).              *
+ *   NumaBindToNode(replica_params, size, node);                                *
+ *                                                                              *
+ * The memory functions move pages that were already touched, and also set      *
+ * the policy of the pages that are touched later. When we build without        *
+ * libnuma (F2M_USE_NUMA), or the kernel does not support NUMA, NumaNodes()     *
+ * returns 1, and the other functions do nothing and return false or -1.        *
+ * -----------------------------------------------------------------------------
+ */
+
+// Return the number of NUMA nodes.
+int NumaNodes();
+
+// Return the node of worker |worker_id| when the
+// workers are spread over the nodes round-robin.
+int NumaNodeOfWorker(int worker_id);
+
+// Run the calling thread on the CPUs of |node| only.
+bool PinThreadToNumaNode(int node);
+
+// Interleave the pages of [ptr, ptr + size) over all nodes.
+bool NumaInterleave(void* ptr, size_t size);
+
+// Move the pages of [ptr, ptr + size) to |node|.
+bool NumaBindToNode(void* ptr, size_t size, int node);
+
+// Return the node of the page of |ptr|, or -1 if unknown.
+int NumaNodeOfAddress(const void* ptr);
+
+#endif // F2M_BASE_NUMA_UTIL_H_
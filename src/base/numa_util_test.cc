@@ -0,0 +1,51 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file tests numa_util.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "src/base/numa_util.h"
+
+TEST(NumaUtil, Nodes) {
+  int nodes = NumaNodes();
+  EXPECT_GE(nodes, 1);
+  for (int i = 0; i < 2 * nodes; ++i) {
+    EXPECT_EQ(NumaNodeOfWorker(i), i % nodes);
+  }
+}
+
+TEST(NumaUtil, PlaceMemory) {
+  std::vector<float> data(1 << 20, 1.0);
+  size_t size = data.size() * sizeof(float);
+  if (!NumaBindToNode(data.data(), size, NumaNodes() - 1)) {
+    // No NUMA support on this system.
+    EXPECT_EQ(NumaNodeOfAddress(data.data()), -1);
+    return;
+  }
+  EXPECT_EQ(NumaNodeOfAddress(data.data()), NumaNodes() - 1);
+  EXPECT_EQ(NumaNodeOfAddress(&data.back()), NumaNodes() - 1);
+  EXPECT_TRUE(NumaInterleave(data.data(), size));
+  EXPECT_TRUE(PinThreadToNumaNode(0));
+  // The data is still there.
+  for (size_t i = 0; i < data.size(); ++i) {
+    ASSERT_EQ(data[i], 1.0);
+  }
+}
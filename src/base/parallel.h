@@ -0,0 +1,58 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file provides simple facilities to run a task on
+multiple threads.
+*/
+
+#ifndef F2M_BASE_PARALLEL_H_
+#define F2M_BASE_PARALLEL_H_
+
+#include <thread>
+#include <vector>
+
+#include "src/base/common.h"
+
+// Return the number of hardware threads of this machine.
+inline int GetNumberOfThreads() {
+  int num = std::thread::hardware_concurrency();
+  return num > 0 ? num : 1;
+}
+
+// Split [0, total) into |num| even parts, and
+// return the beginning of the |id|-th part.
+inline uint64 SplitBegin(uint64 total, int num, int id) {
+  return total * id / num;
+}
+
+// Run func(thread_id) on |num_threads| threads and return
+// after all of them finish. The calling thread runs
+// func(0) itself, so we spawn |num_threads| - 1 threads.
+template <typename Func>
+void ParallelRun(int num_threads, Func func) {
+  CHECK_GT(num_threads, 0);
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; ++i) {
+    threads.push_back(std::thread(func, i));
+  }
+  func(0);
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+}
+
+#endif // F2M_BASE_PARALLEL_H_
@@ -0,0 +1,47 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file is the implementation of parse_number.h
+*/
+
+#include "src/base/parse_number.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+// Longer numbers are copied to a std::string.
+const size_t kMaxShortNumber = 64;
+
+const char* ParseDoubleSlow(const char* begin, const char* end,
+                            double* value) {
+  // strtod() needs a '\0' at the end.
+  size_t size = end - begin;
+  char buffer[kMaxShortNumber];
+  std::string long_number;
+  const char* number = buffer;
+  if (size < kMaxShortNumber) {
+    memcpy(buffer, begin, size);
+    buffer[size] = '\0';
+  } else {
+    long_number.assign(begin, end);
+    number = long_number.c_str();
+  }
+  char* stop = NULL;
+  *value = strtod(number, &stop);
+  return begin + (stop - number);
+}
@@ -0,0 +1,112 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file defines ParseDouble(), ParseFloat() and ParseUInt32(),
+which read the numbers of a data file.
+*/
+
+#ifndef F2M_BASE_PARSE_NUMBER_H_
+#define F2M_BASE_PARSE_NUMBER_H_
+
+#include "src/base/common.h"
+
+/* -----------------------------------------------------------------------------
+ * The labels, the values and the feature ids take most of the time of          *
+ * parsing a line. atof() and atoi() are slow for them: they are locale-aware,  *
+ * they skip the leading spaces again, they need a '\0' at the end, and         *
+ * strtod() computes every result on its exact but slow path.                   *
+ *                                                                              *
+ * These functions read a number at [begin, end), and return the position       *
+ * after the number. Most of the values in a data file are short decimals       *
+ * such as 1, -0.3651 or 0.50000, whose digits fit in a 53-bit mantissa. Then   *
+ * the result is the mantissa divided by a power of 10, and both are exact in   *
+ * a double, so the division gives the same correctly rounded result as         *
+ * strtod(). The longer decimals and the exponent forms (1e-5) go to strtod()   *
+ * instead:                                                                     *
+ *                                                                              *
+ *   float value;                                                               *
+ *   const char* pos = ParseFloat(begin, end, &value);                          *
+ *   if (pos == begin) {  // not a number                                       *
+ *     ...                                                                      *
+ *   }                                                                          *
+ *                                                                              *
+ * ParseUInt32() reads the digits of a feature id, and returns NULL if there    *
+ * is no digit or the id overflows uint32.                                      *
+ * -----------------------------------------------------------------------------
+ */
+
+// The slow path of ParseDouble().
+const char* ParseDoubleSlow(const char* begin, const char* end,
+                            double* value);
+
+inline const char* ParseDouble(const char* begin, const char* end,
+                               double* value) {
+  // 10^0 to 10^22 are exact in a double.
+  static const double kPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const char* p = begin;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  uint64 mantissa = 0;
+  int num_digits = 0;
+  int num_decimals = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p, ++num_digits) {
+    mantissa = mantissa * 10 + (*p - '0');
+  }
+  if (p < end && *p == '.') {
+    for (++p; p < end && *p >= '0' && *p <= '9'; ++p, ++num_decimals) {
+      mantissa = mantissa * 10 + (*p - '0');
+    }
+    num_digits += num_decimals;
+  }
+  // 19 digits never overflow the uint64.
+  if (num_digits == 0 || num_digits > 19 ||
+      mantissa > (static_cast<uint64>(1) << 53) ||
+      num_decimals > 22 || (p < end && (*p == 'e' || *p == 'E'))) {
+    return ParseDoubleSlow(begin, end, value);
+  }
+  double result = static_cast<double>(mantissa) / kPow10[num_decimals];
+  *value = negative ? -result : result;
+  return p;
+}
+
+inline const char* ParseFloat(const char* begin, const char* end,
+                              float* value) {
+  double result = 0;
+  const char* p = ParseDouble(begin, end, &result);
+  *value = static_cast<float>(result);
+  return p;
+}
+
+inline const char* ParseUInt32(const char* begin, const char* end,
+                               uint32* value) {
+  uint64 result = 0;
+  const char* p = begin;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+    result = result * 10 + (*p - '0');
+    if (result > UINT32_MAX) return NULL;
+  }
+  if (p == begin) return NULL;
+  *value = static_cast<uint32>(result);
+  return p;
+}
+
+#endif // F2M_BASE_PARSE_NUMBER_H_
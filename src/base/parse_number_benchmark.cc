@@ -0,0 +1,108 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file compares the throughput of parse_number.h with
+atof() and atoi().
+
+Usage: parse_number_benchmark [size] [repeat]
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "src/base/parse_number.h"
+#include "src/base/timer.h"
+
+using std::string;
+using std::vector;
+
+// Return nanoseconds per number.
+template <typename Func>
+double Measure(Func func, size_t size, int repeat) {
+  func();  // warm up
+  Timer timer;
+  for (int i = 0; i < repeat; ++i) {
+    func();
+  }
+  return timer.Elapsed() * 1e9 / (static_cast<double>(size) * repeat);
+}
+
+int main(int argc, char* argv[]) {
+  size_t size = argc > 1 ? atol(argv[1]) : 1 << 16;
+  int repeat = argc > 2 ? atoi(argv[2]) : 100;
+  // The values and the ids of a data file: "0.3651", "1", ...
+  vector<string> values(size), ids(size);
+  uint64 bytes = 0;
+  char str[64];
+  for (size_t i = 0; i < size; ++i) {
+    if (i % 4 == 0) {
+      snprintf(str, sizeof(str), "1");
+    } else {
+      snprintf(str, sizeof(str), "0.%0*d", 1 + rand() % 6, rand() % 100000);
+    }
+    values[i] = str;
+    snprintf(str, sizeof(str), "%d", rand() % 10000000);
+    ids[i] = str;
+    bytes += values[i].size() + ids[i].size();
+  }
+  volatile double sink = 0;
+  double libc_float = Measure([&]() {
+    double sum = 0;
+    for (size_t i = 0; i < size; ++i) {
+      sum += static_cast<float>(atof(values[i].c_str()));
+    }
+    sink = sum;
+  }, size, repeat);
+  double fast_float = Measure([&]() {
+    double sum = 0;
+    float value = 0;
+    for (size_t i = 0; i < size; ++i) {
+      const char* p = values[i].data();
+      ParseFloat(p, p + values[i].size(), &value);
+      sum += value;
+    }
+    sink = sum;
+  }, size, repeat);
+  double libc_int = Measure([&]() {
+    uint64 sum = 0;
+    for (size_t i = 0; i < size; ++i) {
+      sum += atoi(ids[i].c_str());
+    }
+    sink = sum;
+  }, size, repeat);
+  double fast_int = Measure([&]() {
+    uint64 sum = 0;
+    uint32 value = 0;
+    for (size_t i = 0; i < size; ++i) {
+      const char* p = ids[i].data();
+      ParseUInt32(p, p + ids[i].size(), &value);
+      sum += value;
+    }
+    sink = sum;
+  }, size, repeat);
+  printf("size = %zu, repeat = %d, %.1f bytes/number\n", size, repeat,
+         bytes / (2.0 * size));
+  printf("%-10s %12s %12s %10s\n", "number", "libc ns/num",
+         "fast ns/num", "speedup");
+  printf("%-10s %12.3f %12.3f %9.2fx\n", "float",
+         libc_float, fast_float, libc_float / fast_float);
+  printf("%-10s %12.3f %12.3f %9.2fx\n", "uint32",
+         libc_int, fast_int, libc_int / fast_int);
+  return 0;
+}
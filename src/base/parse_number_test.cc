@@ -0,0 +1,109 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file tests parse_number.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "src/base/parse_number.h"
+
+using std::string;
+
+// Parse the whole string, or return false.
+bool ParseAll(const string& str, double* value) {
+  const char* end = str.data() + str.size();
+  return ParseDouble(str.data(), end, value) == end;
+}
+
+TEST(ParseNumberTest, SameAsStrtod) {
+  const char* kNumbers[] = {
+    "0", "1", "-1", "+1", "0.5", "0.3651", "0.50000", "-0.125", "1.",
+    ".25", "123456789", "3.14159265358979", "9007199254740993",
+    "0.1234567890123456789", "1234567890123456789012", "1e-5", "-2.5E+3",
+    "0.000000000000000000000001", "1e400", "inf", "-nan"
+  };
+  for (size_t i = 0; i < sizeof(kNumbers) / sizeof(kNumbers[0]); ++i) {
+    double value = 0;
+    EXPECT_TRUE(ParseAll(kNumbers[i], &value)) << kNumbers[i];
+    double expected = strtod(kNumbers[i], NULL);
+    if (expected != expected) {
+      EXPECT_NE(value, value);
+    } else {
+      EXPECT_EQ(value, expected) << kNumbers[i];
+    }
+  }
+  // Random short decimals are the same bits as strtod().
+  char str[64];
+  for (int i = 0; i < 1000000; ++i) {
+    int digits = rand() % 10;
+    snprintf(str, sizeof(str), "%s%d.%0*d", rand() % 2 ? "-" : "",
+             rand() % 1000, digits, rand() % 1000000000);
+    double value = 0;
+    ASSERT_TRUE(ParseAll(str, &value)) << str;
+    ASSERT_EQ(value, strtod(str, NULL)) << str;
+    float float_value = 0;
+    ParseFloat(str, str + strlen(str), &float_value);
+    ASSERT_EQ(float_value, static_cast<float>(atof(str))) << str;
+  }
+}
+
+TEST(ParseNumberTest, StopAtTheEnd) {
+  string str = "0.5:3\t1";
+  double value = 0;
+  const char* begin = str.data();
+  EXPECT_EQ(ParseDouble(begin, begin + str.size(), &value), begin + 3);
+  EXPECT_EQ(value, 0.5);
+  // The bytes at and after |end| are not read.
+  EXPECT_EQ(ParseDouble(begin, begin + 2, &value), begin + 2);
+  EXPECT_EQ(value, 0);
+  // Not a number.
+  str = "-:1";
+  begin = str.data();
+  EXPECT_EQ(ParseDouble(begin, begin + str.size(), &value), begin);
+  str = "";
+  begin = str.data();
+  EXPECT_EQ(ParseDouble(begin, begin, &value), begin);
+}
+
+TEST(ParseNumberTest, UInt32) {
+  string str = "4294967295:1";
+  const char* begin = str.data();
+  const char* end = begin + str.size();
+  uint32 value = 0;
+  EXPECT_EQ(ParseUInt32(begin, end, &value), begin + 10);
+  EXPECT_EQ(value, 4294967295u);
+  EXPECT_EQ(ParseUInt32(begin, begin + 3, &value), begin + 3);
+  EXPECT_EQ(value, 429);
+  // Overflow.
+  str = "4294967296";
+  begin = str.data();
+  EXPECT_TRUE(ParseUInt32(begin, begin + str.size(), &value) == NULL);
+  str = "123456789012345678901234567890";
+  begin = str.data();
+  EXPECT_TRUE(ParseUInt32(begin, begin + str.size(), &value) == NULL);
+  // No digit.
+  str = "-1";
+  begin = str.data();
+  EXPECT_TRUE(ParseUInt32(begin, begin + str.size(), &value) == NULL);
+  EXPECT_TRUE(ParseUInt32(begin, begin, &value) == NULL);
+}
@@ -0,0 +1,145 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file is the implementation of perf_counter.h.
+*/
+
+#include "src/base/perf_counter.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include "src/base/common.h"
+
+#if defined(__linux__)
+
+namespace {
+
+// Set the type and config of an event.
+void EventConfig(PerfEvent event, struct perf_event_attr* attr) {
+  const uint64 kReadMiss = PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                           PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+  switch (event) {
+    case PERF_CYCLES:
+      attr->type = PERF_TYPE_HARDWARE;
+      attr->config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case PERF_INSTRUCTIONS:
+      attr->type = PERF_TYPE_HARDWARE;
+      attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case PERF_LLC_MISSES:
+      attr->type = PERF_TYPE_HW_CACHE;
+      attr->config = PERF_COUNT_HW_CACHE_LL | kReadMiss;
+      break;
+    default:
+      attr->type = PERF_TYPE_HW_CACHE;
+      attr->config = PERF_COUNT_HW_CACHE_DTLB | kReadMiss;
+      break;
+  }
+}
+
+int OpenEvent(PerfEvent event, int group_fd) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  EventConfig(event, &attr);
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP |
+                     PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // pid = 0 and cpu = -1: the calling thread on any CPU.
+  return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+} // namespace
+
+PerfCounterGroup::PerfCounterGroup() : m_num_opened(0) {
+  for (int i = 0; i < PERF_NUM_EVENTS; ++i) {
+    m_fd[i] = -1;
+    m_index[i] = -1;
+  }
+  // The cycles counter leads the group. Without it we have nothing.
+  m_fd[PERF_CYCLES] = OpenEvent(PERF_CYCLES, -1);
+  if (m_fd[PERF_CYCLES] < 0) {
+    return;
+  }
+  m_index[PERF_CYCLES] = m_num_opened++;
+  for (int i = PERF_CYCLES + 1; i < PERF_NUM_EVENTS; ++i) {
+    m_fd[i] = OpenEvent(static_cast<PerfEvent>(i), m_fd[PERF_CYCLES]);
+    if (m_fd[i] >= 0) {
+      m_index[i] = m_num_opened++;
+    }
+  }
+}
+
+PerfCounterGroup::~PerfCounterGroup() {
+  for (int i = 0; i < PERF_NUM_EVENTS; ++i) {
+    if (m_fd[i] >= 0) {
+      close(m_fd[i]);
+    }
+  }
+}
+
+void PerfCounterGroup::Read(uint64 values[PERF_NUM_EVENTS]) const {
+  for (int i = 0; i < PERF_NUM_EVENTS; ++i) {
+    values[i] = 0;
+  }
+  if (!IsAvailable()) {
+    return;
+  }
+  // { nr, time_enabled, time_running, value[nr] }
+  uint64 buffer[3 + PERF_NUM_EVENTS];
+  ssize_t size = (3 + m_num_opened) * sizeof(uint64);
+  if (read(m_fd[PERF_CYCLES], buffer, size) != size) {
+    return;
+  }
+  double scale = 1.0;
+  if (buffer[2] > 0 && buffer[2] < buffer[1]) {
+    scale = static_cast<double>(buffer[1]) / buffer[2];
+  }
+  for (int i = 0; i < PERF_NUM_EVENTS; ++i) {
+    if (m_index[i] >= 0) {
+      values[i] = static_cast<uint64>(buffer[3 + m_index[i]] * scale);
+    }
+  }
+}
+
+#else // no perf_event_open()
+
+PerfCounterGroup::PerfCounterGroup() : m_num_opened(0) {
+  for (int i = 0; i < PERF_NUM_EVENTS; ++i) {
+    m_fd[i] = -1;
+    m_index[i] = -1;
+  }
+}
+
+PerfCounterGroup::~PerfCounterGroup() {}
+
+void PerfCounterGroup::Read(uint64 values[PERF_NUM_EVENTS]) const {
+  for (int i = 0; i < PERF_NUM_EVENTS; ++i) {
+    values[i] = 0;
+  }
+}
+
+#endif
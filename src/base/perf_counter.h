@@ -0,0 +1,64 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file defines PerfCounterGroup, which reads the hardware
+performance counters of the calling thread via perf_event_open().
+*/
+
+#ifndef F2M_BASE_PERF_COUNTER_H_
+#define F2M_BASE_PERF_COUNTER_H_
+
+#include "src/base/common.h"
+
+// The hardware events we count.
+enum PerfEvent {
+  PERF_CYCLES = 0,      // CPU cycles.
+  PERF_INSTRUCTIONS,    // retired instructions.
+  PERF_LLC_MISSES,      // last level cache read misses.
+  PERF_DTLB_MISSES,     // data TLB read misses.
+  PERF_NUM_EVENTS
+};
+
+// PerfCounterGroup opens the counters of all the events as a group
+// for the calling thread, so that one read() returns all of them.
+// Only user space is counted, which most systems allow.
+//
+// In containers and virtual machines, the counters are often not
+// available. Then IsAvailable() returns false, and Read() returns
+// zeros. If only some of the events are missing (e.g. the dTLB events
+// on some CPUs), IsEventAvailable() tells which ones.
+class PerfCounterGroup {
+ public:
+  PerfCounterGroup();
+  ~PerfCounterGroup();
+
+  bool IsAvailable() const { return m_fd[PERF_CYCLES] >= 0; }
+  bool IsEventAvailable(PerfEvent event) const { return m_fd[event] >= 0; }
+
+  // Read the counts since the group was opened. If the kernel
+  // multiplexed the counters, the counts are scaled up.
+  void Read(uint64 values[PERF_NUM_EVENTS]) const;
+
+ private:
+  int m_fd[PERF_NUM_EVENTS];        // -1 if the event is not available.
+  int m_index[PERF_NUM_EVENTS];     // index of the event in a group read.
+  int m_num_opened;                 // number of opened events.
+
+  DISALLOW_COPY_AND_ASSIGN(PerfCounterGroup);
+};
+
+#endif // F2M_BASE_PERF_COUNTER_H_
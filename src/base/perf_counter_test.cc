@@ -0,0 +1,81 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file tests perf_counter.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "src/base/perf_counter.h"
+#include "src/base/profiler.h"
+
+// Some work for the counters to count.
+uint64 Work() {
+  std::vector<uint64> data(1 << 20);
+  uint64 sum = 0;
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[(i * 4099) % data.size()] = i;
+  }
+  for (size_t i = 0; i < data.size(); ++i) {
+    sum += data[i];
+  }
+  return sum;
+}
+
+TEST(PerfCounterGroup, ReadOrDegrade) {
+  PerfCounterGroup group;
+  uint64 begin[PERF_NUM_EVENTS], end[PERF_NUM_EVENTS];
+  group.Read(begin);
+  EXPECT_GT(Work(), (uint64)0);
+  group.Read(end);
+  if (!group.IsAvailable()) {
+    // Containers often have no counters. Then we read zeros.
+    for (int i = 0; i < PERF_NUM_EVENTS; ++i) {
+      EXPECT_EQ(end[i], (uint64)0);
+    }
+    return;
+  }
+  EXPECT_GT(end[PERF_CYCLES], begin[PERF_CYCLES]);
+  if (group.IsEventAvailable(PERF_INSTRUCTIONS)) {
+    EXPECT_GT(end[PERF_INSTRUCTIONS], begin[PERF_INSTRUCTIONS]);
+  }
+}
+
+TEST(PerfCounterGroup, Profiler) {
+  bool available = EnablePerfCounters();
+  ResetProfile();
+  {
+    F2M_PROFILE_SCOPE(PROFILE_GRAD);
+    F2M_PROFILE_COUNT(PROFILE_GRAD, 1000, 1000, 0);
+    EXPECT_GT(Work(), (uint64)0);
+  }
+  ProfileStats stats;
+  CollectProfile(&stats);
+  // Time is always measured.
+  EXPECT_EQ(stats.value[PROFILE_GRAD][PROFILE_CALLS], (uint64)1);
+  EXPECT_GT(stats.value[PROFILE_GRAD][PROFILE_NANOSECONDS], (uint64)0);
+  if (available) {
+    EXPECT_GT(stats.value[PROFILE_GRAD][PROFILE_CYCLES], (uint64)0);
+    EXPECT_NE(ProfileReport("test").find("IPC"), std::string::npos);
+  } else {
+    EXPECT_TRUE(ThreadPerfCounters() == NULL);
+    EXPECT_EQ(stats.value[PROFILE_GRAD][PROFILE_CYCLES], (uint64)0);
+  }
+  DisablePerfCounters();
+}
@@ -0,0 +1,266 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file is the implementation of profiler.h.
+*/
+
+#include "src/base/profiler.h"
+
+#include <stdio.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "src/base/common.h"
+
+namespace {
+
+const char* kStageName[PROFILE_NUM_STAGES] = {
+  "read", "parse", "predict", "grad", "update"
+};
+
+const char* kEventName[PERF_NUM_EVENTS] = {
+  "cycles", "instructions", "LLC misses", "dTLB misses"
+};
+
+// Whether the scopes read the hardware counters.
+std::atomic<bool> perf_enabled(false);
+
+// Whether current thread is left out of the profile.
+thread_local bool thread_excluded = false;
+
+void ClearStats(ProfileStats* stats) {
+  for (int s = 0; s < PROFILE_NUM_STAGES; ++s) {
+    for (int c = 0; c < PROFILE_NUM_COUNTERS; ++c) {
+      stats->value[s][c] = 0;
+    }
+  }
+}
+
+// All the counters. The registry takes a lock only when a
+// thread starts or exits, or when the counters are collected.
+struct ProfileRegistry {
+  std::mutex mutex;
+  std::vector<ProfileCounters*> live;  // counters of running threads.
+  ProfileStats retired;                // sums of the exited threads.
+  ProfileStats baseline;               // sums at the last reset.
+
+  ProfileRegistry() {
+    ClearStats(&retired);
+    ClearStats(&baseline);
+  }
+};
+
+// Never destroyed, so threads can exit at any time.
+ProfileRegistry* Registry() {
+  static ProfileRegistry* registry = new ProfileRegistry();
+  return registry;
+}
+
+void AddStats(const ProfileCounters& counters, ProfileStats* stats) {
+  for (int s = 0; s < PROFILE_NUM_STAGES; ++s) {
+    for (int c = 0; c < PROFILE_NUM_COUNTERS; ++c) {
+      stats->value[s][c] +=
+          counters.value[s][c].load(std::memory_order_relaxed);
+    }
+  }
+}
+
+// Sum of all the counters since the beginning. Must hold the lock.
+void SumAll(ProfileRegistry* registry, ProfileStats* stats) {
+  *stats = registry->retired;
+  for (size_t i = 0; i < registry->live.size(); ++i) {
+    AddStats(*registry->live[i], stats);
+  }
+}
+
+// Register the counters of a thread when it first uses the
+// profiler, and fold them into the registry when it exits.
+class ThreadCounters {
+ public:
+  ThreadCounters() : m_perf(NULL), m_perf_opened(false) {
+    ProfileRegistry* registry = Registry();
+    std::lock_guard<std::mutex> lock(registry->mutex);
+    registry->live.push_back(&m_counters);
+  }
+
+  ~ThreadCounters() {
+    delete m_perf;
+    ProfileRegistry* registry = Registry();
+    std::lock_guard<std::mutex> lock(registry->mutex);
+    AddStats(m_counters, &registry->retired);
+    for (size_t i = 0; i < registry->live.size(); ++i) {
+      if (registry->live[i] == &m_counters) {
+        registry->live[i] = registry->live.back();
+        registry->live.pop_back();
+        break;
+      }
+    }
+  }
+
+  ProfileCounters* counters() { return &m_counters; }
+
+  // Open the hardware counters when the thread first needs them.
+  PerfCounterGroup* perf() {
+    if (!m_perf_opened) {
+      m_perf_opened = true;
+      m_perf = new PerfCounterGroup();
+      if (!m_perf->IsAvailable()) {
+        delete m_perf;
+        m_perf = NULL;
+      }
+    }
+    return m_perf;
+  }
+
+ private:
+  ProfileCounters m_counters;
+  PerfCounterGroup* m_perf;
+  bool m_perf_opened;
+};
+
+ThreadCounters& ThisThread() {
+  static thread_local ThreadCounters thread_counters;
+  return thread_counters;
+}
+
+} // namespace
+
+ProfileCounters* ThreadProfileCounters() {
+  if (thread_excluded) {
+    // Not in the registry, so nobody collects them.
+    static thread_local ProfileCounters ignored;
+    return &ignored;
+  }
+  return ThisThread().counters();
+}
+
+void ExcludeThreadFromProfile() {
+  thread_excluded = true;
+}
+
+PerfCounterGroup* ThreadPerfCounters() {
+  if (thread_excluded || !perf_enabled.load(std::memory_order_relaxed)) {
+    return NULL;
+  }
+  return ThisThread().perf();
+}
+
+bool EnablePerfCounters() {
+  PerfCounterGroup group;
+  if (!group.IsAvailable()) {
+    LOG(WARNING) << "Hardware performance counters are not available. "
+                 << "The profiler only measures time.";
+    return false;
+  }
+  for (int i = 0; i < PERF_NUM_EVENTS; ++i) {
+    if (!group.IsEventAvailable(static_cast<PerfEvent>(i))) {
+      LOG(WARNING) << "Cannot count " << kEventName[i] << ".";
+    }
+  }
+  perf_enabled.store(true);
+  return true;
+}
+
+void DisablePerfCounters() {
+  perf_enabled.store(false);
+}
+
+void CollectProfile(ProfileStats* stats) {
+  CHECK_NOTNULL(stats);
+  ProfileRegistry* registry = Registry();
+  std::lock_guard<std::mutex> lock(registry->mutex);
+  SumAll(registry, stats);
+  for (int s = 0; s < PROFILE_NUM_STAGES; ++s) {
+    for (int c = 0; c < PROFILE_NUM_COUNTERS; ++c) {
+      stats->value[s][c] -= registry->baseline.value[s][c];
+    }
+  }
+}
+
+void ResetProfile() {
+  // Other threads may be writing their counters, so we do not
+  // clear them, but remember where we start counting from.
+  ProfileRegistry* registry = Registry();
+  std::lock_guard<std::mutex> lock(registry->mutex);
+  SumAll(registry, &registry->baseline);
+}
+
+std::string ProfileReport(const std::string& title) {
+  ProfileStats stats;
+  CollectProfile(&stats);
+  double total_seconds = 0;
+  for (int s = 0; s < PROFILE_NUM_STAGES; ++s) {
+    total_seconds += stats.value[s][PROFILE_NANOSECONDS] * 1e-9;
+  }
+  std::string report = "Profile of " + title + ":\n";
+  char line[256];
+  snprintf(line, sizeof(line), "%-8s %10s %6s %10s %12s %14s %14s %10s\n",
+           "stage", "ms", "share", "calls", "rows", "nnz",
+           "bytes", "rows/sec");
+  report += line;
+  for (int s = 0; s < PROFILE_NUM_STAGES; ++s) {
+    const uint64* v = stats.value[s];
+    if (v[PROFILE_CALLS] == 0 && v[PROFILE_ROWS] == 0) continue;
+    double seconds = v[PROFILE_NANOSECONDS] * 1e-9;
+    double share = total_seconds > 0 ? 100 * seconds / total_seconds : 0;
+    double rate = seconds > 0 ? v[PROFILE_ROWS] / seconds : 0;
+    snprintf(line, sizeof(line),
+             "%-8s %10.3f %5.1f%% %10llu %12llu %14llu %14llu %10.0f\n",
+             kStageName[s], seconds * 1e3, share,
+             (unsigned long long) v[PROFILE_CALLS],
+             (unsigned long long) v[PROFILE_ROWS],
+             (unsigned long long) v[PROFILE_NNZ],
+             (unsigned long long) v[PROFILE_BYTES],
+             rate);
+    report += line;
+  }
+  // The hardware counters, if we have them.
+  bool has_perf = false;
+  for (int s = 0; s < PROFILE_NUM_STAGES; ++s) {
+    if (stats.value[s][PROFILE_CYCLES] > 0) has_perf = true;
+  }
+  if (!has_perf) {
+    return report;
+  }
+  snprintf(line, sizeof(line), "%-8s %14s %6s %10s %10s %10s %10s\n",
+           "stage", "cycles", "IPC", "LLC/row", "dTLB/row",
+           "LLC/nnz", "dTLB/nnz");
+  report += line;
+  for (int s = 0; s < PROFILE_NUM_STAGES; ++s) {
+    const uint64* v = stats.value[s];
+    if (v[PROFILE_CYCLES] == 0) continue;
+    double ipc = static_cast<double>(v[PROFILE_INSTRUCTIONS]) /
+                 v[PROFILE_CYCLES];
+    double rows = v[PROFILE_ROWS] > 0 ? v[PROFILE_ROWS] : 1;
+    double nnz = v[PROFILE_NNZ] > 0 ? v[PROFILE_NNZ] : 1;
+    snprintf(line, sizeof(line),
+             "%-8s %14llu %6.2f %10.3f %10.3f %10.3f %10.3f\n",
+             kStageName[s], (unsigned long long) v[PROFILE_CYCLES], ipc,
+             v[PROFILE_LLC_MISSES] / rows, v[PROFILE_DTLB_MISSES] / rows,
+             v[PROFILE_LLC_MISSES] / nnz, v[PROFILE_DTLB_MISSES] / nnz);
+    report += line;
+  }
+  return report;
+}
+
+void DumpProfile(const std::string& title) {
+  LOG(INFO) << ProfileReport(title);
+  ResetProfile();
+}
@@ -0,0 +1,213 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file defines a lightweight profiler for the hot path
+of training: scoped timers and per-stage counters.
+*/
+
+#ifndef F2M_BASE_PROFILER_H_
+#define F2M_BASE_PROFILER_H_
+
+#include <time.h>
+
+#include <atomic>
+#include <string>
+
+#include "src/base/common.h"
+#include "src/base/perf_counter.h"
+
+/* -----------------------------------------------------------------------------
+ * The profiler tells how much time goes to each stage of training without      *
+ * attaching an external profiler. A stage is measured with a scoped timer,     *
+ * and the work it has done is added to its counters:                           *
+ *                                                                              *
+ *   void Parse(...) {                                                          *
+ *     F2M_PROFILE_SCOPE(PROFILE_PARSE);                                        *
+ *     ...                                                                      *
+ *     F2M_PROFILE_COUNT(PROFILE_PARSE, rows, nnz, bytes);                      *
+ *   }                                                                          *
+ *                                                                              *
+ *   F2M_PROFILE_DUMP("epoch 1");  // log the breakdown and reset counters.     *
+ *                                                                              *
+ * Every thread writes its own counters, so the hot path takes no lock and      *
+ * executes no atomic read-modify-write. The counters of all the threads are    *
+ * summed when they are collected. The timers use clock_gettime(), which        *
+ * costs a few nanoseconds, and are meant to wrap a batch, not a single row.    *
+ *                                                                              *
+ * To see whether a stage is bound by memory or by compute, call                *
+ * EnablePerfCounters() before training. Every scope then also reads the        *
+ * hardware counters of its thread (see perf_counter.h), and the breakdown      *
+ * shows IPC and LLC and dTLB misses per row. This costs two read() system      *
+ * calls per scope. Where the counters are not available, e.g. in many          *
+ * containers, EnablePerfCounters() logs a warning and returns false, and the   *
+ * profiler keeps measuring time only.                                          *
+ *                                                                              *
+ * The profile is of the whole process, so it is dumped by the training loop,   *
+ * not by a component such as Reader. A thread that does not train, e.g. the    *
+ * validation thread, calls ExcludeThreadFromProfile() so that its work does    *
+ * not show up in the breakdown of training.                                    *
+ *                                                                              *
+ * Compile with -DF2M_DISABLE_PROFILE to remove all the instrumentation.        *
+ * -----------------------------------------------------------------------------
+ */
+
+// The stages of training.
+enum ProfileStage {
+  PROFILE_READ = 0,     // read lines from disk or rows from memory.
+  PROFILE_PARSE,        // parse lines to DMatrix.
+  PROFILE_PREDICT,      // Loss::Predict()
+  PROFILE_GRAD,         // Loss::CalcGrad()
+  PROFILE_UPDATE,       // Updater::Update()
+  PROFILE_NUM_STAGES
+};
+
+// The counters of a stage.
+enum ProfileCounter {
+  PROFILE_CALLS = 0,    // number of scopes.
+  PROFILE_NANOSECONDS,  // time spent in the scopes.
+  PROFILE_ROWS,         // number of rows.
+  PROFILE_NNZ,          // number of non-zero features.
+  PROFILE_BYTES,        // number of bytes.
+  PROFILE_CYCLES,       // CPU cycles, if perf counters are enabled.
+  PROFILE_INSTRUCTIONS, // retired instructions.
+  PROFILE_LLC_MISSES,   // last level cache read misses.
+  PROFILE_DTLB_MISSES,  // data TLB read misses.
+  PROFILE_NUM_COUNTERS
+};
+
+// The counters of all the stages of a thread.
+struct ProfileCounters {
+  std::atomic<uint64> value[PROFILE_NUM_STAGES][PROFILE_NUM_COUNTERS];
+
+  ProfileCounters() {
+    for (int s = 0; s < PROFILE_NUM_STAGES; ++s) {
+      for (int c = 0; c < PROFILE_NUM_COUNTERS; ++c) {
+        value[s][c].store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Only the owner thread calls Add(), so a relaxed load and store
+  // is enough, and other threads can read the counters at any time.
+  void Add(ProfileStage stage, ProfileCounter counter, uint64 delta) {
+    std::atomic<uint64>& v = value[stage][counter];
+    v.store(v.load(std::memory_order_relaxed) + delta,
+            std::memory_order_relaxed);
+  }
+};
+
+// The sums of the counters of all threads.
+struct ProfileStats {
+  uint64 value[PROFILE_NUM_STAGES][PROFILE_NUM_COUNTERS];
+};
+
+// Return the counters of current thread.
+ProfileCounters* ThreadProfileCounters();
+
+// Do not count the work of current thread from now on.
+void ExcludeThreadFromProfile();
+
+// Start reading the hardware counters in every scope. Return false
+// if the counters are not available on this system.
+bool EnablePerfCounters();
+
+// Stop reading the hardware counters.
+void DisablePerfCounters();
+
+// Return the hardware counters of current thread, or NULL if
+// they are disabled or not available.
+PerfCounterGroup* ThreadPerfCounters();
+
+// Return the nanoseconds of a monotonic clock.
+inline uint64 ProfileNow() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Add the lifetime of a ScopedProfile to a stage.
+class ScopedProfile {
+ public:
+  explicit ScopedProfile(ProfileStage stage)
+    : m_stage(stage), m_perf(ThreadPerfCounters()) {
+    if (m_perf != NULL) {
+      m_perf->Read(m_perf_begin);
+    }
+    m_begin = ProfileNow();
+  }
+
+  ~ScopedProfile() {
+    uint64 end = ProfileNow();
+    ProfileCounters* counters = ThreadProfileCounters();
+    counters->Add(m_stage, PROFILE_NANOSECONDS, end - m_begin);
+    counters->Add(m_stage, PROFILE_CALLS, 1);
+    if (m_perf != NULL) {
+      uint64 perf_end[PERF_NUM_EVENTS];
+      m_perf->Read(perf_end);
+      for (int i = 0; i < PERF_NUM_EVENTS; ++i) {
+        ProfileCounter counter = static_cast<ProfileCounter>(PROFILE_CYCLES + i);
+        counters->Add(m_stage, counter, perf_end[i] - m_perf_begin[i]);
+      }
+    }
+  }
+
+ private:
+  ProfileStage m_stage;
+  PerfCounterGroup* m_perf;
+  uint64 m_begin;
+  uint64 m_perf_begin[PERF_NUM_EVENTS];
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedProfile);
+};
+
+// Add the work done to a stage.
+inline void ProfileCount(ProfileStage stage,
+                         uint64 rows, uint64 nnz, uint64 bytes) {
+  ProfileCounters* counters = ThreadProfileCounters();
+  counters->Add(stage, PROFILE_ROWS, rows);
+  counters->Add(stage, PROFILE_NNZ, nnz);
+  counters->Add(stage, PROFILE_BYTES, bytes);
+}
+
+// Sum the counters of all threads since the last ResetProfile().
+void CollectProfile(ProfileStats* stats);
+
+// Start counting from zero.
+void ResetProfile();
+
+// Format the breakdown of all the stages as a table.
+std::string ProfileReport(const std::string& title);
+
+// Log the breakdown, and then reset the counters.
+void DumpProfile(const std::string& title);
+
+#define F2M_PROFILE_CONCAT_INNER(a, b) a##b
+#define F2M_PROFILE_CONCAT(a, b) F2M_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef F2M_DISABLE_PROFILE
+#define F2M_PROFILE_SCOPE(stage)
+#define F2M_PROFILE_COUNT(stage, rows, nnz, bytes)
+#define F2M_PROFILE_DUMP(title)
+#else
+#define F2M_PROFILE_SCOPE(stage) \
+  ScopedProfile F2M_PROFILE_CONCAT(profile_scope_, __LINE__)(stage)
+#define F2M_PROFILE_COUNT(stage, rows, nnz, bytes) \
+  ProfileCount(stage, rows, nnz, bytes)
+#define F2M_PROFILE_DUMP(title) DumpProfile(title)
+#endif
+
+#endif // F2M_BASE_PROFILER_H_
@@ -0,0 +1,79 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file tests profiler.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+
+#include <string>
+
+#include "src/base/parallel.h"
+#include "src/base/profiler.h"
+
+TEST(Profiler, ScopeAndCount) {
+  ResetProfile();
+  for (int i = 0; i < 10; ++i) {
+    F2M_PROFILE_SCOPE(PROFILE_PARSE);
+    F2M_PROFILE_COUNT(PROFILE_PARSE, 100, 1000, 4096);
+    usleep(1000);
+  }
+  ProfileStats stats;
+  CollectProfile(&stats);
+  const uint64* parse = stats.value[PROFILE_PARSE];
+  EXPECT_EQ(parse[PROFILE_CALLS], (uint64)10);
+  EXPECT_EQ(parse[PROFILE_ROWS], (uint64)1000);
+  EXPECT_EQ(parse[PROFILE_NNZ], (uint64)10000);
+  EXPECT_EQ(parse[PROFILE_BYTES], (uint64)40960);
+  EXPECT_GE(parse[PROFILE_NANOSECONDS], (uint64)10000000);
+  EXPECT_EQ(stats.value[PROFILE_GRAD][PROFILE_CALLS], (uint64)0);
+  std::string report = ProfileReport("test");
+  EXPECT_NE(report.find("parse"), std::string::npos);
+  EXPECT_EQ(report.find("grad"), std::string::npos);
+}
+
+TEST(Profiler, SumOfThreads) {
+  ResetProfile();
+  // The counters of exited threads are kept.
+  for (int round = 0; round < 3; ++round) {
+    ParallelRun(4, [](int id) {
+      for (int i = 0; i < 1000; ++i) {
+        F2M_PROFILE_SCOPE(PROFILE_UPDATE);
+        F2M_PROFILE_COUNT(PROFILE_UPDATE, 1, id, 0);
+      }
+    });
+  }
+  ProfileStats stats;
+  CollectProfile(&stats);
+  EXPECT_EQ(stats.value[PROFILE_UPDATE][PROFILE_CALLS], (uint64)12000);
+  EXPECT_EQ(stats.value[PROFILE_UPDATE][PROFILE_ROWS], (uint64)12000);
+  EXPECT_EQ(stats.value[PROFILE_UPDATE][PROFILE_NNZ], (uint64)18000);
+  // An excluded thread is not counted.
+  ParallelRun(2, [](int id) {
+    if (id == 1) ExcludeThreadFromProfile();
+    F2M_PROFILE_SCOPE(PROFILE_UPDATE);
+    F2M_PROFILE_COUNT(PROFILE_UPDATE, 1, 0, 0);
+  });
+  CollectProfile(&stats);
+  EXPECT_EQ(stats.value[PROFILE_UPDATE][PROFILE_CALLS], (uint64)12001);
+  // Reset
+  DumpProfile("test");
+  CollectProfile(&stats);
+  EXPECT_EQ(stats.value[PROFILE_UPDATE][PROFILE_CALLS], (uint64)0);
+}
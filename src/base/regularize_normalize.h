@@ -32,6 +32,15 @@ namespace f2m {
 (regu_type == NONE) ? 0 :            \
 ((regu_type == L1) ? ((w > 0) ? 1 : ((w < 0) ? -1 : 0)) : w)
 
+// The same gradient with the regularizer known at compile time,
+// so that the kernels do not branch on it for every parameter.
+template <RegularType R> inline real_t RegularGrad(real_t w);
+template <> inline real_t RegularGrad<NONE>(real_t w) { return 0; }
+template <> inline real_t RegularGrad<L1>(real_t w) {
+  return (w > 0) ? 1 : ((w < 0) ? -1 : 0);
+}
+template <> inline real_t RegularGrad<L2>(real_t w) { return w; }
+
 }
 
 #endif /* F2M_SRC_BASE_REGULARIZATION_NORMALIZATION_H */
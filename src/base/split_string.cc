@@ -28,26 +28,17 @@ using std::string;
 using std::vector;
 using std::set;
 
-// In most cases, delim contains only one character.  In this case, we
+// In most cases, delim contains only a few characters.  In this case, we
 // use CalculateReserveForVector to count the number of elements
 // should be reserved in result vector, and thus optimize SplitStringUsing.
 static int CalculateReserveForVector(const string& full, const char* delim) {
   int count = 0;
-  if (delim[0] != '\0' && delim[1] == '\0') {
-    // Optimize the common case where delim is a single character.
-    char c = delim[0];
+  size_t num_delim = strlen(delim);
+  if (num_delim > 0 && num_delim <= CharScanner::kMaxChars) {
+    CharScanner scanner(delim);
     const char* p = full.data();
-    const char* end = p + full.size();
-    while (p != end) {
-      if (*p == c) {  // This could be optimized with hasless(v,1) trick.
-        ++p;
-      } else {
-        while (++p != end && *p != c) {
-          // Skip to the next occurence of the delimiter.
-        }
-        ++count;
-      }
-    }
+    scanner.Split(p, p + full.size(),
+                  [&](const char* begin, const char* end) { ++count; });
   }
   return count;
 }
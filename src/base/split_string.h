@@ -23,10 +23,14 @@ This file declares string splitting utilities.
 #ifndef F2M_BASE_SPLIT_STRING_H_
 #define F2M_BASE_SPLIT_STRING_H_
 
+#include <string.h>
+
 #include <set>
 #include <string>
 #include <vector>
 
+#include "src/base/char_scanner.h"
+
 /* -----------------------------------------------------------------------
  * Subdivide string |full| into substrings according to delimitors        *
  * given in |delim|.  |delim| should pointing to a string including       *
@@ -89,22 +93,16 @@ static inline
 void SplitStringToIteratorUsing(const StringType& full,
                                 const char* delim,
                                 ITR& result) {
-  // Optimize the common case where delim is a single character.
-  if (delim[0] != '\0' && delim[1] == '\0') {
-    char c = delim[0];
+  // Optimize the common case of a few delimiters, which are
+  // found 64 bytes at a time.
+  size_t num_delim = strlen(delim);
+  if (num_delim > 0 && num_delim <= CharScanner::kMaxChars) {
+    CharScanner scanner(delim);
     const char* p = full.data();
-    const char* end = p + full.size();
-    while (p != end) {
-      if (*p == c) {
-        ++p;
-      } else {
-        const char* start = p;
-        while (++p != end && *p != c) {
-          // Skip to the next occurence of the delimiter.
-        }
-        *result++ = StringType(start, p - start);
-      }
-    }
+    scanner.Split(p, p + full.size(),
+                  [&](const char* begin, const char* end) {
+      *result++ = StringType(begin, end - begin);
+    });
     return;
   }
 
@@ -0,0 +1,46 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file defines a simple wall-clock Timer.
+*/
+
+#ifndef F2M_BASE_TIMER_H_
+#define F2M_BASE_TIMER_H_
+
+#include <chrono>
+
+// Timer measures the wall-clock time since it was
+// constructed or last reset.
+class Timer {
+ public:
+  Timer() { Reset(); }
+
+  // Restart the timer.
+  void Reset() { m_begin = std::chrono::steady_clock::now(); }
+
+  // Return the seconds since the last Reset().
+  double Elapsed() const {
+    std::chrono::duration<double> diff =
+        std::chrono::steady_clock::now() - m_begin;
+    return diff.count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point m_begin;
+};
+
+#endif // F2M_BASE_TIMER_H_
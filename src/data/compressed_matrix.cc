@@ -0,0 +1,232 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file is the implementation of compressed_matrix.h
+*/
+
+#include "src/data/compressed_matrix.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "src/base/common.h"
+
+namespace f2m {
+
+namespace {
+
+// The flags of a row.
+const uint8 kBinaryRow = 1;       // the values are not stored.
+const uint8 kWideFields = 2;      // the fields are varints.
+
+// The continuation bits of 8 varint bytes.
+const uint64 kContinuationBits = 0x8080808080808080ULL;
+
+inline void PutVarint(uint32 value, vector<uint8>* bytes) {
+  while (value >= 0x80) {
+    bytes->push_back(static_cast<uint8>(value | 0x80));
+    value >>= 7;
+  }
+  bytes->push_back(static_cast<uint8>(value));
+}
+
+inline const uint8* GetVarint(const uint8* p, uint32* value) {
+  uint32 result = 0;
+  for (int shift = 0; ; shift += 7) {
+    uint8 byte = *p++;
+    result |= static_cast<uint32>(byte & 0x7F) << shift;
+    if (byte < 0x80) break;
+  }
+  *value = result;
+  return p;
+}
+
+template <typename T>
+void WriteVector(const vector<T>& vec, FILE* file) {
+  if (vec.empty()) return;
+  CHECK_EQ(fwrite(vec.data(), sizeof(T), vec.size(), file), vec.size());
+}
+
+template <typename T>
+void ReadVector(FILE* file, uint64 size, vector<T>* vec) {
+  vec->resize(size);
+  if (size == 0) return;
+  if (fread(vec->data(), sizeof(T), size, file) != size) {
+    LOG(FATAL) << "Cannot read the compressed rows.";
+  }
+}
+
+} // namespace
+
+CompressedMatrix::CompressedMatrix(ModelType type)
+  : m_type(type), m_nnz(0) {}
+
+void CompressedMatrix::Append(const DMatrix& matrix) {
+  CHECK_EQ(matrix.model_type, m_type);
+  for (index_t i = 0; i < matrix.row_size; ++i) {
+    CHECK_NOTNULL(matrix.row[i]);
+    m_offset.push_back(m_bytes.size());
+    m_label.push_back(matrix.Y[i]);
+    AppendRow(matrix.row[i]);
+  }
+}
+
+void CompressedMatrix::AppendRow(const SparseRow* row) {
+  index_t size = row->size;
+  m_order.resize(size);
+  for (index_t j = 0; j < size; ++j) {
+    m_order[j] = j;
+  }
+  std::sort(m_order.begin(), m_order.end(),
+            [row](index_t a, index_t b) { return row->idx[a] < row->idx[b]; });
+  // A row of 1s is binary, even if it stores the values.
+  bool binary = row->binary;
+  if (!binary) {
+    binary = true;
+    for (index_t j = 0; j < size && binary; ++j) {
+      binary = row->X[j] == 1;
+    }
+  }
+  bool wide_fields = false;
+  if (m_type == FFM) {
+    for (index_t j = 0; j < size; ++j) {
+      if (row->field[j] > 0xFF) wide_fields = true;
+    }
+  }
+  PutVarint(size, &m_bytes);
+  m_bytes.push_back((binary ? kBinaryRow : 0) |
+                    (wide_fields ? kWideFields : 0));
+  index_t last = 0;
+  for (index_t j = 0; j < size; ++j) {
+    index_t idx = row->idx[m_order[j]];
+    PutVarint(idx - last, &m_bytes);
+    last = idx;
+  }
+  if (m_type == FFM) {
+    for (index_t j = 0; j < size; ++j) {
+      index_t field = row->field[m_order[j]];
+      if (wide_fields) {
+        PutVarint(field, &m_bytes);
+      } else {
+        m_bytes.push_back(static_cast<uint8>(field));
+      }
+    }
+  }
+  if (!binary) {
+    size_t pos = m_bytes.size();
+    m_bytes.resize(pos + size * sizeof(real_t));
+    for (index_t j = 0; j < size; ++j) {
+      memcpy(&m_bytes[pos + j * sizeof(real_t)], &row->X[m_order[j]],
+             sizeof(real_t));
+    }
+  }
+  m_nnz += size;
+}
+
+real_t CompressedMatrix::Decode(index_t i, SparseRow* row) const {
+  CHECK_LT(i, m_offset.size());
+  CHECK_NOTNULL(row);
+  const uint8* p = m_bytes.data() + m_offset[i];
+  uint32 size = 0;
+  p = GetVarint(p, &size);
+  uint8 flags = *p++;
+  // Set the row binary first, so that it does not grow X.
+  row->set_binary(flags & kBinaryRow);
+  row->resize(size);
+  index_t* idx = row->idx;
+  index_t last = 0;
+  for (index_t j = 0; j < size; ) {
+    // The next 8 features take at least 8 bytes, so
+    // we never read beyond the row.
+    if (j + 8 <= size) {
+      uint64 word;
+      memcpy(&word, p, sizeof(word));
+      if ((word & kContinuationBits) == 0) {
+        for (int b = 0; b < 8; ++b) {
+          last += p[b];
+          idx[j + b] = last;
+        }
+        p += 8;
+        j += 8;
+        continue;
+      }
+    }
+    uint32 delta = 0;
+    p = GetVarint(p, &delta);
+    last += delta;
+    idx[j++] = last;
+  }
+  if (m_type == FFM) {
+    if (flags & kWideFields) {
+      for (index_t j = 0; j < size; ++j) {
+        p = GetVarint(p, &row->field[j]);
+      }
+    } else {
+      for (index_t j = 0; j < size; ++j) {
+        row->field[j] = p[j];
+      }
+      p += size;
+    }
+  }
+  if (!row->binary) {
+    memcpy(row->X, p, size * sizeof(real_t));
+  }
+  return m_label[i];
+}
+
+void CompressedMatrix::Shrink() {
+  m_bytes.shrink_to_fit();
+  m_offset.shrink_to_fit();
+  m_label.shrink_to_fit();
+  vector<index_t>().swap(m_order);
+}
+
+void CompressedMatrix::Clear() {
+  m_bytes.clear();
+  m_offset.clear();
+  m_label.clear();
+  m_nnz = 0;
+}
+
+void CompressedMatrix::Write(FILE* file) const {
+  CHECK_NOTNULL(file);
+  uint64 header[3] = { m_offset.size(), m_bytes.size(), m_nnz };
+  CHECK_EQ(fwrite(header, sizeof(header), 1, file), 1);
+  WriteVector(m_offset, file);
+  WriteVector(m_label, file);
+  WriteVector(m_bytes, file);
+}
+
+void CompressedMatrix::Read(FILE* file) {
+  CHECK_NOTNULL(file);
+  uint64 header[3];
+  if (fread(header, sizeof(header), 1, file) != 1) {
+    LOG(FATAL) << "Cannot read the compressed rows.";
+  }
+  ReadVector(file, header[0], &m_offset);
+  ReadVector(file, header[0], &m_label);
+  ReadVector(file, header[1], &m_bytes);
+  m_nnz = header[2];
+}
+
+uint64 CompressedMatrix::GetNumberOfBytes() const {
+  return m_bytes.size() + m_offset.size() * sizeof(uint64) +
+         m_label.size() * sizeof(real_t);
+}
+
+} // namespace f2m
@@ -0,0 +1,108 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file defines CompressedMatrix, which holds the rows of a
+data set in memory with a few bytes per feature.
+*/
+
+#ifndef F2M_DATA_COMPRESSED_MATRIX_H_
+#define F2M_DATA_COMPRESSED_MATRIX_H_
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/data/data_structure.h"
+
+using std::vector;
+
+namespace f2m {
+
+/* -----------------------------------------------------------------------------
+ * A parsed row takes at least 8 bytes per feature (idx and X, and 4 more for   *
+ * the field of FFM), together with a SparseRow and the padding of its arrays.  *
+ * CompressedMatrix stores a row as a string of bytes instead:                  *
+ *                                                                              *
+ *   [ size | flags | idx deltas | fields | values ]                            *
+ *                                                                              *
+ * The features of a row are sorted by idx, so that idx is stored as the varint *
+ * of its difference to the previous idx, which mostly takes one or two bytes.  *
+ * A field takes one byte if all the fields of the row are below 256. The       *
+ * values of a binary row are not stored, and the other values are stored as    *
+ * floats, so that no feature or value is changed by the compression. The order *
+ * of the features is, though: the losses add up the terms of a row in idx      *
+ * order, so the results of training are only equal to those without            *
+ * compression within a rounding error.                                         *
+ *                                                                              *
+ * The rows are decoded one at a time into the rows of a batch:                 *
+ *                                                                              *
+ *   CompressedMatrix compressed(FFM);                                          *
+ *   compressed.Append(parsed_block);                                           *
+ *   ...                                                                        *
+ *   batch.ResetSparseRow();                                                    *
+ *   batch.Y[i] = compressed.Decode(index, batch.row[i]);                       *
+ *                                                                              *
+ * The decoder reads the deltas 8 bytes at a time: if none of the 8 bytes has   *
+ * the continuation bit, they are 8 one-byte deltas, which are added up         *
+ * without looking at the bytes one by one.                                     *
+ * -----------------------------------------------------------------------------
+ */
+class CompressedMatrix {
+ public:
+  explicit CompressedMatrix(ModelType type = LR);
+
+  // Append the rows of |matrix|, which has the same model type.
+  // The features of a row may come out in another order.
+  void Append(const DMatrix& matrix);
+
+  // Decode row |i| into |row|, whose arrays are allocated from
+  // its arena, and return the label of the row.
+  real_t Decode(index_t i, SparseRow* row) const;
+
+  // Release the memory reserved for more rows.
+  void Shrink();
+
+  // Remove all the rows.
+  void Clear();
+
+  // Write the rows to |file| in a binary format.
+  void Write(FILE* file) const;
+
+  // Replace the rows by the rows written by Write().
+  void Read(FILE* file);
+
+  index_t GetNumberOfRows() const { return m_offset.size(); }
+  uint64 GetNumberOfNonZero() const { return m_nnz; }
+  // The memory of the compressed rows and their labels.
+  uint64 GetNumberOfBytes() const;
+
+ private:
+  ModelType m_type;                 // enum ModelType { LR, FM, FFM }
+  vector<uint8> m_bytes;            // the encoded rows.
+  vector<uint64> m_offset;          // the beginning of every row.
+  vector<real_t> m_label;           // the label of every row.
+  uint64 m_nnz;                     // number of features of all rows.
+  vector<index_t> m_order;          // the features of a row by idx.
+
+  void AppendRow(const SparseRow* row);
+
+  DISALLOW_COPY_AND_ASSIGN(CompressedMatrix);
+};
+
+} // namespace f2m
+
+#endif // F2M_DATA_COMPRESSED_MATRIX_H_
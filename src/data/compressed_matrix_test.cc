@@ -0,0 +1,167 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file tests compressed_matrix.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include "src/base/file_util.h"
+#include "src/data/compressed_matrix.h"
+#include "src/data/data_structure.h"
+
+using std::vector;
+
+namespace f2m {
+
+const index_t kNumRows = 1000;
+
+typedef std::tuple<index_t, index_t, real_t> Feature;
+
+// The features of a row in the order of idx.
+vector<Feature> Features(const SparseRow* row) {
+  vector<Feature> features;
+  for (index_t j = 0; j < row->size; ++j) {
+    features.push_back(Feature(row->idx[j],
+                               row->model_type == FFM ? row->field[j] : 0,
+                               row->binary ? 1 : row->X[j]));
+  }
+  std::sort(features.begin(), features.end());
+  return features;
+}
+
+// Rows of every size up to 40, with small and large ids and fields,
+// binary rows, and rows of 1s that are not marked binary.
+void MakeRows(DMatrix& matrix) {
+  matrix.resize(kNumRows);
+  matrix.InitSparseRow();
+  for (index_t i = 0; i < kNumRows; ++i) {
+    SparseRow* row = matrix.row[i];
+    row->set_binary(i % 3 == 0);
+    row->resize(i % 41);
+    matrix.Y[i] = i % 2 ? 1 : -1;
+    for (index_t j = 0; j < row->size; ++j) {
+      row->idx[j] = i % 5 == 0 ? rand() : rand() % 1000;
+      if (row->model_type == FFM) {
+        row->field[j] = i % 7 == 0 ? rand() % 100000 : rand() % 40;
+      }
+      if (!row->binary) {
+        row->X[j] = i % 3 == 1 ? 1 : rand() / (real_t) RAND_MAX;
+      }
+    }
+  }
+}
+
+TEST(CompressedMatrixTest, DecodeSameRows) {
+  for (int type = LR; type <= FFM; ++type) {
+    ModelType model_type = static_cast<ModelType>(type);
+    DMatrix matrix(model_type);
+    MakeRows(matrix);
+    CompressedMatrix compressed(model_type);
+    // Append in two blocks.
+    DMatrix first(model_type);
+    first.resize(kNumRows / 2);
+    for (index_t i = 0; i < first.row_size; ++i) {
+      first.row[i] = matrix.row[i];
+      first.Y[i] = matrix.Y[i];
+    }
+    compressed.Append(first);
+    DMatrix second(model_type);
+    second.resize(kNumRows - first.row_size);
+    for (index_t i = 0; i < second.row_size; ++i) {
+      second.row[i] = matrix.row[first.row_size + i];
+      second.Y[i] = matrix.Y[first.row_size + i];
+    }
+    compressed.Append(second);
+    compressed.Shrink();
+    ASSERT_EQ(compressed.GetNumberOfRows(), kNumRows);
+    // Decode in random order into reused rows.
+    DMatrix batch(4, model_type);
+    batch.InitSparseRow();
+    uint64 nnz = 0;
+    for (index_t n = 0; n < kNumRows; ++n) {
+      index_t i = (n * 7919) % kNumRows;
+      SparseRow* row = batch.row[n % 4];
+      EXPECT_EQ(compressed.Decode(i, row), matrix.Y[i]);
+      ASSERT_EQ(row->size, matrix.row[i]->size);
+      EXPECT_EQ(Features(row), Features(matrix.row[i]));
+      // The rows of 1s are binary.
+      EXPECT_EQ(row->binary, i % 3 != 2 || row->size == 0);
+      nnz += row->size;
+    }
+    EXPECT_EQ(compressed.GetNumberOfNonZero(), nnz);
+  }
+}
+
+TEST(CompressedMatrixTest, Size) {
+  // Binary LR rows with dense ids take a byte and a bit per feature.
+  DMatrix matrix(kNumRows);
+  matrix.InitSparseRow();
+  for (index_t i = 0; i < kNumRows; ++i) {
+    SparseRow* row = matrix.row[i];
+    row->set_binary(true);
+    row->resize(40);
+    for (index_t j = 0; j < row->size; ++j) {
+      row->idx[j] = (i + j * 97) % 5000;
+    }
+  }
+  CompressedMatrix compressed;
+  compressed.Append(matrix);
+  compressed.Shrink();
+  double bytes_per_feature = compressed.GetNumberOfBytes() /
+                             static_cast<double>(kNumRows * 40);
+  EXPECT_LT(bytes_per_feature, 2.0);
+}
+
+TEST(CompressedMatrixTest, WriteRead) {
+  const char* kFilename = "/tmp/test_compressed_matrix.bin";
+  DMatrix matrix(FFM);
+  MakeRows(matrix);
+  CompressedMatrix compressed(FFM);
+  compressed.Append(matrix);
+  // Write an empty matrix after the rows.
+  FILE* file = OpenFileOrDie(kFilename, "w");
+  compressed.Write(file);
+  compressed.Clear();
+  EXPECT_EQ(compressed.GetNumberOfRows(), 0);
+  compressed.Write(file);
+  Close(file);
+  file = OpenFileOrDie(kFilename, "r");
+  CompressedMatrix loaded(FFM);
+  loaded.Read(file);
+  ASSERT_EQ(loaded.GetNumberOfRows(), kNumRows);
+  DMatrix batch(1, FFM);
+  batch.InitSparseRow();
+  for (index_t i = 0; i < kNumRows; ++i) {
+    EXPECT_EQ(loaded.Decode(i, batch.row[0]), matrix.Y[i]);
+    EXPECT_EQ(Features(batch.row[0]), Features(matrix.row[i]));
+  }
+  loaded.Read(file);
+  EXPECT_EQ(loaded.GetNumberOfRows(), 0);
+  EXPECT_EQ(loaded.GetNumberOfNonZero(), 0);
+  Close(file);
+  unlink(kFilename);
+}
+
+} // namespace f2m
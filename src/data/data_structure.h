@@ -23,8 +23,12 @@ This file defines the basic data structures used by f2m.
 #ifndef F2M_DATA_DATA_STRUCTURE_H_
 #define F2M_DATA_DATA_STRUCTURE_H_
 
+#include <string.h>
+
+#include <limits>
 #include <vector>
 
+#include "src/base/arena.h"
 #include "src/base/common.h"
 
 using std::vector;
@@ -49,38 +53,79 @@ enum RegularType { L1, L2, NONE };
 // SparseRow is used to store one line of parsed data.
 // Notice that the entry of 'field' is used only for 
 // the FFM task. 
+// The arrays of a SparseRow are allocated from an Arena,
+// so they are released all together when the arena is
+// reset, and a SparseRow does not own any memory.
 struct SparseRow {
   // Constructors
-  SparseRow(ModelType type = LR) 
-    : model_type(type) {}
-  
-  SparseRow(index_t len, ModelType type = LR)
-    : model_type(type) {
-    CHECK_GE(len, 0);
-    resize(len);
-  }
-  // Resize current row.
+  SparseRow(ModelType type = LR, Arena* row_arena = NULL)
+    : X(NULL), idx(NULL), field(NULL), size(0), capacity(0),
+      binary(false), model_type(type), arena(row_arena) {}
+
+  // Resize current row. The arrays are allocated again
+  // only if |len| is larger than the capacity.
   void resize(index_t len) {
     CHECK_GE(len, 0);
+    if (len > capacity) {
+      CHECK_NOTNULL(arena);
+      // Grow geometrically, so that a row reused for many
+      // lines does not leave too much garbage in the arena.
+      index_t new_capacity = len > 2 * capacity ? len : 2 * capacity;
+      // A binary row has no values to grow, unless
+      // it stored values before.
+      if (!binary || X != NULL) {
+        X = Grow(X, new_capacity);
+      }
+      idx = Grow(idx, new_capacity);
+      if (model_type == FFM) { 
+        field = Grow(field, new_capacity);
+      }
+      capacity = new_capacity;
+    }
     size = len;
-    X.resize(len);
-    idx.resize(len);
-    if (model_type == FFM) { 
-      field.resize(len);
+  }
+  // A binary row has x_j = 1 for every feature, and
+  // the kernels do not read X. A row that is binary from
+  // the beginning does not allocate X, which is NULL. A
+  // row that stops being binary gets its values back, but
+  // they are not initialized.
+  void set_binary(bool is_binary) {
+    binary = is_binary;
+    if (!binary && X == NULL && capacity > 0) {
+      CHECK_NOTNULL(arena);
+      X = arena->AllocateArray<real_t>(capacity);
     }
   }
   // X can be used to store both the numerical 
   // features and the categorical features. 
-  vector<real_t> X;
+  // It may be NULL for a binary row.
+  real_t* X;
   // The idx is used to store the feature index.
-  vector<index_t> idx;
+  index_t* idx;
   // The 'field' is optional, only used for FFM.
-  vector<index_t> field;
+  index_t* field;
   // Identify how many features are stored in 
   // current SparseRow. 
   index_t size;
+  // The number of features we can store without
+  // allocating new arrays.
+  index_t capacity;
+  // All the values are 1, see set_binary().
+  bool binary;
   // enum  ModelType { LR, FM, FFM }
   ModelType model_type;
+  // The arena that stores the arrays.
+  Arena* arena;
+
+ private:
+  template <typename T>
+  T* Grow(T* array, index_t new_capacity) {
+    T* new_array = arena->AllocateArray<T>(new_capacity);
+    if (size > 0) {
+      memcpy(new_array, array, size * sizeof(T));
+    }
+    return new_array;
+  }
 };
 
 // DMatrix (data matrix) is used to store a batch 
@@ -88,7 +133,7 @@ struct SparseRow {
 struct DMatrix {
   // Constructors
   DMatrix(ModelType type = LR) 
-    : model_type(type) {}
+    : row_size(0), model_type(type) {}
 
   DMatrix(index_t size, ModelType type = LR)
     : model_type(type) {
@@ -102,12 +147,21 @@ struct DMatrix {
     row.resize(size);
     Y.resize(size);
   }
-  // Initialize the row pointers. 
+  // Initialize the row pointers. Both the rows and
+  // their arrays are allocated from the arena, so
+  // we do not call malloc for each row.
   void InitSparseRow() {
     for (index_t i = 0; i < row_size; ++i) {
-      row[i] = new SparseRow(model_type);
+      row[i] = arena.New<SparseRow>(model_type, &arena);
     }   
   }
+  // Release all the rows in O(1), and create empty rows
+  // again. The memory of the arena is reused, so a batch
+  // does not call malloc once the arena is large enough.
+  void ResetSparseRow() {
+    arena.Reset();
+    InitSparseRow();
+  }
   // Storing a set of SparseRow.
   // Note that here we use pointer to implement zero copy
   // when we load all data into the memory buffer.
@@ -119,6 +173,8 @@ struct DMatrix {
   index_t row_size;
   // enum ModelType { LR, FM, FFM }
   ModelType model_type;
+  // Storing the rows created by InitSparseRow().
+  Arena arena;
 };
 
 // SparseGrad is used to store the calculated gradient.
@@ -144,6 +200,22 @@ struct SparseGrad {
       pos_v.resize(size);
     }
   }
+  // Make room for |num_w| linear and |num_v| latent gradients,
+  // so that the vectors do not grow during training. The
+  // gradients are indexed by index_t, so neither may exceed it.
+  void reserve(uint64 num_w, uint64 num_v) {
+    const uint64 kMaxSize = std::numeric_limits<index_t>::max();
+    CHECK_LE(num_w, kMaxSize);
+    CHECK_LE(num_v, kMaxSize);
+    if (w.size() < num_w) {
+      w.resize(num_w);
+      pos_w.resize(num_w);
+    }
+    if (v.size() < num_v) {
+      v.resize(num_v);
+      pos_v.resize(num_v);
+    }
+  }
   // Store the bias term
   real_t bias;
   // Store the linear terms.
@@ -26,8 +26,11 @@ This file is the implementation of model_parameters.h
 #include <string>
 #include <fstream>
 
+#include <string.h>
+
 #include "src/base/common.h"
 #include "src/base/file_util.h"
+#include "src/base/numa_util.h"
 #include "src/base/random.h"
 
 using std::vector;
@@ -45,10 +48,10 @@ const uint32 kElemSize = sizeof(real_t);
 Model::Model(index_t feature_num, F2M_PARAM hyperparam, ModelType type,
              int k, int field_num, bool gaussian) :
   m_type(type),
-  m_hyperparam(hyperparam),
   m_feature_num(feature_num),
   m_k(k),
-  m_field_num(field_num) {
+  m_field_num(field_num),
+  m_hyperparam(hyperparam) {
     CHECK_GT(m_feature_num, 0);
     if (type == FM || type == FFM) CHECK_GT(m_k, 0);
     if (type == FFM) CHECK_GT(m_field_num, 0);
@@ -73,12 +76,25 @@ Model::Model(index_t feature_num, F2M_PARAM hyperparam, ModelType type,
       if (gaussian) {
         InitModelUsingGaussian();
       }
+      LOG(INFO) << "Model parameters take "
+                << (m_parameters_num * sizeof(real_t) >> 20)
+                << " MB on " << PageBackingName(GetPageBacking()) << ".";
     } catch (std::bad_alloc&) {
       LOG(FATAL) << "Cannot allocate enough memory for \
                      current model parameters.";
     }
 }
 
+bool Model::InterleaveOnNumaNodes() {
+  return NumaInterleave(m_parameters.data(),
+                        m_parameters.size() * sizeof(real_t));
+}
+
+bool Model::BindToNumaNode(int node) {
+  return NumaBindToNode(m_parameters.data(),
+                        m_parameters.size() * sizeof(real_t), node);
+}
+
 void Model::SaveModel(const string& filename) {
   CHECK_NE(filename.empty(), true);
   CHECK_EQ(m_parameters_num, m_parameters.size());
@@ -120,7 +136,7 @@ void Model::SaveModel(const string& filename) {
     }
   }
   Close(pfile);
-  delete buf;
+  delete [] buf;
 }
 
 void Model::LoadModel(const string& filename) {
@@ -150,7 +166,7 @@ void Model::LoadModel(const string& filename) {
   } while (len != 0);
   CHECK_EQ(index, m_parameters_num);
   Close(pfile);
-  delete buf;
+  delete [] buf;
 }
 
 // Initialize model parameters using 
@@ -27,6 +27,7 @@ This file defines the model parameters used by f2m.
 #include <string>
 
 #include "src/base/common.h"
+#include "src/base/huge_page.h"
 #include "src/data/data_structure.h"
 #include "hyper_parameters.h"
 
@@ -35,6 +36,11 @@ using std::string;
 
 namespace f2m {
 
+// The model parameters and the states of the optimizer are
+// large arrays read at random feature indices, so we store
+// them on huge pages to save the TLB misses.
+typedef vector<real_t, HugePageAllocator<real_t> > ParameterVector;
+
 // Model is responsible for storing the global model prameters.
 // Note that, we represent the model parameters in a flat way, that is,
 // no matter in LR, FM, or FFM, we store all the parameters in a big array.
@@ -53,7 +59,7 @@ class Model {
   // Load model from disk file.
   void LoadModel(const string& filename);
   // Get model parameters.
-  vector<real_t>* GetParameter() { return &m_parameters; }
+  ParameterVector* GetParameter() { return &m_parameters; }
   // Get model type.
   ModelType GetModelType() const { return m_type; }
   // Get number of features.
@@ -68,10 +74,20 @@ class Model {
   real_t GetLambda () const {  return m_hyperparam.regu_lambda;}
   // Get field num (for FFM)
   index_t GetFieldNum() { return m_field_num; }
+  // Spread the parameters over the memory of all NUMA nodes,
+  // so that workers on every node share the memory bandwidth.
+  bool InterleaveOnNumaNodes();
+  // Move the parameters to the memory of a NUMA node, e.g.
+  // for a replica that is only used by workers on that node.
+  bool BindToNumaNode(int node);
+  // Return the kind of pages that back the parameters.
+  PageBacking GetPageBacking() const {
+    return PageBackingOf(m_parameters.data());
+  }
 
  private:
   ModelType m_type;                 // enum ModelType { LR, FM, FFM };
-  vector<real_t> m_parameters;      // Store the global model parameters.
+  ParameterVector m_parameters;     // Store the global model parameters.
   index_t m_feature_num;            // number of features
   index_t m_parameters_num;         // number of parameter
   int m_k;                          // vector size for FM and FFM
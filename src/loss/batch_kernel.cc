@@ -0,0 +1,63 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file instantiates the batch kernels of batch_kernel.h.
+*/
+
+#include "src/loss/batch_kernel.h"
+
+namespace f2m {
+
+namespace {
+
+// A table of SelectFactorKernel() for a model type and a regularizer.
+template <ModelType M, RegularType R>
+struct KernelTable {
+  typedef LossKernel Kernel;
+  template <int K>
+  static Kernel Get() {
+    Kernel kernel = { BatchKernel<M, R, K>::Margins,
+                      BatchKernel<M, R, K>::Fused };
+    return kernel;
+  }
+};
+
+template <ModelType M>
+LossKernel SelectFactorizationKernel(RegularType regu_type, index_t k) {
+  switch (regu_type) {
+    case L1: return SelectFactorKernel<KernelTable<M, L1> >(k);
+    case L2: return SelectFactorKernel<KernelTable<M, L2> >(k);
+    case NONE: return SelectFactorKernel<KernelTable<M, NONE> >(k);
+    default: LOG(FATAL) << "Unknown regularizer: " << regu_type;
+  }
+  return KernelTable<M, NONE>::template Get<0>();
+}
+
+} // namespace
+
+LossKernel SelectLossKernel(ModelType type,
+                            RegularType regu_type,
+                            index_t k) {
+  switch (type) {
+    case LR: return KernelTable<LR, NONE>::Get<0>();
+    case FM: return SelectFactorizationKernel<FM>(regu_type, k);
+    case FFM: return SelectFactorizationKernel<FFM>(regu_type, k);
+    default: LOG(FATAL) << "Unknown model type: " << type;
+  }
+  return KernelTable<LR, NONE>::Get<0>();
+}
+
+} // namespace f2m
@@ -0,0 +1,738 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file defines the batch kernels of the losses, which are
+templated on the model type, the regularizer and the size of
+latent vectors.
+*/
+
+#ifndef F2M_LOSS_BATCH_KERNEL_H_
+#define F2M_LOSS_BATCH_KERNEL_H_
+
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/base/fast_math.h"
+#include "src/base/regularize_normalize.h"
+#include "src/data/data_structure.h"
+#include "src/loss/factor_kernel.h"
+
+namespace f2m {
+
+//------------------------------------------------------------------------------
+// A loss selects its kernels once for a model, by the model type, the
+// regularizer and k, and then calls them through a function pointer for
+// every batch:
+//
+//   LossKernel kernel = SelectLossKernel(FFM, L2, 4);
+//   kernel.margins(matrix, w, shape, prefetch, scratch, margin);
+//
+// Inside a batch everything is resolved at compile time: the row kernels
+// are inlined, the regularizer does not branch for every parameter, and
+// the parameters are read through a raw pointer that is loaded once.
+//
+// Training goes through the fused kernel, which reads the parameters of
+// a row only once. It copies them into a cache while it computes the
+// margin, together with the per-factor sums of FM, and computes the
+// gradients from the cache. The margins come out as a by-product, so
+// the training loss costs nothing more. A row whose copy would not fit
+// in L2, e.g. a long FFM row, gains nothing from the copy, so it is
+// handled without the cache, and its gradients are computed from the
+// parameters again.
+//
+// Every row kernel is compiled twice: once for the rows that store
+// their values, and once for the binary rows, whose values are all 1.
+// The batch kernels pick one of them for every row.
+//
+// A model much larger than the cache misses on almost every parameter.
+// So the batch kernels walk the features of the batch ahead of the row
+// they handle, and prefetch the parameters of the features up to d
+// features beyond the end of the row, where d is the prefetch distance
+// (0 for no prefetching). A distance in features rather than in rows
+// keeps the number of prefetches in flight bounded for long rows.
+//------------------------------------------------------------------------------
+
+// The default prefetch distance in features.
+const index_t kDefaultPrefetchDistance = 16;
+// The size of a cache line in bytes.
+const index_t kCacheLineSize = 64;
+
+// Compute the margins <w,x> of all the rows of a batch.
+typedef void (*MarginsKernel)(const DMatrix* matrix,
+                              const real_t* w,
+                              const FactorShape& shape,
+                              index_t prefetch,
+                              real_t* scratch,
+                              real_t* margin);
+
+// Compute the margins of a batch and fill in |grad|.
+typedef void (*FusedKernel)(const DMatrix* matrix,
+                            const real_t* w,
+                            const FactorShape& shape,
+                            index_t prefetch,
+                            real_t* scratch,
+                            real_t lambda,
+                            std::vector<real_t>& cache,
+                            real_t* margin,
+                            SparseGrad& grad);
+
+struct LossKernel {
+  MarginsKernel margins;
+  FusedKernel fused;
+};
+
+// Return the kernels for a model. The regularizer and k are
+// ignored for LR, and an unspecialized k gets the generic kernels.
+LossKernel SelectLossKernel(ModelType type,
+                            RegularType regu_type,
+                            index_t k);
+
+// Given the labels and the margins <w,x> of |num| rows, return the
+// partial gradients -y / (1 + exp(y*<w,x>)). We call the vectorized
+// sigmoid once for all the rows instead of exp() for every row.
+inline void PartialGrad(const real_t* label,
+                        const real_t* margin,
+                        real_t* partial_grad,
+                        index_t num) {
+  for (index_t i = 0; i < num; ++i) {
+    real_t y = label[i] > 0 ? 1 : -1;
+    partial_grad[i] = -y*margin[i];
+  }
+  // sigmoid(-y*<w,x>) = 1 / (1 + exp(y*<w,x>))
+  FastSigmoid(partial_grad, partial_grad, num);
+  for (index_t i = 0; i < num; ++i) {
+    real_t y = label[i] > 0 ? 1 : -1;
+    partial_grad[i] = -y*partial_grad[i];
+  }
+}
+
+// The value x_j of a row. The kernels of the binary rows (B is true)
+// never load X, and the multiplications by 1 are compiled away.
+template <bool B>
+inline real_t Value(const SparseRow* row, index_t j) {
+  return B ? 1 : row->X[j];
+}
+
+// Prefetch the |size| floats at |x| into all the levels of cache.
+inline void PrefetchRange(const real_t* x, index_t size) {
+  const char* begin = reinterpret_cast<const char*>(x);
+  const char* end = reinterpret_cast<const char*>(x + size);
+  for (const char* p = begin; p < end; p += kCacheLineSize) {
+    __builtin_prefetch(p, 0, 3);
+  }
+  // The last line when |x| is not aligned to a line.
+  if (size > 0) __builtin_prefetch(end - 1, 0, 3);
+}
+
+// The kernels of one row. Margin() is used for prediction.
+// Gather() computes the same margin and fills in a cache of
+// CacheSize() floats, from which Grad() computes the gradients
+// without reading the parameters again. GradFromModel() gives
+// the same gradients as Grad() but reads the parameters, for
+// the rows that are too large for the cache. Prefetch() asks
+// for the parameters of feature j of a row that is about to
+// be handled.
+// B is true for the binary rows, see SparseRow::set_binary().
+template <ModelType M, RegularType R, int K, bool B>
+struct RowKernel;
+
+// Logistic regression. Math:
+//  [ <w,x> = sum_j w_j * x_j ]
+//  [ grad_j = partial_grad * x_j ]
+// Note that LR stores feature j at w[j] and has neither a bias
+// nor a regularization term in the gradient, so the gradients
+// do not need any parameter and the cache is empty.
+template <RegularType R, int K, bool B>
+struct RowKernel<LR, R, K, B> {
+  static inline real_t Margin(const SparseRow* row,
+                              const real_t* w,
+                              const FactorShape& shape,
+                              real_t* scratch) {
+    real_t val = 0.0;
+    for (index_t j = 0; j < row->size; ++j) {
+      val += w[row->idx[j]] * Value<B>(row, j);
+    }
+    return val;
+  }
+
+  static inline uint64 CacheSize(const SparseRow* row,
+                                 const FactorShape& shape) {
+    return 0;
+  }
+
+  static inline real_t Gather(const SparseRow* row,
+                              const real_t* w,
+                              const FactorShape& shape,
+                              real_t* cache) {
+    return Margin(row, w, shape, cache);
+  }
+
+  static inline void Prefetch(const SparseRow* row,
+                              index_t j,
+                              const real_t* w,
+                              const FactorShape& shape) {
+    __builtin_prefetch(w + row->idx[j], 0, 3);
+  }
+
+  static inline void Grad(const SparseRow* row,
+                          const FactorShape& shape,
+                          const real_t* cache,
+                          real_t partial_grad,
+                          real_t lambda,
+                          SparseGrad& grad) {
+    ReserveGrad(grad.w, grad.pos_w, grad.size_w, row->size);
+    index_t num = grad.size_w;
+    for (index_t j = 0; j < row->size; ++j) {
+      grad.w[num] = partial_grad * Value<B>(row, j);
+      grad.pos_w[num] = row->idx[j];
+      num++;
+    }
+    grad.size_w = num;
+  }
+
+  static inline void GradFromModel(const SparseRow* row,
+                                   const real_t* w,
+                                   const FactorShape& shape,
+                                   real_t* scratch,
+                                   real_t partial_grad,
+                                   real_t lambda,
+                                   SparseGrad& grad) {
+    Grad(row, shape, NULL, partial_grad, lambda, grad);
+  }
+};
+
+// Factorization machine. Math:
+//  [ <w,x> = w_0 + sum_j w_j * x_j + sum_{j<k} <v_j, v_k> * x_j * x_k ]
+// The cross term is computed in O(n*k) by
+//  [ sum_{j<k} <v_j, v_k> x_j x_k
+//      = 1/2 * sum_l ((sum_j v_jl x_j)^2 - sum_j v_jl^2 x_j^2) ]
+// and the gradients are
+//  [ bias: partial_grad ]
+//  [ w_j: partial_grad * x_j + regularTerm ]
+//  [ v_jl: partial_grad * x_j * (sum_k v_kl x_k - v_jl x_j) + regularTerm ]
+// The cache of a row is laid out as
+//  [ sum_j v_jl x_j | sum_j v_jl^2 x_j^2 | w_j of the row | v_j of the row ]
+template <RegularType R, int K, bool B>
+struct RowKernel<FM, R, K, B> {
+  static inline real_t Margin(const SparseRow* row,
+                              const real_t* w,
+                              const FactorShape& shape,
+                              real_t* scratch) {
+    index_t k = Latent<K>::Size(shape.k);
+    real_t local[K > 0 ? 2 * K : 1];
+    real_t* sum = K > 0 ? local : scratch;
+    real_t* square = sum + k;
+    Latent<K>::Zero(sum, k);
+    Latent<K>::Zero(square, k);
+    real_t val = w[BIAS];
+    for (index_t j = 0; j < row->size; ++j) {
+      real_t x = Value<B>(row, j);
+      const real_t* v = w + shape.offset + row->idx[j] * k;
+      // linear term, idx begin with 0
+      val += w[row->idx[j] + 1] * x;
+      Latent<K>::Axpy(x, v, sum, k);
+      Latent<K>::Axpy2(x * x, v, v, square, k);
+    }
+    return val + 0.5 * (Latent<K>::Dot(sum, sum, k) -
+                        Latent<K>::Sum(square, k));
+  }
+
+  static inline uint64 CacheSize(const SparseRow* row,
+                                 const FactorShape& shape) {
+    uint64 k = Latent<K>::Size(shape.k);
+    return 2 * k + row->size * (k + 1);
+  }
+
+  static inline void Prefetch(const SparseRow* row,
+                              index_t j,
+                              const real_t* w,
+                              const FactorShape& shape) {
+    index_t k = Latent<K>::Size(shape.k);
+    __builtin_prefetch(w + row->idx[j] + 1, 0, 3);
+    PrefetchRange(w + shape.offset + row->idx[j] * k, k);
+  }
+
+  static inline real_t Gather(const SparseRow* row,
+                              const real_t* w,
+                              const FactorShape& shape,
+                              real_t* cache) {
+    index_t k = Latent<K>::Size(shape.k);
+    real_t* sum = cache;
+    real_t* square = sum + k;
+    real_t* linear = square + k;
+    real_t* latent = linear + row->size;
+    Latent<K>::Zero(sum, k);
+    Latent<K>::Zero(square, k);
+    real_t val = w[BIAS];
+    for (index_t j = 0; j < row->size; ++j) {
+      real_t x = Value<B>(row, j);
+      real_t* v = latent + j * k;
+      // linear term, idx begin with 0
+      linear[j] = w[row->idx[j] + 1];
+      val += linear[j] * x;
+      Latent<K>::Copy(w + shape.offset + row->idx[j] * k, v, k);
+      Latent<K>::Axpy(x, v, sum, k);
+      Latent<K>::Axpy2(x * x, v, v, square, k);
+    }
+    return val + 0.5 * (Latent<K>::Dot(sum, sum, k) -
+                        Latent<K>::Sum(square, k));
+  }
+
+  static inline void Grad(const SparseRow* row,
+                          const FactorShape& shape,
+                          const real_t* cache,
+                          real_t partial_grad,
+                          real_t lambda,
+                          SparseGrad& grad) {
+    index_t k = Latent<K>::Size(shape.k);
+    const real_t* sum = cache;
+    const real_t* linear = sum + 2 * k;
+    const real_t* latent = linear + row->size;
+    // bias term and linear term
+    ReserveGrad(grad.w, grad.pos_w, grad.size_w, row->size + 1);
+    index_t num = grad.size_w;
+    grad.w[num] = partial_grad;
+    grad.pos_w[num] = BIAS;
+    num++;
+    for (index_t j = 0; j < row->size; ++j) {
+      grad.w[num] = partial_grad * Value<B>(row, j) +
+                    lambda * RegularGrad<R>(linear[j]);
+      grad.pos_w[num] = row->idx[j] + 1;
+      num++;
+    }
+    grad.size_w = num;
+    // latent vectors
+    ReserveGrad(grad.v, grad.pos_v, grad.size_v, row->size * k);
+    num = grad.size_v;
+    for (index_t j = 0; j < row->size; ++j) {
+      real_t x = Value<B>(row, j);
+      index_t pos = shape.offset + row->idx[j] * k;
+      const real_t* v = latent + j * k;
+      real_t* g = grad.v.data() + num;
+      index_t* g_pos = grad.pos_v.data() + num;
+      for (index_t l = 0; l < k; ++l) {
+        g[l] = partial_grad * x * (sum[l] - v[l] * x) +
+               lambda * RegularGrad<R>(v[l]);
+        g_pos[l] = pos + l;
+      }
+      num += k;
+    }
+    grad.size_v = num;
+  }
+
+  // |scratch| holds k floats for the sums.
+  static inline void GradFromModel(const SparseRow* row,
+                                   const real_t* w,
+                                   const FactorShape& shape,
+                                   real_t* scratch,
+                                   real_t partial_grad,
+                                   real_t lambda,
+                                   SparseGrad& grad) {
+    index_t k = Latent<K>::Size(shape.k);
+    real_t* sum = scratch;
+    Latent<K>::Zero(sum, k);
+    for (index_t j = 0; j < row->size; ++j) {
+      Latent<K>::Axpy(Value<B>(row, j), w + shape.offset + row->idx[j] * k,
+                      sum, k);
+    }
+    // bias term and linear term
+    ReserveGrad(grad.w, grad.pos_w, grad.size_w, row->size + 1);
+    index_t num = grad.size_w;
+    grad.w[num] = partial_grad;
+    grad.pos_w[num] = BIAS;
+    num++;
+    for (index_t j = 0; j < row->size; ++j) {
+      grad.w[num] = partial_grad * Value<B>(row, j) +
+                    lambda * RegularGrad<R>(w[row->idx[j] + 1]);
+      grad.pos_w[num] = row->idx[j] + 1;
+      num++;
+    }
+    grad.size_w = num;
+    // latent vectors
+    ReserveGrad(grad.v, grad.pos_v, grad.size_v, row->size * k);
+    num = grad.size_v;
+    for (index_t j = 0; j < row->size; ++j) {
+      real_t x = Value<B>(row, j);
+      index_t pos = shape.offset + row->idx[j] * k;
+      const real_t* v = w + pos;
+      real_t* g = grad.v.data() + num;
+      index_t* g_pos = grad.pos_v.data() + num;
+      for (index_t l = 0; l < k; ++l) {
+        g[l] = partial_grad * x * (sum[l] - v[l] * x) +
+               lambda * RegularGrad<R>(v[l]);
+        g_pos[l] = pos + l;
+      }
+      num += k;
+    }
+    grad.size_v = num;
+  }
+};
+
+// Return the position of the latent vector of feature |idx| for
+// field |field|.
+inline index_t FieldPosition(const FactorShape& shape,
+                             index_t idx, index_t field) {
+  return shape.offset + (idx * shape.num_fields + field) * shape.k;
+}
+
+// Return the latent vector of feature |idx| for field |field|.
+inline const real_t* FieldVector(const real_t* w, const FactorShape& shape,
+                                 index_t idx, index_t field) {
+  return w + FieldPosition(shape, idx, field);
+}
+
+// Field-aware factorization machine. Math:
+//  [ <w,x> = w_0 + sum_j w_j * x_j +
+//            sum_{j<k} <v_j_fk, v_k_fj> * x_j * x_k ]
+// and the gradients are
+//  [ bias: partial_grad ]
+//  [ w_j: partial_grad * x_j + regularTerm ]
+//  [ v_j_fk: partial_grad * x_j * x_k * v_k_fj + regularTerm ]
+//  [ v_k_fj: partial_grad * x_j * x_k * v_j_fk + regularTerm ]
+// The cache of a row is laid out as
+//  [ the cross term by factor | w_j of the row |
+//    v_j_fk and v_k_fj of every pair j < k ]
+template <RegularType R, int K, bool B>
+struct RowKernel<FFM, R, K, B> {
+  static inline real_t Margin(const SparseRow* row,
+                              const real_t* w,
+                              const FactorShape& shape,
+                              real_t* scratch) {
+    index_t k = Latent<K>::Size(shape.k);
+    real_t local[K > 0 ? K : 1];
+    real_t* cross = K > 0 ? local : scratch;
+    Latent<K>::Zero(cross, k);
+    real_t val = w[BIAS];
+    for (index_t j = 0; j < row->size; ++j) {
+      // linear term, idx begin with 0
+      real_t x_j = Value<B>(row, j);
+      val += w[row->idx[j] + 1] * x_j;
+      for (index_t t = j + 1; t < row->size; ++t) {
+        const real_t* v_j = FieldVector(w, shape, row->idx[j], row->field[t]);
+        const real_t* v_t = FieldVector(w, shape, row->idx[t], row->field[j]);
+        Latent<K>::Axpy2(x_j * Value<B>(row, t), v_j, v_t, cross, k);
+      }
+    }
+    return val + Latent<K>::Sum(cross, k);
+  }
+
+  static inline uint64 CacheSize(const SparseRow* row,
+                                 const FactorShape& shape) {
+    uint64 k = Latent<K>::Size(shape.k);
+    uint64 size = row->size;
+    return k + size + size * (size - 1) * k;
+  }
+
+  // The latent vectors of a feature for all the fields are
+  // stored together, so we prefetch them as one block instead
+  // of a vector for every pair.
+  static inline void Prefetch(const SparseRow* row,
+                              index_t j,
+                              const real_t* w,
+                              const FactorShape& shape) {
+    __builtin_prefetch(w + row->idx[j] + 1, 0, 3);
+    PrefetchRange(FieldVector(w, shape, row->idx[j], 0),
+                  shape.num_fields * shape.k);
+  }
+
+  static inline real_t Gather(const SparseRow* row,
+                              const real_t* w,
+                              const FactorShape& shape,
+                              real_t* cache) {
+    index_t k = Latent<K>::Size(shape.k);
+    real_t* cross = cache;
+    real_t* linear = cross + k;
+    real_t* v_j = linear + row->size;
+    Latent<K>::Zero(cross, k);
+    real_t val = w[BIAS];
+    for (index_t j = 0; j < row->size; ++j) {
+      // linear term, idx begin with 0
+      linear[j] = w[row->idx[j] + 1];
+      real_t x_j = Value<B>(row, j);
+      val += linear[j] * x_j;
+      for (index_t t = j + 1; t < row->size; ++t) {
+        real_t* v_t = v_j + k;
+        Latent<K>::Copy(FieldVector(w, shape, row->idx[j], row->field[t]),
+                        v_j, k);
+        Latent<K>::Copy(FieldVector(w, shape, row->idx[t], row->field[j]),
+                        v_t, k);
+        Latent<K>::Axpy2(x_j * Value<B>(row, t), v_j, v_t, cross, k);
+        v_j += 2 * k;
+      }
+    }
+    return val + Latent<K>::Sum(cross, k);
+  }
+
+  static inline void Grad(const SparseRow* row,
+                          const FactorShape& shape,
+                          const real_t* cache,
+                          real_t partial_grad,
+                          real_t lambda,
+                          SparseGrad& grad) {
+    index_t k = Latent<K>::Size(shape.k);
+    const real_t* linear = cache + k;
+    const real_t* v_j = linear + row->size;
+    // bias term and linear term
+    ReserveGrad(grad.w, grad.pos_w, grad.size_w, row->size + 1);
+    index_t num = grad.size_w;
+    grad.w[num] = partial_grad;
+    grad.pos_w[num] = BIAS;
+    num++;
+    for (index_t j = 0; j < row->size; ++j) {
+      grad.w[num] = partial_grad * Value<B>(row, j) +
+                    lambda * RegularGrad<R>(linear[j]);
+      grad.pos_w[num] = row->idx[j] + 1;
+      num++;
+    }
+    grad.size_w = num;
+    // latent vectors
+    index_t num_pairs = row->size * (row->size - 1) / 2;
+    ReserveGrad(grad.v, grad.pos_v, grad.size_v, num_pairs * 2 * k);
+    num = grad.size_v;
+    for (index_t j = 0; j < row->size; ++j) {
+      for (index_t t = j + 1; t < row->size; ++t) {
+        const real_t* v_t = v_j + k;
+        index_t pos_j = FieldPosition(shape, row->idx[j], row->field[t]);
+        index_t pos_t = FieldPosition(shape, row->idx[t], row->field[j]);
+        real_t g = partial_grad * Value<B>(row, j) * Value<B>(row, t);
+        real_t* g_j = grad.v.data() + num;
+        real_t* g_t = g_j + k;
+        index_t* g_pos = grad.pos_v.data() + num;
+        for (index_t l = 0; l < k; ++l) {
+          g_j[l] = g * v_t[l] + lambda * RegularGrad<R>(v_j[l]);
+          g_t[l] = g * v_j[l] + lambda * RegularGrad<R>(v_t[l]);
+          g_pos[l] = pos_j + l;
+          g_pos[k + l] = pos_t + l;
+        }
+        num += 2 * k;
+        v_j += 2 * k;
+      }
+    }
+    grad.size_v = num;
+  }
+
+  static inline void GradFromModel(const SparseRow* row,
+                                   const real_t* w,
+                                   const FactorShape& shape,
+                                   real_t* scratch,
+                                   real_t partial_grad,
+                                   real_t lambda,
+                                   SparseGrad& grad) {
+    index_t k = Latent<K>::Size(shape.k);
+    // bias term and linear term
+    ReserveGrad(grad.w, grad.pos_w, grad.size_w, row->size + 1);
+    index_t num = grad.size_w;
+    grad.w[num] = partial_grad;
+    grad.pos_w[num] = BIAS;
+    num++;
+    for (index_t j = 0; j < row->size; ++j) {
+      grad.w[num] = partial_grad * Value<B>(row, j) +
+                    lambda * RegularGrad<R>(w[row->idx[j] + 1]);
+      grad.pos_w[num] = row->idx[j] + 1;
+      num++;
+    }
+    grad.size_w = num;
+    // latent vectors
+    index_t num_pairs = row->size * (row->size - 1) / 2;
+    ReserveGrad(grad.v, grad.pos_v, grad.size_v, num_pairs * 2 * k);
+    num = grad.size_v;
+    for (index_t j = 0; j < row->size; ++j) {
+      for (index_t t = j + 1; t < row->size; ++t) {
+        index_t pos_j = FieldPosition(shape, row->idx[j], row->field[t]);
+        index_t pos_t = FieldPosition(shape, row->idx[t], row->field[j]);
+        const real_t* v_j = w + pos_j;
+        const real_t* v_t = w + pos_t;
+        real_t g = partial_grad * Value<B>(row, j) * Value<B>(row, t);
+        real_t* g_j = grad.v.data() + num;
+        real_t* g_t = g_j + k;
+        index_t* g_pos = grad.pos_v.data() + num;
+        for (index_t l = 0; l < k; ++l) {
+          g_j[l] = g * v_t[l] + lambda * RegularGrad<R>(v_j[l]);
+          g_t[l] = g * v_j[l] + lambda * RegularGrad<R>(v_t[l]);
+          g_pos[l] = pos_j + l;
+          g_pos[k + l] = pos_t + l;
+        }
+        num += 2 * k;
+      }
+    }
+    grad.size_v = num;
+  }
+};
+
+// The fused kernel handles a batch by blocks of at most kFusedRows
+// rows. The partial gradients of a block go through the vectorized
+// sigmoid together, and a block stops growing once its cache reaches
+// kFusedCacheSize floats, so that the cache stays in L2. A row whose
+// own cache is larger than that is handled alone without the cache.
+const index_t kFusedRows = 16;
+const index_t kFusedCacheSize = 64 * 1024;
+
+// Prefetcher walks the features of a batch ahead of the batch kernels.
+template <typename Row>
+class Prefetcher {
+ public:
+  Prefetcher(const DMatrix* matrix,
+             const real_t* w,
+             const FactorShape& shape,
+             index_t distance)
+    : m_matrix(matrix), m_w(w), m_shape(shape), m_distance(distance),
+      m_row(0), m_feature(0), m_ahead(0) {}
+
+  // Called before the kernels handle row |i|. Prefetch the features
+  // up to |distance| features beyond the end of row |i|.
+  inline void Next(index_t i) {
+    if (m_distance == 0) return;
+    if (m_row > i) {
+      // The features of row i are no longer ahead.
+      m_ahead -= m_matrix->row[i]->size;
+    } else {
+      // Too late for the rest of row i.
+      m_row = i + 1;
+      m_feature = 0;
+      m_ahead = 0;
+    }
+    while (m_ahead < m_distance && m_row < m_matrix->row_size) {
+      const SparseRow* row = m_matrix->row[m_row];
+      if (m_feature < row->size) {
+        Row::Prefetch(row, m_feature, m_w, m_shape);
+        m_feature++;
+        m_ahead++;
+      } else {
+        m_row++;
+        m_feature = 0;
+      }
+    }
+  }
+
+ private:
+  const DMatrix* m_matrix;
+  const real_t* m_w;
+  const FactorShape& m_shape;
+  index_t m_distance;
+  index_t m_row;                    // the next feature to prefetch
+  index_t m_feature;                // is m_row->idx[m_feature].
+  index_t m_ahead;                  // prefetched features after the
+                                    // row being handled.
+};
+
+// The kernels of a batch, which only loop over the rows.
+template <ModelType M, RegularType R, int K>
+struct BatchKernel {
+  typedef RowKernel<M, R, K, false> Row;
+  typedef RowKernel<M, R, K, true> BinaryRow;
+
+  static void Margins(const DMatrix* matrix,
+                      const real_t* w,
+                      const FactorShape& shape,
+                      index_t prefetch,
+                      real_t* scratch,
+                      real_t* margin) {
+    Prefetcher<Row> prefetcher(matrix, w, shape, prefetch);
+    for (index_t i = 0; i < matrix->row_size; ++i) {
+      prefetcher.Next(i);
+      const SparseRow* row = matrix->row[i];
+      margin[i] = row->binary ?
+                  BinaryRow::Margin(row, w, shape, scratch) :
+                  Row::Margin(row, w, shape, scratch);
+    }
+  }
+
+  static void Fused(const DMatrix* matrix,
+                    const real_t* w,
+                    const FactorShape& shape,
+                    index_t prefetch,
+                    real_t* scratch,
+                    real_t lambda,
+                    std::vector<real_t>& cache,
+                    real_t* margin,
+                    SparseGrad& grad) {
+    grad.size_w = 0;
+    grad.size_v = 0;
+    uint64 offset[kFusedRows + 1];
+    real_t partial_grad[kFusedRows];
+    Prefetcher<Row> prefetcher(matrix, w, shape, prefetch);
+    for (index_t begin = 0; begin < matrix->row_size; ) {
+      if (Row::CacheSize(matrix->row[begin], shape) > kFusedCacheSize) {
+        prefetcher.Next(begin);
+        Large(matrix, begin, w, shape, scratch, lambda, margin, grad);
+        begin++;
+        continue;
+      }
+      // Every block takes at least one row, and no row
+      // that is too large for the cache.
+      index_t num = 0;
+      offset[0] = 0;
+      do {
+        offset[num + 1] = offset[num] +
+                          Row::CacheSize(matrix->row[begin + num], shape);
+        num++;
+      } while (begin + num < matrix->row_size && num < kFusedRows &&
+               offset[num] < kFusedCacheSize &&
+               Row::CacheSize(matrix->row[begin + num], shape) <=
+                 kFusedCacheSize);
+      if (cache.size() < offset[num]) cache.resize(offset[num]);
+      for (index_t i = 0; i < num; ++i) {
+        prefetcher.Next(begin + i);
+        const SparseRow* row = matrix->row[begin + i];
+        real_t* row_cache = cache.data() + offset[i];
+        margin[begin + i] = row->binary ?
+          BinaryRow::Gather(row, w, shape, row_cache) :
+          Row::Gather(row, w, shape, row_cache);
+      }
+      PartialGrad(matrix->Y.data() + begin, margin + begin,
+                  partial_grad, num);
+      for (index_t i = 0; i < num; ++i) {
+        const SparseRow* row = matrix->row[begin + i];
+        const real_t* row_cache = cache.data() + offset[i];
+        if (row->binary) {
+          BinaryRow::Grad(row, shape, row_cache, partial_grad[i],
+                          lambda, grad);
+        } else {
+          Row::Grad(row, shape, row_cache, partial_grad[i], lambda, grad);
+        }
+      }
+      begin += num;
+    }
+  }
+
+  // Handle row |i| of a batch without the cache.
+  static void Large(const DMatrix* matrix,
+                    index_t i,
+                    const real_t* w,
+                    const FactorShape& shape,
+                    real_t* scratch,
+                    real_t lambda,
+                    real_t* margin,
+                    SparseGrad& grad) {
+    const SparseRow* row = matrix->row[i];
+    margin[i] = row->binary ?
+                BinaryRow::Margin(row, w, shape, scratch) :
+                Row::Margin(row, w, shape, scratch);
+    real_t partial_grad = 0;
+    PartialGrad(matrix->Y.data() + i, margin + i, &partial_grad, 1);
+    if (row->binary) {
+      BinaryRow::GradFromModel(row, w, shape, scratch, partial_grad,
+                               lambda, grad);
+    } else {
+      Row::GradFromModel(row, w, shape, scratch, partial_grad,
+                         lambda, grad);
+    }
+  }
+};
+
+} // namespace f2m
+
+#endif // F2M_LOSS_BATCH_KERNEL_H_
@@ -0,0 +1,164 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file defines the kernels on the latent vectors of FM and FFM.
+The kernels are specialized for the common sizes of latent vectors.
+*/
+
+#ifndef F2M_LOSS_FACTOR_KERNEL_H_
+#define F2M_LOSS_FACTOR_KERNEL_H_
+
+#include <string.h>
+
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/data/data_structure.h"
+
+using std::vector;
+
+namespace f2m {
+
+// The layout of the latent vectors in the model parameters:
+// the vector of feature i (and field f for FFM) begins at
+// offset + (i * num_fields + f) * k.
+struct FactorShape {
+  index_t k;            // size of a latent vector.
+  index_t num_fields;   // number of fields, 1 for FM.
+  index_t offset;       // position of the first latent vector.
+};
+
+// Four floats that the compiler maps to one SIMD register (SSE or NEON).
+typedef real_t Float4 __attribute__((vector_size(16)));
+
+inline Float4 LoadFloat4(const real_t* x) {
+  Float4 v;
+  memcpy(&v, x, sizeof(v));
+  return v;
+}
+
+inline void StoreFloat4(real_t* x, Float4 v) {
+  memcpy(x, &v, sizeof(v));
+}
+
+// Operations on latent vectors of size K. When K > 0 the loops have a
+// constant trip count, so the compiler unrolls them and keeps small
+// vectors in registers. K = 0 is the generic version, which takes the
+// size at run time.
+//
+// When K is a multiple of 4, we write the loops on Float4 explicitly.
+// Otherwise the compiler tends to vectorize the loop over the feature
+// pairs around a fully unrolled kernel, which gathers the latent
+// vectors of four pairs lane by lane and is slower than scalar code.
+// None of the kernels reduces a vector inside a loop, because the
+// compiler cannot vectorize a floating point reduction. The kernels
+// accumulate lane by lane, and call Sum() once for each row.
+template <int K>
+struct Latent {
+  static const bool kVector = K > 0 && K % 4 == 0;
+
+  static inline index_t Size(index_t k) { return K > 0 ? K : k; }
+
+  // y = 0
+  static inline void Zero(real_t* y, index_t k) {
+    for (index_t l = 0; l < Size(k); ++l) y[l] = 0;
+  }
+
+  // y = x
+  static inline void Copy(const real_t* x, real_t* y, index_t k) {
+    if (kVector) {
+      for (index_t l = 0; l < Size(k); l += 4) {
+        StoreFloat4(y + l, LoadFloat4(x + l));
+      }
+      return;
+    }
+    for (index_t l = 0; l < Size(k); ++l) y[l] = x[l];
+  }
+
+  // y += alpha * x
+  static inline void Axpy(real_t alpha, const real_t* x,
+                          real_t* y, index_t k) {
+    if (kVector) {
+      for (index_t l = 0; l < Size(k); l += 4) {
+        StoreFloat4(y + l, LoadFloat4(y + l) + alpha * LoadFloat4(x + l));
+      }
+      return;
+    }
+    for (index_t l = 0; l < Size(k); ++l) y[l] += alpha * x[l];
+  }
+
+  // y += alpha * a .* b
+  static inline void Axpy2(real_t alpha, const real_t* a,
+                           const real_t* b, real_t* y, index_t k) {
+    if (kVector) {
+      for (index_t l = 0; l < Size(k); l += 4) {
+        StoreFloat4(y + l, LoadFloat4(y + l) +
+                    alpha * LoadFloat4(a + l) * LoadFloat4(b + l));
+      }
+      return;
+    }
+    for (index_t l = 0; l < Size(k); ++l) y[l] += alpha * a[l] * b[l];
+  }
+
+  // Return the sum of x.
+  static inline real_t Sum(const real_t* x, index_t k) {
+    real_t sum = 0;
+    for (index_t l = 0; l < Size(k); ++l) sum += x[l];
+    return sum;
+  }
+
+  // Return the sum of a .* b.
+  static inline real_t Dot(const real_t* a, const real_t* b, index_t k) {
+    real_t sum = 0;
+    for (index_t l = 0; l < Size(k); ++l) sum += a[l] * b[l];
+    return sum;
+  }
+};
+
+// The largest K that has a specialized kernel. The kernels keep
+// 2 * K floats on the stack, and use a scratch buffer for larger k.
+const index_t kMaxSpecializedK = 64;
+
+// Call Table::Get<K>() with K = k if k is one of the specialized
+// sizes, or with K = 0 otherwise. We select the kernels once for a
+// model, rather than switching on k for every row.
+template <typename Table>
+typename Table::Kernel SelectFactorKernel(index_t k) {
+  switch (k) {
+    case 2: return Table::template Get<2>();
+    case 4: return Table::template Get<4>();
+    case 8: return Table::template Get<8>();
+    case 16: return Table::template Get<16>();
+    case 32: return Table::template Get<32>();
+    case 64: return Table::template Get<64>();
+    default: return Table::template Get<0>();
+  }
+}
+
+// Make room for |num| more gradients after the first |size| ones.
+inline void ReserveGrad(vector<real_t>& value, vector<index_t>& pos,
+                        index_t size, index_t num) {
+  if (size + num > value.size()) {
+    index_t capacity = value.size() > 0 ? value.size() * 2 : num;
+    if (capacity < size + num) capacity = size + num;
+    value.resize(capacity);
+    pos.resize(capacity);
+  }
+}
+
+} // namespace f2m
+
+#endif // F2M_LOSS_FACTOR_KERNEL_H_
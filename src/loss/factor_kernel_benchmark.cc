@@ -0,0 +1,110 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file measures the FM and FFM losses for sizes of latent vectors
+that have a specialized kernel (k) and that do not (k + 1). The
+rows are binary rows, which do not store their values of 1, if
+binary is 1.
+
+Usage: factor_kernel_benchmark [row_size] [repeat] [binary]
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <vector>
+
+#include "src/base/timer.h"
+#include "src/data/data_structure.h"
+#include "src/data/hyper_parameters.h"
+#include "src/data/model_parameters.h"
+#include "src/loss/ffm_loss.h"
+#include "src/loss/fm_loss.h"
+#include "src/loss/loss.h"
+
+using namespace f2m;
+
+const index_t kNumFeatures = 100000;
+const index_t kNumFields = 8;
+const index_t kNumRows = 1000;
+
+// Return nanoseconds per row of Predict() and CalcGrad().
+void Measure(Loss* loss, Model& model, const DMatrix& matrix,
+             int repeat, double* predict, double* grad) {
+  vector<real_t> pred(matrix.row_size);
+  SparseGrad sparse_grad(model.GetModelType());
+  loss->Predict(&matrix, model, pred);  // warm up
+  Timer timer;
+  for (int i = 0; i < repeat; ++i) {
+    loss->Predict(&matrix, model, pred);
+  }
+  *predict = timer.Elapsed() * 1e9 / (matrix.row_size * repeat);
+  loss->CalcGrad(&matrix, model, sparse_grad);
+  timer.Reset();
+  for (int i = 0; i < repeat; ++i) {
+    loss->CalcGrad(&matrix, model, sparse_grad);
+  }
+  *grad = timer.Elapsed() * 1e9 / (matrix.row_size * repeat);
+}
+
+int main(int argc, char* argv[]) {
+  index_t row_size = argc > 1 ? atoi(argv[1]) : 20;
+  int repeat = argc > 2 ? atoi(argv[2]) : 20;
+  bool binary = argc > 3 ? atoi(argv[3]) != 0 : false;
+  F2M_PARAM hyperparam;
+  hyperparam.regu_lambda = 0.001;
+  hyperparam.regu_type = L2;
+  DMatrix fm_matrix(kNumRows, FM), ffm_matrix(kNumRows, FFM);
+  fm_matrix.InitSparseRow();
+  ffm_matrix.InitSparseRow();
+  for (index_t i = 0; i < kNumRows; ++i) {
+    fm_matrix.row[i]->resize(row_size);
+    ffm_matrix.row[i]->resize(row_size);
+    fm_matrix.Y[i] = ffm_matrix.Y[i] = i % 2;
+    for (index_t j = 0; j < row_size; ++j) {
+      fm_matrix.row[i]->idx[j] = ffm_matrix.row[i]->idx[j] =
+        rand() % kNumFeatures;
+      fm_matrix.row[i]->X[j] = ffm_matrix.row[i]->X[j] = 1.0;
+      ffm_matrix.row[i]->field[j] = j % kNumFields;
+    }
+    fm_matrix.row[i]->set_binary(binary);
+    ffm_matrix.row[i]->set_binary(binary);
+  }
+  const index_t kSizes[] = { 2, 4, 8, 16, 32, 64 };
+  printf("row_size = %u, repeat = %d, binary = %d, ns/row\n",
+         row_size, repeat, binary);
+  printf("%-4s %-6s %10s %10s %10s %10s\n", "k", "loss",
+         "predict", "k+1", "grad", "k+1");
+  for (int s = 0; s < 6; ++s) {
+    for (int type = FM; type <= FFM; ++type) {
+      double predict[2], grad[2];
+      for (int generic = 0; generic < 2; ++generic) {
+        index_t k = kSizes[s] + generic;
+        Model model(kNumFeatures, hyperparam, static_cast<ModelType>(type),
+                    k, kNumFields, true);
+        FMLoss fm_loss(L2);
+        FFMLoss ffm_loss(L2);
+        Loss* loss = type == FM ? static_cast<Loss*>(&fm_loss) : &ffm_loss;
+        Measure(loss, model, type == FM ? fm_matrix : ffm_matrix,
+                repeat, &predict[generic], &grad[generic]);
+      }
+      printf("%-4u %-6s %10.1f %10.1f %10.1f %10.1f\n", kSizes[s],
+             type == FM ? "FM" : "FFM", predict[0], predict[1],
+             grad[0], grad[1]);
+    }
+  }
+  return 0;
+}
@@ -13,7 +13,6 @@
  *  See the License for the specific language governing permissions and       *
  *  limitations under the License.                                            *
  * -------------------------------------------------------------------------- */
-
 /*
  
  This file defines the loss of field-aware factorization machine.
@@ -44,16 +43,10 @@ namespace f2m {
                     Model& model,
                     SparseGrad& grad);
       
-      
    private:
-      inline real_t wTx(const SparseRow* row, const vector<real_t>* w, const Model& model);
-      
       DISALLOW_COPY_AND_ASSIGN(FFMLoss);
    };
    
-   
 }
 
-
-
-#endif // _F2M_LOSS_FFM_LOSS_H
\ No newline at end of file
+#endif // _F2M_LOSS_FFM_LOSS_H
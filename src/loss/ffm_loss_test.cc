@@ -0,0 +1,307 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file tests ffm_loss.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <vector>
+
+#include "src/data/data_structure.h"
+#include "src/data/hyper_parameters.h"
+#include "src/data/model_parameters.h"
+#include "src/loss/ffm_loss.h"
+
+namespace f2m {
+
+const index_t kNumFeatures = 50;
+const index_t kNumFields = 4;
+const index_t kNumRows = 20;
+const index_t kRowSize = 6;
+
+void MakeRows(DMatrix& matrix) {
+  matrix.resize(kNumRows);
+  matrix.InitSparseRow();
+  for (index_t i = 0; i < kNumRows; ++i) {
+    SparseRow* row = matrix.row[i];
+    row->resize(kRowSize);
+    matrix.Y[i] = i % 2 ? 1 : -1;
+    for (index_t j = 0; j < kRowSize; ++j) {
+      row->field[j] = j % kNumFields;
+      row->idx[j] = (i * 7 + j * 5) % kNumFeatures;
+      row->X[j] = 0.5 + 0.1 * j;
+    }
+  }
+}
+
+// Return the latent vector of feature |idx| for field |field|.
+const real_t* Vector(Model& model, index_t idx, index_t field) {
+  index_t k = model.GetSizeOfVector();
+  return model.GetParameter()->data() + kNumFeatures + 1 +
+         (idx * kNumFields + field) * k;
+}
+
+// Compute the margins and the gradients of every parameter by the
+// pairwise definition, with L2 regularization of strength |lambda|.
+void PairwiseReference(DMatrix& matrix, Model& model, double lambda,
+                       vector<double>* margins, vector<double>* expected) {
+  index_t k = model.GetSizeOfVector();
+  real_t* w = model.GetParameter()->data();
+  margins->assign(matrix.row_size, 0);
+  expected->assign(model.GetNumberOfParameters(), 0);
+  for (index_t i = 0; i < matrix.row_size; ++i) {
+    SparseRow* row = matrix.row[i];
+    double margin = w[0];
+    for (index_t j = 0; j < row->size; ++j) {
+      margin += w[row->idx[j] + 1] * row->X[j];
+      for (index_t t = j + 1; t < row->size; ++t) {
+        const real_t* v_j = Vector(model, row->idx[j], row->field[t]);
+        const real_t* v_t = Vector(model, row->idx[t], row->field[j]);
+        for (index_t l = 0; l < k; ++l) {
+          margin += v_j[l] * v_t[l] * row->X[j] * row->X[t];
+        }
+      }
+    }
+    (*margins)[i] = margin;
+    double y = matrix.Y[i];
+    double partial_grad = -y / (exp(y * margin) + 1);
+    (*expected)[0] += partial_grad;
+    for (index_t j = 0; j < row->size; ++j) {
+      index_t pos = row->idx[j] + 1;
+      (*expected)[pos] += partial_grad * row->X[j] + lambda * w[pos];
+      for (index_t t = 0; t < row->size; ++t) {
+        if (t == j) continue;
+        index_t pos_j = Vector(model, row->idx[j], row->field[t]) - w;
+        const real_t* v_t = Vector(model, row->idx[t], row->field[j]);
+        for (index_t l = 0; l < k; ++l) {
+          (*expected)[pos_j + l] +=
+            partial_grad * row->X[j] * row->X[t] * v_t[l] +
+            lambda * w[pos_j + l];
+        }
+      }
+    }
+  }
+}
+
+// Add up the gradients of every parameter.
+vector<double> DenseGrad(const SparseGrad& grad, index_t num_parameters) {
+  vector<double> dense(num_parameters, 0);
+  for (index_t i = 0; i < grad.size_w; ++i) {
+    dense[grad.pos_w[i]] += grad.w[i];
+  }
+  for (index_t i = 0; i < grad.size_v; ++i) {
+    dense[grad.pos_v[i]] += grad.v[i];
+  }
+  return dense;
+}
+
+TEST(FFMLoss, MatchesPairwiseDefinition) {
+  // Both the specialized and the generic sizes.
+  const index_t kSizes[] = { 2, 3, 4, 8, 16, 32, 64, 100 };
+  F2M_PARAM hyperparam;
+  hyperparam.regu_lambda = 0;
+  hyperparam.regu_type = NONE;
+  DMatrix matrix(FFM);
+  MakeRows(matrix);
+  FFMLoss loss(NONE);
+  for (int s = 0; s < 8; ++s) {
+    index_t k = kSizes[s];
+    Model model(kNumFeatures, hyperparam, FFM, k, kNumFields, true);
+    real_t* w = model.GetParameter()->data();
+    index_t num_parameters = model.GetNumberOfParameters();
+    // Make the cross terms as large as the linear terms.
+    for (index_t i = 0; i < num_parameters; ++i) {
+      w[i] *= 30;
+    }
+    vector<real_t> pred(kNumRows);
+    loss.Predict(&matrix, model, pred);
+    vector<double> margins, expected;
+    PairwiseReference(matrix, model, 0, &margins, &expected);
+    for (index_t i = 0; i < kNumRows; ++i) {
+      EXPECT_NEAR(pred[i], margins[i], 1e-4 * (1 + fabs(margins[i])));
+    }
+    SparseGrad grad(FFM);
+    loss.CalcGrad(&matrix, model, grad);
+    EXPECT_EQ(grad.size_w, kNumRows * (kRowSize + 1));
+    EXPECT_EQ(grad.size_v, kNumRows * kRowSize * (kRowSize - 1) * k);
+    vector<double> actual = DenseGrad(grad, num_parameters);
+    for (index_t i = 0; i < num_parameters; ++i) {
+      ASSERT_NEAR(actual[i], expected[i], 1e-4 * (1 + fabs(expected[i])))
+        << "k = " << k;
+    }
+  }
+}
+
+// The fused pass must agree with the pairwise definition, with
+// the regularization. CalcGrad() also goes through the fused
+// pass, so it is no reference.
+TEST(FFMLoss, PredictAndCalcGrad) {
+  F2M_PARAM hyperparam;
+  hyperparam.regu_lambda = 0.1;
+  hyperparam.regu_type = L2;
+  DMatrix matrix(FFM);
+  MakeRows(matrix);
+  FFMLoss loss(L2);
+  // A specialized and a generic size.
+  for (index_t k = 3; k <= 4; ++k) {
+    Model model(kNumFeatures, hyperparam, FFM, k, kNumFields, true);
+    vector<double> margins, expected;
+    PairwiseReference(matrix, model, hyperparam.regu_lambda,
+                      &margins, &expected);
+    vector<real_t> pred;
+    SparseGrad grad(FFM);
+    loss.PredictAndCalcGrad(&matrix, model, pred, grad);
+    ASSERT_EQ(pred.size(), kNumRows);
+    for (index_t i = 0; i < kNumRows; ++i) {
+      EXPECT_NEAR(pred[i], margins[i], 1e-5 * (1 + fabs(margins[i])));
+    }
+    vector<double> actual = DenseGrad(grad, model.GetNumberOfParameters());
+    for (index_t i = 0; i < actual.size(); ++i) {
+      ASSERT_NEAR(actual[i], expected[i], 1e-5 * (1 + fabs(expected[i])))
+        << "k = " << k;
+    }
+  }
+}
+
+// A row too large for the cache of the fused pass is handled
+// without it, and must give the same results.
+TEST(FFMLoss, LargeRows) {
+  // k * n * (n - 1) of a long row is larger than kFusedCacheSize.
+  const index_t kLongRowSize = 160;
+  F2M_PARAM hyperparam;
+  hyperparam.regu_lambda = 0.1;
+  hyperparam.regu_type = L2;
+  DMatrix matrix(FFM);
+  MakeRows(matrix);
+  // Every third row is long, in between the short ones.
+  for (index_t i = 1; i < kNumRows; i += 3) {
+    SparseRow* row = matrix.row[i];
+    row->resize(kLongRowSize);
+    for (index_t j = 0; j < kLongRowSize; ++j) {
+      row->field[j] = j % kNumFields;
+      row->idx[j] = (i * 7 + j * 3) % kNumFeatures;
+      row->X[j] = 0.1 + 0.01 * (j % 10);
+    }
+  }
+  FFMLoss loss(L2);
+  // A specialized and a generic size.
+  for (index_t k = 3; k <= 4; ++k) {
+    Model model(kNumFeatures, hyperparam, FFM, k, kNumFields, true);
+    vector<double> margins, expected;
+    PairwiseReference(matrix, model, hyperparam.regu_lambda,
+                      &margins, &expected);
+    vector<real_t> pred;
+    SparseGrad grad(FFM);
+    loss.PredictAndCalcGrad(&matrix, model, pred, grad);
+    for (index_t i = 0; i < kNumRows; ++i) {
+      EXPECT_NEAR(pred[i], margins[i], 1e-4 * (1 + fabs(margins[i])));
+    }
+    vector<double> actual = DenseGrad(grad, model.GetNumberOfParameters());
+    for (index_t i = 0; i < actual.size(); ++i) {
+      ASSERT_NEAR(actual[i], expected[i], 1e-4 * (1 + fabs(expected[i])))
+        << "k = " << k;
+    }
+  }
+}
+
+// The binary rows must give the same results as the rows
+// that store their values of 1.
+TEST(FFMLoss, BinaryRows) {
+  F2M_PARAM hyperparam;
+  hyperparam.regu_lambda = 0.1;
+  hyperparam.regu_type = L2;
+  DMatrix matrix(FFM), binary_matrix(FFM);
+  MakeRows(matrix);
+  MakeRows(binary_matrix);
+  for (index_t i = 0; i < kNumRows; ++i) {
+    for (index_t j = 0; j < kRowSize; ++j) {
+      matrix.row[i]->X[j] = 1;
+      binary_matrix.row[i]->X[j] = 1;
+    }
+    // Every other row is binary.
+    binary_matrix.row[i]->set_binary(i % 2 == 0);
+  }
+  FFMLoss loss(L2);
+  // A specialized and a generic size.
+  for (index_t k = 3; k <= 4; ++k) {
+    Model model(kNumFeatures, hyperparam, FFM, k, kNumFields, true);
+    vector<real_t> expected_pred(kNumRows), binary_pred(kNumRows);
+    loss.Predict(&matrix, model, expected_pred);
+    loss.Predict(&binary_matrix, model, binary_pred);
+    SparseGrad expected_grad(FFM);
+    vector<real_t> pred;
+    SparseGrad grad(FFM);
+    loss.PredictAndCalcGrad(&matrix, model, pred, expected_grad);
+    loss.PredictAndCalcGrad(&binary_matrix, model, pred, grad);
+    for (index_t i = 0; i < kNumRows; ++i) {
+      EXPECT_FLOAT_EQ(binary_pred[i], expected_pred[i]);
+      EXPECT_FLOAT_EQ(pred[i], expected_pred[i]);
+    }
+    ASSERT_EQ(grad.size_w, expected_grad.size_w);
+    ASSERT_EQ(grad.size_v, expected_grad.size_v);
+    for (index_t i = 0; i < grad.size_w; ++i) {
+      EXPECT_EQ(grad.pos_w[i], expected_grad.pos_w[i]);
+      EXPECT_FLOAT_EQ(grad.w[i], expected_grad.w[i]);
+    }
+    for (index_t i = 0; i < grad.size_v; ++i) {
+      EXPECT_EQ(grad.pos_v[i], expected_grad.pos_v[i]);
+      EXPECT_FLOAT_EQ(grad.v[i], expected_grad.v[i]);
+    }
+  }
+}
+
+// Prefetching must not change the results, whatever the distance,
+// and must not read beyond the batch.
+TEST(FFMLoss, PrefetchDistance) {
+  F2M_PARAM hyperparam;
+  hyperparam.regu_lambda = 0.1;
+  hyperparam.regu_type = L2;
+  DMatrix matrix(FFM);
+  MakeRows(matrix);
+  // Some empty rows for the prefetcher to skip.
+  for (index_t i = 0; i < kNumRows; i += 3) {
+    matrix.row[i]->resize(0);
+  }
+  Model model(kNumFeatures, hyperparam, FFM, 4, kNumFields, true);
+  FFMLoss loss(L2);
+  loss.SetPrefetchDistance(0);
+  vector<real_t> expected_pred;
+  SparseGrad expected_grad(FFM);
+  loss.PredictAndCalcGrad(&matrix, model, expected_pred, expected_grad);
+  const index_t kDistances[] = { 1, 5, kRowSize, 1000 };
+  for (int d = 0; d < 4; ++d) {
+    loss.SetPrefetchDistance(kDistances[d]);
+    vector<real_t> pred;
+    SparseGrad grad(FFM);
+    loss.PredictAndCalcGrad(&matrix, model, pred, grad);
+    EXPECT_EQ(pred, expected_pred);
+    ASSERT_EQ(grad.size_w, expected_grad.size_w);
+    ASSERT_EQ(grad.size_v, expected_grad.size_v);
+    for (index_t i = 0; i < grad.size_w; ++i) {
+      EXPECT_EQ(grad.w[i], expected_grad.w[i]);
+    }
+    for (index_t i = 0; i < grad.size_v; ++i) {
+      EXPECT_EQ(grad.v[i], expected_grad.v[i]);
+    }
+    vector<real_t> predict(kNumRows);
+    loss.Predict(&matrix, model, predict);
+    EXPECT_EQ(predict, expected_pred);
+  }
+}
+
+} // namespace f2m
@@ -13,7 +13,6 @@
  *  See the License for the specific language governing permissions and       *
  *  limitations under the License.                                            *
  * -------------------------------------------------------------------------- */
-
 /*
  
  This file defines the factorization machine loss.
@@ -43,21 +42,11 @@ class FMLoss : public Loss {
    void CalcGrad(const DMatrix* matrix,
                  Model& model,
                  SparseGrad& grad);
-      
-      
- private:
-   inline real_t wTx(const SparseRow* row, const vector<real_t>* w, const Model& model);
    
+ private:
    DISALLOW_COPY_AND_ASSIGN(FMLoss);
 };
    
-   
-   
-   
-   
-   
 }
 
-
-
-#endif // _F2M_LOSS_FM_LOSS_H
\ No newline at end of file
+#endif // _F2M_LOSS_FM_LOSS_H
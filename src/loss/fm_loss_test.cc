@@ -0,0 +1,262 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file tests fm_loss.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <vector>
+
+#include "src/data/data_structure.h"
+#include "src/data/hyper_parameters.h"
+#include "src/data/model_parameters.h"
+#include "src/loss/fm_loss.h"
+
+namespace f2m {
+
+const index_t kNumFeatures = 50;
+const index_t kNumRows = 20;
+const index_t kRowSize = 8;
+
+void MakeRows(DMatrix& matrix) {
+  matrix.resize(kNumRows);
+  matrix.InitSparseRow();
+  for (index_t i = 0; i < kNumRows; ++i) {
+    SparseRow* row = matrix.row[i];
+    row->resize(kRowSize);
+    matrix.Y[i] = i % 2 ? 1 : -1;
+    for (index_t j = 0; j < kRowSize; ++j) {
+      row->idx[j] = (i * 7 + j * 5) % kNumFeatures;
+      row->X[j] = 0.5 + 0.1 * j;
+    }
+  }
+}
+
+// Return the latent vector of feature |idx|.
+const real_t* Vector(Model& model, index_t idx) {
+  index_t k = model.GetSizeOfVector();
+  return model.GetParameter()->data() + kNumFeatures + 1 + idx * k;
+}
+
+// <w,x> by the pairwise definition of FM.
+double Margin(Model& model, const SparseRow* row) {
+  const real_t* w = model.GetParameter()->data();
+  index_t k = model.GetSizeOfVector();
+  double val = w[0];
+  for (index_t j = 0; j < row->size; ++j) {
+    val += w[row->idx[j] + 1] * row->X[j];
+    for (index_t t = j + 1; t < row->size; ++t) {
+      const real_t* v_j = Vector(model, row->idx[j]);
+      const real_t* v_t = Vector(model, row->idx[t]);
+      for (index_t l = 0; l < k; ++l) {
+        val += v_j[l] * v_t[l] * row->X[j] * row->X[t];
+      }
+    }
+  }
+  return val;
+}
+
+// Compute the gradients of every parameter by the pairwise
+// definition, with L2 regularization of strength |lambda|.
+vector<double> PairwiseGrad(DMatrix& matrix, Model& model, double lambda) {
+  const real_t* w = model.GetParameter()->data();
+  index_t k = model.GetSizeOfVector();
+  vector<double> expected(model.GetNumberOfParameters(), 0);
+  for (index_t i = 0; i < matrix.row_size; ++i) {
+    SparseRow* row = matrix.row[i];
+    double margin = Margin(model, row);
+    double y = matrix.Y[i];
+    double partial_grad = -y / (exp(y * margin) + 1);
+    expected[0] += partial_grad;
+    for (index_t j = 0; j < row->size; ++j) {
+      index_t pos = row->idx[j] + 1;
+      expected[pos] += partial_grad * row->X[j] + lambda * w[pos];
+      index_t pos_j = Vector(model, row->idx[j]) - w;
+      for (index_t l = 0; l < k; ++l) {
+        expected[pos_j + l] += lambda * w[pos_j + l];
+      }
+      for (index_t t = 0; t < row->size; ++t) {
+        if (t == j) continue;
+        const real_t* v_t = Vector(model, row->idx[t]);
+        for (index_t l = 0; l < k; ++l) {
+          expected[pos_j + l] +=
+            partial_grad * row->X[j] * row->X[t] * v_t[l];
+        }
+      }
+    }
+  }
+  return expected;
+}
+
+// Add up the gradients of every parameter.
+vector<double> DenseGrad(const SparseGrad& grad, index_t num_parameters) {
+  vector<double> dense(num_parameters, 0);
+  for (index_t i = 0; i < grad.size_w; ++i) {
+    dense[grad.pos_w[i]] += grad.w[i];
+  }
+  for (index_t i = 0; i < grad.size_v; ++i) {
+    dense[grad.pos_v[i]] += grad.v[i];
+  }
+  return dense;
+}
+
+TEST(FMLoss, MatchesPairwiseDefinition) {
+  // Both the specialized and the generic sizes.
+  const index_t kSizes[] = { 2, 3, 4, 8, 16, 32, 64, 100 };
+  F2M_PARAM hyperparam;
+  hyperparam.regu_lambda = 0;
+  hyperparam.regu_type = NONE;
+  DMatrix matrix(FM);
+  MakeRows(matrix);
+  FMLoss loss(NONE);
+  for (int s = 0; s < 8; ++s) {
+    index_t k = kSizes[s];
+    Model model(kNumFeatures, hyperparam, FM, k, 0, true);
+    real_t* w = model.GetParameter()->data();
+    index_t num_parameters = model.GetNumberOfParameters();
+    // Make the cross terms as large as the linear terms.
+    for (index_t i = 0; i < num_parameters; ++i) {
+      w[i] *= 30;
+    }
+    vector<real_t> pred(kNumRows);
+    loss.Predict(&matrix, model, pred);
+    for (index_t i = 0; i < kNumRows; ++i) {
+      double margin = Margin(model, matrix.row[i]);
+      EXPECT_NEAR(pred[i], margin, 1e-4 * (1 + fabs(margin)));
+    }
+    vector<double> expected = PairwiseGrad(matrix, model, 0);
+    SparseGrad grad(FM);
+    loss.CalcGrad(&matrix, model, grad);
+    EXPECT_EQ(grad.size_w, kNumRows * (kRowSize + 1));
+    EXPECT_EQ(grad.size_v, kNumRows * kRowSize * k);
+    vector<double> actual = DenseGrad(grad, num_parameters);
+    for (index_t i = 0; i < num_parameters; ++i) {
+      ASSERT_NEAR(actual[i], expected[i], 1e-4 * (1 + fabs(expected[i])))
+        << "k = " << k;
+    }
+  }
+}
+
+TEST(FMLoss, Regularizer) {
+  const real_t kLambda = 0.1;
+  F2M_PARAM hyperparam;
+  hyperparam.regu_lambda = kLambda;
+  hyperparam.regu_type = L2;
+  DMatrix matrix(FM);
+  MakeRows(matrix);
+  Model model(kNumFeatures, hyperparam, FM, 4, 0, true);
+  real_t* w = model.GetParameter()->data();
+  FMLoss none_loss(NONE), l1_loss(L1), l2_loss(L2);
+  SparseGrad none(FM), l1(FM), l2(FM);
+  none_loss.CalcGrad(&matrix, model, none);
+  l1_loss.CalcGrad(&matrix, model, l1);
+  l2_loss.CalcGrad(&matrix, model, l2);
+  ASSERT_EQ(l2.size_w, none.size_w);
+  ASSERT_EQ(l2.size_v, none.size_v);
+  for (index_t i = 0; i < none.size_w; ++i) {
+    // The bias is not regularized.
+    real_t reg = none.pos_w[i] == BIAS ? 0 : w[none.pos_w[i]];
+    EXPECT_NEAR(l2.w[i] - none.w[i], kLambda * reg, 1e-6);
+    real_t sign = reg > 0 ? 1 : (reg < 0 ? -1 : 0);
+    EXPECT_NEAR(l1.w[i] - none.w[i], kLambda * sign, 1e-6);
+  }
+  for (index_t i = 0; i < none.size_v; ++i) {
+    real_t reg = w[none.pos_v[i]];
+    EXPECT_NEAR(l2.v[i] - none.v[i], kLambda * reg, 1e-6);
+    EXPECT_NEAR(l1.v[i] - none.v[i], kLambda * (reg > 0 ? 1 : -1), 1e-6);
+  }
+}
+
+// The fused pass must agree with the pairwise definition, with
+// the regularization. CalcGrad() also goes through the fused
+// pass, so it is no reference.
+TEST(FMLoss, PredictAndCalcGrad) {
+  F2M_PARAM hyperparam;
+  hyperparam.regu_lambda = 0.1;
+  hyperparam.regu_type = L2;
+  DMatrix matrix(FM);
+  MakeRows(matrix);
+  FMLoss loss(L2);
+  // A specialized and a generic size.
+  for (index_t k = 3; k <= 4; ++k) {
+    Model model(kNumFeatures, hyperparam, FM, k, 0, true);
+    vector<double> expected = PairwiseGrad(matrix, model,
+                                           hyperparam.regu_lambda);
+    vector<real_t> pred;
+    SparseGrad grad(FM);
+    loss.PredictAndCalcGrad(&matrix, model, pred, grad);
+    ASSERT_EQ(pred.size(), kNumRows);
+    for (index_t i = 0; i < kNumRows; ++i) {
+      double margin = Margin(model, matrix.row[i]);
+      EXPECT_NEAR(pred[i], margin, 1e-5 * (1 + fabs(margin)));
+    }
+    vector<double> actual = DenseGrad(grad, model.GetNumberOfParameters());
+    for (index_t i = 0; i < actual.size(); ++i) {
+      ASSERT_NEAR(actual[i], expected[i], 1e-5 * (1 + fabs(expected[i])))
+        << "k = " << k;
+    }
+  }
+}
+
+// The binary rows must give the same results as the rows
+// that store their values of 1.
+TEST(FMLoss, BinaryRows) {
+  F2M_PARAM hyperparam;
+  hyperparam.regu_lambda = 0.1;
+  hyperparam.regu_type = L2;
+  DMatrix matrix(FM), binary_matrix(FM);
+  MakeRows(matrix);
+  MakeRows(binary_matrix);
+  for (index_t i = 0; i < kNumRows; ++i) {
+    for (index_t j = 0; j < kRowSize; ++j) {
+      matrix.row[i]->X[j] = 1;
+      binary_matrix.row[i]->X[j] = 1;
+    }
+    // Every other row is binary.
+    binary_matrix.row[i]->set_binary(i % 2 == 0);
+  }
+  FMLoss loss(L2);
+  // A specialized and a generic size.
+  for (index_t k = 3; k <= 4; ++k) {
+    Model model(kNumFeatures, hyperparam, FM, k, 0, true);
+    vector<real_t> expected_pred(kNumRows), binary_pred(kNumRows);
+    loss.Predict(&matrix, model, expected_pred);
+    loss.Predict(&binary_matrix, model, binary_pred);
+    SparseGrad expected_grad(FM);
+    vector<real_t> pred;
+    SparseGrad grad(FM);
+    loss.PredictAndCalcGrad(&matrix, model, pred, expected_grad);
+    loss.PredictAndCalcGrad(&binary_matrix, model, pred, grad);
+    for (index_t i = 0; i < kNumRows; ++i) {
+      EXPECT_FLOAT_EQ(binary_pred[i], expected_pred[i]);
+      EXPECT_FLOAT_EQ(pred[i], expected_pred[i]);
+    }
+    ASSERT_EQ(grad.size_w, expected_grad.size_w);
+    ASSERT_EQ(grad.size_v, expected_grad.size_v);
+    for (index_t i = 0; i < grad.size_w; ++i) {
+      EXPECT_EQ(grad.pos_w[i], expected_grad.pos_w[i]);
+      EXPECT_FLOAT_EQ(grad.w[i], expected_grad.w[i]);
+    }
+    for (index_t i = 0; i < grad.size_v; ++i) {
+      EXPECT_EQ(grad.pos_v[i], expected_grad.pos_v[i]);
+      EXPECT_FLOAT_EQ(grad.v[i], expected_grad.v[i]);
+    }
+  }
+}
+
+} // namespace f2m
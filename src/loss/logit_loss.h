@@ -48,15 +48,12 @@ class LogitLoss : public Loss {
   void Predict(const DMatrix* matrix,
                Model& param,
                vector<real_t>& pred) {
+    F2M_PROFILE_SCOPE(PROFILE_PREDICT);
     CHECK_NOTNULL(matrix);
     CHECK_GT(pred.size(), 0);
-    CHECK_EQ(pred.size(), matrix->row_size);
-    vector<real_t>* weight = param.GetParameter();
-    // each line of test examples
-    for (index_t i = 0; i < matrix->row_size; ++i) {
-      SparseRow* row = matrix->row[i];
-      pred[i] = wTx(row, weight);
-    }
+    CalcMargins(matrix, param, pred);
+    F2M_PROFILE_COUNT(PROFILE_PREDICT, matrix->row_size,
+                      NumberOfNonZero(matrix), 0);
   }
 
   // Given the prediction results and the current model, return
@@ -65,43 +62,15 @@ class LogitLoss : public Loss {
   void CalcGrad(const DMatrix* matrix,
                 Model& param,
                 SparseGrad& grad) {
+    F2M_PROFILE_SCOPE(PROFILE_GRAD);
     CHECK_NOTNULL(matrix);
     CHECK_GT(matrix->row_size, 0);
-    vector<real_t>* weight = param.GetParameter();
-    index_t num  = 0;
-    // each line of trainning examples
-    for (index_t i = 0; i < matrix->row_size; ++i) {
-      // partial gradient 
-      SparseRow* row = matrix->row[i];
-      real_t y = matrix->Y[i];
-      real_t partial_grad = -y / ((1.0 / exp(-y*wTx(row, weight))) + 1);
-      // for every entry
-      for (index_t j = 0; j < row->size; ++j) {
-        index_t pos = row->idx[j];
-        real_t w_j = partial_grad * row->X[j];
-        if (num >= grad.w.size()) {
-          // resize
-          grad.w.resize(grad.w.size()*2);
-        } 
-        grad.w[num] = w_j;
-        grad.pos_w[num] = pos;
-        num++;
-      }
-    }
-    grad.size_w = num;
+    F2M_PROFILE_COUNT(PROFILE_GRAD, matrix->row_size,
+                      NumberOfNonZero(matrix), 0);
+    CalcGradients(matrix, param, grad);
   }
 
  private:
-  // Calculate <w,x>
-  inline real_t wTx(const SparseRow* row, const vector<real_t>* w) {
-    real_t val = 0.0;
-    for (index_t j = 0; j < row->size; ++j) {
-      index_t pos = row->idx[j];
-      val += (*w)[pos] * row->X[j];
-    }
-    return val;
-  }
-
   DISALLOW_COPY_AND_ASSIGN(LogitLoss);
 };
 
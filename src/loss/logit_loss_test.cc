@@ -25,6 +25,7 @@ This file tests logit_loss.h
 #include <string>
 #include <vector>
 
+#include "src/data/hyper_parameters.h"
 #include "src/loss/logit_loss.h"
 #include "src/data/data_structure.h"
 #include "src/data/model_parameters.h"
@@ -88,4 +89,50 @@ TEST(LogitLoss, Predict) {
   }
 }*/
 
+TEST(LogitLoss, BatchedGradMatchesLibm) {
+  // Rows with different margins, and labels in both {-1, 1} and {0, 1},
+  // more than Evaluate() adds up at a time.
+  DMatrix matrix(300);
+  matrix.InitSparseRow();
+  for (int i = 0; i < matrix.row_size; ++i) {
+    SparseRow* row = matrix.row[i];
+    row->resize(2);
+    matrix.Y[i] = (i % 3 == 0) ? 1 : ((i % 3 == 1) ? -1 : 0);
+    row->X[0] = (i % 100 - 50) * 0.2;
+    row->idx[0] = 0;
+    row->X[1] = 1.0;
+    row->idx[1] = 1;
+  }
+  F2M_PARAM hyperparam;
+  hyperparam.regu_lambda = 0;
+  hyperparam.regu_type = NONE;
+  Model model(2, hyperparam);
+  ParameterVector* w = model.GetParameter();
+  (*w)[0] = 1.5;
+  (*w)[1] = -0.5;
+  LogitLoss loss(NONE);
+  SparseGrad grad;
+  loss.CalcGrad(&matrix, model, grad);
+  EXPECT_EQ(grad.size_w, (index_t)600);
+  for (int i = 0; i < matrix.row_size; ++i) {
+    SparseRow* row = matrix.row[i];
+    double y = matrix.Y[i] > 0 ? 1 : -1;
+    double margin = (*w)[0] * row->X[0] + (*w)[1] * row->X[1];
+    double partial_grad = -y / (exp(y * margin) + 1);
+    EXPECT_NEAR(grad.w[2*i], partial_grad * row->X[0], 1e-5);
+    EXPECT_NEAR(grad.w[2*i+1], partial_grad * row->X[1], 1e-6);
+  }
+  // Evaluate
+  vector<real_t> pred(matrix.row_size);
+  loss.Predict(&matrix, model, pred);
+  double expected = 0;
+  for (int i = 0; i < matrix.row_size; ++i) {
+    double y = matrix.Y[i] > 0 ? 1 : -1;
+    expected += log(1 + exp(-y * pred[i]));
+  }
+  expected /= matrix.row_size;
+  const Loss& const_loss = loss;
+  EXPECT_NEAR(const_loss.Evaluate(pred, matrix.Y), expected, 1e-5);
+}
+
 } // namespace f2m
@@ -28,8 +28,11 @@ core part of ML algorithms.
 #include <cmath> // for log() and exp()
 
 #include "src/base/common.h"
+#include "src/base/fast_math.h"
+#include "src/base/profiler.h"
 #include "src/data/data_structure.h"
 #include "src/data/model_parameters.h"
+#include "src/loss/batch_kernel.h"
 
 using std::vector;
 
@@ -39,9 +42,16 @@ namespace f2m {
 // Loss is an abstract class, which can be implemented by real
 // loss functions such as logistic regression loss (logit_loss.h),
 // FM loss (fm_loss.h), and FFM loss (ffm_loss.h)
+// Loss is only called through the virtual functions once for a
+// batch. The rows are handled by the kernels of batch_kernel.h,
+// which are selected when a loss sees a new model.
 class Loss {
  public:
-  Loss(RegularType regu_type) : m_regu_type(regu_type) {}
+  Loss(RegularType regu_type)
+    : m_regu_type(regu_type), m_prefetch(kDefaultPrefetchDistance) {
+    m_kernel.margins = NULL;
+    m_kernel.fused = NULL;
+  }
   virtual ~Loss() {}
 
   // Given the input DMatrix and current model, return 
@@ -56,16 +66,52 @@ class Loss {
                         Model& param,
                         SparseGrad& grad) = 0;
 
+  // Given the input DMatrix and current model, return both the
+  // prediction results and the calculated gradient. This reads the
+  // model once, while Predict() and CalcGrad() read it once each.
+  // Note that the prediction results are made by the model before
+  // it is updated by the gradient.
+  virtual void PredictAndCalcGrad(const DMatrix* matrix,
+                                  Model& param,
+                                  vector<real_t>& pred,
+                                  SparseGrad& grad) {
+    F2M_PROFILE_SCOPE(PROFILE_GRAD);
+    CHECK_NOTNULL(matrix);
+    CHECK_GT(matrix->row_size, 0);
+    F2M_PROFILE_COUNT(PROFILE_GRAD, matrix->row_size,
+                      NumberOfNonZero(matrix), 0);
+    pred.resize(matrix->row_size);
+    CalcGradients(matrix, param, pred, grad);
+  }
+
+  // Prefetch the parameters up to |features| features ahead of
+  // the current row, or do not prefetch if |features| is 0. The
+  // best distance depends on the memory latency.
+  void SetPrefetchDistance(index_t features) { m_prefetch = features; }
+
   // Given the prediction results and the groudtruth, return 
   // current loss value. Here we use the cross-enropy loss by default.
   // Note that the cross-enropy loss takes 1 and -1 for positive and
   // negative examples, respectivly.
   virtual real_t Evaluate(const vector<real_t>& pred,
                           const vector<real_t>& label) const {
-    real_t objv = 0.0;
-    for (index_t i = 0; i < pred.size(); ++i) {
-      real_t y = label[i] > 0 ? 1 : -1;
-      objv += log(1 + exp(-y*pred[i]));
+    // A chunk of the losses at a time on the stack, since this
+    // is called for every batch, and maybe by several threads.
+    const index_t kChunk = 256;
+    real_t loss[kChunk];
+    double objv = 0.0;
+    for (index_t begin = 0; begin < pred.size(); begin += kChunk) {
+      index_t size = pred.size() - begin < kChunk ?
+                     pred.size() - begin : kChunk;
+      for (index_t i = 0; i < size; ++i) {
+        real_t y = label[begin+i] > 0 ? 1 : -1;
+        loss[i] = -y*pred[begin+i];
+      }
+      // log(1 + exp(-y*pred)) of the predictions.
+      FastLog1pExp(loss, loss, size);
+      for (index_t i = 0; i < size; ++i) {
+        objv += loss[i];
+      }
     }
     objv /= pred.size();
     return objv;
@@ -73,6 +119,74 @@ class Loss {
 
  protected:
   RegularType m_regu_type;
+  index_t m_prefetch;             // prefetch distance in features.
+  vector<real_t> m_margin;        // margins of current batch.
+
+  LossKernel m_kernel;             // kernels for the current model.
+  ModelType m_kernel_type;         // the model type of m_kernel.
+  FactorShape m_shape;             // the layout of the current model.
+  vector<real_t> m_scratch;        // scratch buffer of the kernels.
+  vector<real_t> m_cache;          // parameters cached by the fused kernel.
+
+  // Select the kernels if the model differs from the last one.
+  void SelectKernel(const Model& model) {
+    FactorShape shape;
+    shape.k = model.GetModelType() == LR ? 0 : model.GetSizeOfVector();
+    shape.num_fields = model.GetModelType() == FFM ?
+                       model.GetNumberOfFields() : 1;
+    shape.offset = model.GetNumberOfFeatures() + 1;
+    if (m_kernel.margins != NULL &&
+        m_kernel_type == model.GetModelType() &&
+        m_shape.k == shape.k &&
+        m_shape.num_fields == shape.num_fields &&
+        m_shape.offset == shape.offset) {
+      return;
+    }
+    if (model.GetModelType() != LR) CHECK_GT(shape.k, 0);
+    m_kernel = SelectLossKernel(model.GetModelType(), m_regu_type, shape.k);
+    m_kernel_type = model.GetModelType();
+    m_shape = shape;
+    m_scratch.resize(2 * shape.k + 1);
+  }
+
+  // Compute the margins <w,x> of a batch.
+  void CalcMargins(const DMatrix* matrix, Model& model,
+                   vector<real_t>& margin) {
+    CHECK_NOTNULL(matrix);
+    CHECK_EQ(margin.size(), matrix->row_size);
+    SelectKernel(model);
+    m_kernel.margins(matrix, model.GetParameter()->data(), m_shape,
+                     m_prefetch, m_scratch.data(), margin.data());
+  }
+
+  // Compute the gradients and the margins of a batch in one
+  // pass over the parameters.
+  void CalcGradients(const DMatrix* matrix, Model& model,
+                     vector<real_t>& margin, SparseGrad& grad) {
+    CHECK_NOTNULL(matrix);
+    CHECK_EQ(margin.size(), matrix->row_size);
+    SelectKernel(model);
+    m_kernel.fused(matrix, model.GetParameter()->data(), m_shape,
+                   m_prefetch, m_scratch.data(), model.GetLambda(), m_cache,
+                   margin.data(), grad);
+  }
+
+  // Compute the gradients of a batch, and drop the margins.
+  void CalcGradients(const DMatrix* matrix, Model& model,
+                     SparseGrad& grad) {
+    m_margin.resize(matrix->row_size);
+    CalcGradients(matrix, model, m_margin, grad);
+  }
+
+  // Return the number of non-zero features of a batch.
+  static uint64 NumberOfNonZero(const DMatrix* matrix) {
+    uint64 nnz = 0;
+    for (index_t i = 0; i < matrix->row_size; ++i) {
+      nnz += matrix->row[i]->size;
+    }
+    return nnz;
+  }
+
   DISALLOW_COPY_AND_ASSIGN(Loss);
 };
 
@@ -0,0 +1,179 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file is the implementation of Metric.
+*/
+
+#include "src/loss/metric.h"
+
+#include <cmath>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/base/parallel.h"
+
+namespace f2m {
+
+// Do not split a small batch among threads.
+const index_t kMinRowsPerThread = 1 << 14;
+
+Metric::Metric(int num_threads, uint32 num_buckets)
+  : m_num_threads(num_threads),
+    m_num_buckets(num_buckets) {
+  if (m_num_threads <= 0) {
+    m_num_threads = GetNumberOfThreads();
+  }
+  CHECK_GT(m_num_buckets, 0);
+  m_acc.resize(m_num_threads);
+  Reset();
+  if (m_num_threads > 1) {
+    m_pred.reserve(m_num_threads * kMinRowsPerThread);
+    m_label.reserve(m_num_threads * kMinRowsPerThread);
+  }
+}
+
+void Metric::Reset() {
+  for (int t = 0; t < m_num_threads; ++t) {
+    Accumulator& acc = m_acc[t];
+    acc.count = 0;
+    acc.num_pos = 0;
+    acc.logloss = 0;
+    acc.sum_prob = 0;
+    acc.pos_hist.assign(m_num_buckets, 0);
+    acc.neg_hist.assign(m_num_buckets, 0);
+  }
+  m_pred.clear();
+  m_label.clear();
+}
+
+void Metric::Add(const real_t* pred, const real_t* label, index_t size) {
+  if (m_num_threads == 1) {
+    Accumulate(pred, label, 0, size, m_acc[0]);
+    return;
+  }
+  m_pred.insert(m_pred.end(), pred, pred + size);
+  m_label.insert(m_label.end(), label, label + size);
+  if (m_pred.size() >= m_num_threads * kMinRowsPerThread) {
+    Flush();
+  }
+}
+
+void Metric::Flush() {
+  index_t size = m_pred.size();
+  int num_threads = m_num_threads;
+  if (size / kMinRowsPerThread < num_threads) {
+    num_threads = size / kMinRowsPerThread;
+  }
+  if (num_threads <= 1) {
+    Accumulate(m_pred.data(), m_label.data(), 0, size, m_acc[0]);
+  } else {
+    ParallelRun(num_threads, [&](int t) {
+      Accumulate(m_pred.data(), m_label.data(),
+                 SplitBegin(size, num_threads, t),
+                 SplitBegin(size, num_threads, t + 1),
+                 m_acc[t]);
+    });
+  }
+  m_pred.clear();
+  m_label.clear();
+}
+
+void Metric::Accumulate(const real_t* pred,
+                        const real_t* label,
+                        index_t begin, index_t end,
+                        Accumulator& acc) {
+  // Keep the sums in registers, and write them back at the end.
+  uint64 num_pos = 0;
+  double logloss = 0;
+  double sum_prob = 0;
+  uint64* pos_hist = acc.pos_hist.data();
+  uint64* neg_hist = acc.neg_hist.data();
+  for (index_t i = begin; i < end; ++i) {
+    double margin = pred[i];
+    bool positive = label[i] > 0;
+    // log(1 + exp(z)) without overflow.
+    double z = positive ? -margin : margin;
+    logloss += z > 0 ? z + log1p(exp(-z)) : log1p(exp(z));
+    double prob = 1.0 / (1.0 + exp(-margin));
+    sum_prob += prob;
+    uint32 bucket = static_cast<uint32>(prob * m_num_buckets);
+    if (bucket >= m_num_buckets) {
+      bucket = m_num_buckets - 1;
+    }
+    if (positive) {
+      num_pos++;
+      pos_hist[bucket]++;
+    } else {
+      neg_hist[bucket]++;
+    }
+  }
+  acc.count += end - begin;
+  acc.num_pos += num_pos;
+  acc.logloss += logloss;
+  acc.sum_prob += sum_prob;
+}
+
+MetricResult Metric::Result() {
+  Flush();
+  uint64 count = 0;
+  uint64 num_pos = 0;
+  double logloss = 0;
+  double sum_prob = 0;
+  for (int t = 0; t < m_num_threads; ++t) {
+    count += m_acc[t].count;
+    num_pos += m_acc[t].num_pos;
+    logloss += m_acc[t].logloss;
+    sum_prob += m_acc[t].sum_prob;
+  }
+  MetricResult result;
+  result.count = count;
+  result.logloss = 0;
+  result.auc = 0;
+  result.calibration = 0;
+  result.normalized_entropy = 0;
+  if (count == 0) {
+    return result;
+  }
+  result.logloss = logloss / count;
+  if (num_pos > 0) {
+    result.calibration = sum_prob / num_pos;
+  }
+  uint64 num_neg = count - num_pos;
+  if (num_pos > 0 && num_neg > 0) {
+    double rate = static_cast<double>(num_pos) / count;
+    double entropy = -rate * log(rate) - (1 - rate) * log(1 - rate);
+    result.normalized_entropy = result.logloss / entropy;
+    // Walk the buckets from the highest probability. A negative
+    // example ranks below all the positive examples seen so far,
+    // and ties with the positive examples in the same bucket.
+    double area = 0;
+    double pos_above = 0;
+    for (int64 b = m_num_buckets - 1; b >= 0; --b) {
+      double pos = 0, neg = 0;
+      for (int t = 0; t < m_num_threads; ++t) {
+        pos += m_acc[t].pos_hist[b];
+        neg += m_acc[t].neg_hist[b];
+      }
+      area += neg * (pos_above + pos / 2);
+      pos_above += pos;
+    }
+    result.auc = area / (static_cast<double>(num_pos) * num_neg);
+  }
+  return result;
+}
+
+} // namespace f2m
@@ -0,0 +1,120 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file defines Metric, which evaluates the predictions
+of a model on multiple threads.
+*/
+
+#ifndef F2M_LOSS_METRIC_H_
+#define F2M_LOSS_METRIC_H_
+
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/data/data_structure.h"
+
+using std::vector;
+
+namespace f2m {
+
+// The results of an evaluation.
+struct MetricResult {
+  uint64 count;              // number of examples.
+  real_t logloss;            // mean cross-entropy loss.
+  real_t auc;                // area under the ROC curve.
+  real_t calibration;        // sum of probabilities / number of positives.
+  real_t normalized_entropy; // logloss / entropy of the positive rate.
+};
+
+/* -----------------------------------------------------------------------------
+ * Metric evaluates the predictions of a model over a stream of batches:        *
+ *                                                                              *
+ *   Metric metric;                                                             *
+ *   while (...) {                                                              *
+ *     loss.Predict(matrix, model, pred);                                       *
+ *     metric.Add(pred, matrix->Y);                                             *
+ *   }                                                                          *
+ *   MetricResult result = metric.Result();                                     *
+ *                                                                              *
+ * The predictions are the margins returned by Loss::Predict, and a label is    *
+ * positive if it is greater than 0. The rows are buffered across calls of      *
+ * Add(), so the batches can be of any size, even a single row. Once the buffer *
+ * holds enough rows for all the threads, it is split among them, and each      *
+ * thread adds its part to its own accumulator without any locking. Result()    *
+ * scores the rest of the buffer and merges the accumulators.                   *
+ *                                                                              *
+ * AUC is computed from histograms of the predicted probabilities of positive   *
+ * and negative examples, so it takes O(num_buckets) memory per thread instead  *
+ * of a sort over all the predictions. Examples in the same bucket count as     *
+ * ties, so the error of AUC is bounded by the width of a bucket.               *
+ * -----------------------------------------------------------------------------
+ */
+class Metric {
+ public:
+  // num_threads = 0 for the number of hardware threads.
+  explicit Metric(int num_threads = 0, uint32 num_buckets = 1 << 18);
+  ~Metric() {}
+
+  // Add |size| predictions and their labels.
+  void Add(const real_t* pred, const real_t* label, index_t size);
+
+  // Add a batch of predictions and their labels.
+  void Add(const vector<real_t>& pred, const vector<real_t>& label) {
+    CHECK_EQ(pred.size(), label.size());
+    Add(pred.data(), label.data(), pred.size());
+  }
+
+  // Add one prediction and its label.
+  void Add(real_t pred, real_t label) { Add(&pred, &label, 1); }
+
+  // Merge the accumulators of all threads.
+  MetricResult Result();
+
+  // Clear all the accumulators.
+  void Reset();
+
+ private:
+  // Partial results of one thread.
+  struct Accumulator {
+    uint64 count;
+    uint64 num_pos;
+    double logloss;
+    double sum_prob;
+    vector<uint64> pos_hist;
+    vector<uint64> neg_hist;
+  };
+
+  int m_num_threads;               // number of threads.
+  uint32 m_num_buckets;            // number of buckets for AUC.
+  vector<Accumulator> m_acc;       // one accumulator for each thread.
+  vector<real_t> m_pred;           // buffered predictions.
+  vector<real_t> m_label;          // buffered labels.
+
+  // Add pred[begin, end) to the accumulator |acc|.
+  void Accumulate(const real_t* pred,
+                  const real_t* label,
+                  index_t begin, index_t end,
+                  Accumulator& acc);
+  // Score the buffered rows on all the threads.
+  void Flush();
+
+  DISALLOW_COPY_AND_ASSIGN(Metric);
+};
+
+} // namespace f2m
+
+#endif // F2M_LOSS_METRIC_H_
@@ -0,0 +1,139 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file tests metric.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "src/loss/metric.h"
+
+namespace f2m {
+
+const index_t kNumRows = 200000;
+
+// Generate margins that are correlated with the labels.
+void MakeData(vector<real_t>& pred, vector<real_t>& label) {
+  std::mt19937 rng(1);
+  std::normal_distribution<real_t> noise(0, 1);
+  pred.resize(kNumRows);
+  label.resize(kNumRows);
+  for (index_t i = 0; i < kNumRows; ++i) {
+    label[i] = (rng() % 4 == 0) ? 1 : -1;
+    pred[i] = label[i] * 0.8 - 1 + noise(rng);
+  }
+}
+
+// AUC by sorting, with ties counted as one half.
+double ExactAUC(const vector<real_t>& pred, const vector<real_t>& label) {
+  vector<std::pair<real_t, bool> > items;
+  for (index_t i = 0; i < pred.size(); ++i) {
+    items.push_back(std::make_pair(pred[i], label[i] > 0));
+  }
+  std::sort(items.begin(), items.end());
+  double area = 0, num_neg = 0, num_pos = 0;
+  for (index_t i = 0; i < items.size(); ++i) {
+    if (items[i].second) {
+      area += num_neg;
+      num_pos++;
+    } else {
+      num_neg++;
+    }
+  }
+  return area / (num_pos * num_neg);
+}
+
+TEST(Metric, MatchesExactValues) {
+  vector<real_t> pred, label;
+  MakeData(pred, label);
+  Metric metric(1);
+  metric.Add(pred, label);
+  MetricResult result = metric.Result();
+  EXPECT_EQ(result.count, kNumRows);
+  // logloss
+  double logloss = 0, sum_prob = 0, num_pos = 0;
+  for (index_t i = 0; i < kNumRows; ++i) {
+    real_t y = label[i] > 0 ? 1 : -1;
+    logloss += log(1 + exp(-y * pred[i]));
+    sum_prob += 1.0 / (1.0 + exp(-pred[i]));
+    num_pos += label[i] > 0;
+  }
+  logloss /= kNumRows;
+  EXPECT_NEAR(result.logloss, logloss, 1e-5);
+  EXPECT_NEAR(result.calibration, sum_prob / num_pos, 1e-5);
+  double rate = num_pos / kNumRows;
+  double entropy = -rate * log(rate) - (1 - rate) * log(1 - rate);
+  EXPECT_NEAR(result.normalized_entropy, logloss / entropy, 1e-5);
+  EXPECT_NEAR(result.auc, ExactAUC(pred, label), 1e-4);
+}
+
+TEST(Metric, ThreadsAndBatchesAgree) {
+  vector<real_t> pred, label;
+  MakeData(pred, label);
+  Metric single(1);
+  single.Add(pred, label);
+  MetricResult expected = single.Result();
+  // Feed the same data in two batches to 4 threads.
+  Metric multi(4);
+  index_t half = kNumRows / 2;
+  vector<real_t> pred_1(pred.begin(), pred.begin() + half);
+  vector<real_t> label_1(label.begin(), label.begin() + half);
+  vector<real_t> pred_2(pred.begin() + half, pred.end());
+  vector<real_t> label_2(label.begin() + half, label.end());
+  multi.Add(pred_1, label_1);
+  multi.Add(pred_2, label_2);
+  MetricResult result = multi.Result();
+  EXPECT_EQ(result.count, expected.count);
+  EXPECT_NEAR(result.logloss, expected.logloss, 1e-6);
+  EXPECT_NEAR(result.calibration, expected.calibration, 1e-6);
+  EXPECT_NEAR(result.normalized_entropy, expected.normalized_entropy, 1e-6);
+  EXPECT_DOUBLE_EQ(result.auc, expected.auc);
+  // Feed the rows one by one, with a Result() in the middle.
+  Metric rows(4);
+  for (index_t i = 0; i < kNumRows; ++i) {
+    rows.Add(pred[i], label[i]);
+    if (i == half) {
+      EXPECT_EQ(rows.Result().count, half + 1);
+    }
+  }
+  result = rows.Result();
+  EXPECT_EQ(result.count, expected.count);
+  EXPECT_NEAR(result.logloss, expected.logloss, 1e-6);
+  EXPECT_DOUBLE_EQ(result.auc, expected.auc);
+  // Reset
+  multi.Reset();
+  EXPECT_EQ(multi.Result().count, (uint64)0);
+}
+
+TEST(Metric, PerfectRanking) {
+  vector<real_t> pred(1000), label(1000);
+  for (index_t i = 0; i < 1000; ++i) {
+    label[i] = i % 2 ? 1 : 0;
+    pred[i] = label[i] > 0 ? 5 : -5;
+  }
+  Metric metric;
+  metric.Add(pred, label);
+  EXPECT_DOUBLE_EQ(metric.Result().auc, 1.0);
+}
+
+} // namespace f2m
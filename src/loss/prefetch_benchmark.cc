@@ -0,0 +1,118 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file measures the losses with models larger than the last level
+cache, for a few prefetch distances in features. Distance 0 does not
+prefetch.
+
+Usage: prefetch_benchmark [model_size_in_MB] [row_size] [repeat]
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <vector>
+
+#include "src/base/timer.h"
+#include "src/data/data_structure.h"
+#include "src/data/hyper_parameters.h"
+#include "src/data/model_parameters.h"
+#include "src/loss/ffm_loss.h"
+#include "src/loss/fm_loss.h"
+#include "src/loss/logit_loss.h"
+#include "src/loss/loss.h"
+
+using namespace f2m;
+
+const index_t kNumRows = 1000;
+const index_t kNumFields = 8;
+const index_t kSizeOfVector = 8;
+const index_t kDistances[] = { 0, 8, 16, 32, 64, 128 };
+const int kNumDistances = 6;
+
+// Fill the rows with new random features, which are not in the cache.
+void RandomRows(index_t num_features, index_t row_size, DMatrix* matrix) {
+  matrix->ResetSparseRow();
+  for (index_t i = 0; i < matrix->row_size; ++i) {
+    SparseRow* row = matrix->row[i];
+    row->set_binary(true);
+    row->resize(row_size);
+    matrix->Y[i] = i % 2;
+    for (index_t j = 0; j < row_size; ++j) {
+      row->idx[j] = rand() % num_features;
+      if (matrix->model_type == FFM) row->field[j] = j % kNumFields;
+    }
+  }
+}
+
+// Return nanoseconds per row of Predict() and CalcGrad().
+void Measure(Loss* loss, Model& model, index_t row_size,
+             int repeat, double* predict, double* grad) {
+  index_t num_features = model.GetNumberOfFeatures();
+  DMatrix matrix(kNumRows, model.GetModelType());
+  vector<real_t> pred(kNumRows);
+  SparseGrad sparse_grad(model.GetModelType());
+  double predict_time = 0, grad_time = 0;
+  for (int i = 0; i < repeat; ++i) {
+    RandomRows(num_features, row_size, &matrix);
+    Timer timer;
+    loss->Predict(&matrix, model, pred);
+    predict_time += timer.Elapsed();
+    RandomRows(num_features, row_size, &matrix);
+    timer.Reset();
+    loss->CalcGrad(&matrix, model, sparse_grad);
+    grad_time += timer.Elapsed();
+  }
+  *predict = predict_time * 1e9 / (kNumRows * repeat);
+  *grad = grad_time * 1e9 / (kNumRows * repeat);
+}
+
+int main(int argc, char* argv[]) {
+  uint64 model_mb = argc > 1 ? atol(argv[1]) : 512;
+  index_t row_size = argc > 2 ? atoi(argv[2]) : 20;
+  int repeat = argc > 3 ? atoi(argv[3]) : 10;
+  F2M_PARAM hyperparam;
+  hyperparam.regu_lambda = 0.001;
+  hyperparam.regu_type = L2;
+  printf("model = %lu MB, row_size = %u, repeat = %d, ns/row\n",
+         model_mb, row_size, repeat);
+  printf("%-4s %-8s %10s %10s\n", "loss", "distance", "predict", "grad");
+  for (int type = LR; type <= FFM; ++type) {
+    ModelType model_type = static_cast<ModelType>(type);
+    // The floats of a feature: w, and v for every field.
+    uint64 floats = 1;
+    if (model_type == FM) floats += kSizeOfVector;
+    if (model_type == FFM) floats += kSizeOfVector * kNumFields;
+    index_t num_features = (model_mb << 20) / (floats * sizeof(real_t));
+    Model model(num_features, hyperparam, model_type,
+                kSizeOfVector, kNumFields, true);
+    LogitLoss lr_loss(L2);
+    FMLoss fm_loss(L2);
+    FFMLoss ffm_loss(L2);
+    Loss* loss = model_type == LR ? static_cast<Loss*>(&lr_loss) :
+                 model_type == FM ? static_cast<Loss*>(&fm_loss) :
+                 static_cast<Loss*>(&ffm_loss);
+    for (int d = 0; d < kNumDistances; ++d) {
+      loss->SetPrefetchDistance(kDistances[d]);
+      double predict, grad;
+      Measure(loss, model, row_size, repeat, &predict, &grad);
+      printf("%-4s %-8u %10.1f %10.1f\n",
+             model_type == LR ? "LR" : model_type == FM ? "FM" : "FFM",
+             kDistances[d], predict, grad);
+    }
+  }
+  return 0;
+}
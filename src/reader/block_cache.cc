@@ -0,0 +1,262 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file is the implementation of block_cache.h
+*/
+
+#include "src/reader/block_cache.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/base/file_util.h"
+
+namespace f2m {
+
+namespace {
+
+const uint64 kBlockFileMagic = 0x32304B4C424D3246ULL;  // "F2MBLK02"
+
+// The first bytes of a block file.
+struct Header {
+  uint64 magic;
+  uint64 model_type;
+  uint64 fingerprint;               // see Parser::Fingerprint().
+};
+
+// The last bytes of a block file.
+struct Trailer {
+  uint64 index_offset;              // where the offsets of blocks begin.
+  uint64 num_blocks;
+  uint64 magic;
+};
+
+// Read the trailer of |file|. Return false if it is not a block file.
+bool ReadTrailer(FILE* file, ModelType type,
+                 Header* header, Trailer* trailer) {
+  if (fread(header, sizeof(*header), 1, file) != 1 ||
+      header->magic != kBlockFileMagic || header->model_type != type) {
+    return false;
+  }
+  if (fseeko(file, -static_cast<off_t>(sizeof(Trailer)), SEEK_END) != 0 ||
+      fread(trailer, sizeof(Trailer), 1, file) != 1) {
+    return false;
+  }
+  return trailer->magic == kBlockFileMagic;
+}
+
+} // namespace
+
+BlockWriter::BlockWriter(const string& filename, ModelType type,
+                         uint64 fingerprint)
+  : m_filename(filename),
+    m_temp_filename(filename + ".tmp") {
+  m_file = OpenFileOrDie(m_temp_filename.c_str(), "w");
+  Header header = { kBlockFileMagic, static_cast<uint64>(type),
+                    fingerprint };
+  CHECK_EQ(fwrite(&header, sizeof(header), 1, m_file), 1);
+}
+
+BlockWriter::~BlockWriter() {
+  // An unfinished file is not a block file.
+  if (m_file != NULL) {
+    Close(m_file);
+    remove(m_temp_filename.c_str());
+  }
+}
+
+void BlockWriter::Write(const CompressedMatrix& block) {
+  CHECK_NOTNULL(m_file);
+  m_offset.push_back(ftello(m_file));
+  block.Write(m_file);
+}
+
+void BlockWriter::Finish() {
+  CHECK_NOTNULL(m_file);
+  Trailer trailer;
+  trailer.index_offset = ftello(m_file);
+  trailer.num_blocks = m_offset.size();
+  trailer.magic = kBlockFileMagic;
+  if (!m_offset.empty()) {
+    CHECK_EQ(fwrite(m_offset.data(), sizeof(uint64), m_offset.size(),
+                    m_file), m_offset.size());
+  }
+  CHECK_EQ(fwrite(&trailer, sizeof(trailer), 1, m_file), 1);
+  Close(m_file);
+  m_file = NULL;
+  if (rename(m_temp_filename.c_str(), m_filename.c_str()) != 0) {
+    LOG(FATAL) << "Cannot rename " << m_temp_filename
+               << " to " << m_filename;
+  }
+}
+
+BlockCache::BlockCache(const string& filename,
+                       ModelType type,
+                       uint64 memory_budget,
+                       int num_prefetch)
+  : m_filename(filename),
+    m_type(type),
+    m_memory_budget(memory_budget),
+    m_num_prefetch(num_prefetch),
+    m_cached_bytes(0),
+    m_num_loads(0),
+    m_pos(0),
+    m_stop(false) {
+  CHECK_GE(m_num_prefetch, 0);
+  m_file = OpenFileOrDie(m_filename.c_str(), "r");
+  Header header;
+  Trailer trailer;
+  if (!ReadTrailer(m_file, m_type, &header, &trailer)) {
+    LOG(FATAL) << m_filename << " is not a block file.";
+  }
+  m_offset.resize(trailer.num_blocks);
+  fseeko(m_file, trailer.index_offset, SEEK_SET);
+  if (trailer.num_blocks > 0 &&
+      fread(m_offset.data(), sizeof(uint64), trailer.num_blocks,
+            m_file) != trailer.num_blocks) {
+    LOG(FATAL) << "Cannot read the blocks of " << m_filename;
+  }
+  m_offset.push_back(trailer.index_offset);
+  m_blocks.assign(GetNumberOfBlocks(), NULL);
+  m_lru_pos.resize(GetNumberOfBlocks());
+  m_thread = std::thread(&BlockCache::Prefetch, this);
+}
+
+BlockCache::~BlockCache() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cond.notify_all();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+  for (size_t i = 0; i < m_blocks.size(); ++i) {
+    delete m_blocks[i];
+  }
+  Close(m_file);
+}
+
+bool BlockCache::IsBlockFile(const string& filename, ModelType type,
+                             uint64 fingerprint) {
+  FILE* file = fopen(filename.c_str(), "r");
+  if (file == NULL) return false;
+  Header header;
+  Trailer trailer;
+  bool result = ReadTrailer(file, type, &header, &trailer) &&
+                header.fingerprint == fingerprint;
+  fclose(file);
+  return result;
+}
+
+void BlockCache::SetOrder(const vector<index_t>& order) {
+  for (size_t i = 0; i < order.size(); ++i) {
+    CHECK_LT(order[i], GetNumberOfBlocks());
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_order = order;
+    m_pos = 0;
+  }
+  m_cond.notify_all();
+}
+
+const CompressedMatrix* BlockCache::Get(index_t pos) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  CHECK_LT(pos, m_order.size());
+  m_pos = pos;
+  index_t block = m_order[pos];
+  // The window of prefetching moves on.
+  m_cond.notify_all();
+  m_cond.wait(lock, [this, block] { return m_blocks[block] != NULL; });
+  m_lru.splice(m_lru.begin(), m_lru, m_lru_pos[block]);
+  return m_blocks[block];
+}
+
+uint64 BlockCache::GetNumberOfBytes() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_cached_bytes;
+}
+
+uint64 BlockCache::GetNumberOfLoads() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_num_loads;
+}
+
+void BlockCache::Prefetch() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_stop) {
+    index_t block = 0;
+    if (!NextToLoad(&block)) {
+      m_cond.wait(lock);
+      continue;
+    }
+    // Read the disk without holding the lock.
+    lock.unlock();
+    CompressedMatrix* matrix = new CompressedMatrix(m_type);
+    fseeko(m_file, m_offset[block], SEEK_SET);
+    matrix->Read(m_file);
+    lock.lock();
+    m_blocks[block] = matrix;
+    m_cached_bytes += matrix->GetNumberOfBytes();
+    m_lru.push_front(block);
+    m_lru_pos[block] = m_lru.begin();
+    m_num_loads++;
+    m_cond.notify_all();
+  }
+}
+
+bool BlockCache::NextToLoad(index_t* block) {
+  index_t end = m_pos + m_num_prefetch + 1;
+  if (end > m_order.size()) end = m_order.size();
+  for (index_t p = m_pos; p < end; ++p) {
+    index_t b = m_order[p];
+    if (m_blocks[b] != NULL) continue;
+    // The block being read is loaded even if it does not fit.
+    if (!MakeRoom(m_offset[b + 1] - m_offset[b]) && p != m_pos) {
+      return false;
+    }
+    *block = b;
+    return true;
+  }
+  return false;
+}
+
+bool BlockCache::MakeRoom(uint64 size) {
+  index_t end = m_pos + m_num_prefetch + 1;
+  if (end > m_order.size()) end = m_order.size();
+  auto it = m_lru.end();
+  while (m_cached_bytes + size > m_memory_budget && it != m_lru.begin()) {
+    --it;
+    index_t b = *it;
+    // Keep the blocks that are about to be read.
+    if (std::find(m_order.begin() + m_pos, m_order.begin() + end, b) !=
+        m_order.begin() + end) {
+      continue;
+    }
+    m_cached_bytes -= m_blocks[b]->GetNumberOfBytes();
+    delete m_blocks[b];
+    m_blocks[b] = NULL;
+    it = m_lru.erase(it);
+  }
+  return m_cached_bytes + size <= m_memory_budget;
+}
+
+} // namespace f2m
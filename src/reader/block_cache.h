@@ -0,0 +1,160 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file defines the block file of compressed rows, and BlockCache,
+which reads the blocks of a file larger than the memory.
+*/
+
+#ifndef F2M_READER_BLOCK_CACHE_H_
+#define F2M_READER_BLOCK_CACHE_H_
+
+#include <stdio.h>
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/data/compressed_matrix.h"
+#include "src/data/data_structure.h"
+
+using std::string;
+using std::vector;
+
+namespace f2m {
+
+// The rows of a block take about this number of bytes.
+const uint64 kDefaultBlockBytes = 16 * 1024 * 1024;
+
+/* -----------------------------------------------------------------------------
+ * A block file holds the parsed rows of a data set, so that we parse the text  *
+ * only once, however many epochs we train. The rows are split into blocks of   *
+ * a few MB, and every block is a CompressedMatrix (see compressed_matrix.h):   *
+ *                                                                              *
+ *   [ header | block 0 | block 1 | ... | offsets of the blocks | trailer ]     *
+ *                                                                              *
+ * The header holds the model type and the fingerprint of the parser, so that   *
+ * a block file is not reused for rows that would be parsed differently.        *
+ *                                                                              *
+ * BlockWriter writes the file under a temporary name and renames it at the     *
+ * end, so that a block file is always complete.                                *
+ *                                                                              *
+ * BlockCache reads the blocks in a given order, e.g. a random order in each    *
+ * epoch. A dedicated thread loads the next few blocks of the order while the   *
+ * current one is used, so that reading the disk overlaps with training. The    *
+ * loaded blocks stay in memory until they are evicted in LRU order, and the    *
+ * cache never holds more than |memory_budget| bytes, except that the block     *
+ * being read is always loaded. If all the blocks fit in the budget, they are   *
+ * read from disk only once.                                                    *
+ *                                                                              *
+ *   BlockCache cache(filename, FFM, memory_budget);                            *
+ *   cache.SetOrder(order);                                                     *
+ *   for (index_t pos = 0; pos < order.size(); ++pos) {                         *
+ *     const CompressedMatrix* block = cache.Get(pos);                          *
+ *     ... decode the rows of block                                             *
+ *   }                                                                          *
+ * -----------------------------------------------------------------------------
+ */
+class BlockWriter {
+ public:
+  // |fingerprint| identifies how the rows were parsed,
+  // see Parser::Fingerprint().
+  BlockWriter(const string& filename, ModelType type,
+              uint64 fingerprint = 0);
+  ~BlockWriter();
+
+  // Append a block of rows to the file.
+  void Write(const CompressedMatrix& block);
+
+  // Write the offsets of the blocks and close the file.
+  void Finish();
+
+ private:
+  string m_filename;                // the block file.
+  string m_temp_filename;           // the file being written.
+  FILE* m_file;                     // NULL after Finish().
+  vector<uint64> m_offset;          // the beginning of every block.
+
+  DISALLOW_COPY_AND_ASSIGN(BlockWriter);
+};
+
+class BlockCache {
+ public:
+  BlockCache(const string& filename,
+             ModelType type,
+             uint64 memory_budget,
+             int num_prefetch = 4);
+  ~BlockCache();
+
+  // Return true if |filename| is a complete block file of
+  // |type|, written with |fingerprint|.
+  static bool IsBlockFile(const string& filename, ModelType type,
+                          uint64 fingerprint = 0);
+
+  index_t GetNumberOfBlocks() const { return m_offset.size() - 1; }
+
+  // Read the blocks in |order| from now on.
+  void SetOrder(const vector<index_t>& order);
+
+  // Return the block at |pos| of the order, waiting until it is
+  // loaded. The block is valid until the next call of Get().
+  const CompressedMatrix* Get(index_t pos);
+
+  // The memory of the loaded blocks.
+  uint64 GetNumberOfBytes();
+  // The number of blocks read from disk.
+  uint64 GetNumberOfLoads();
+
+ private:
+  string m_filename;                // the block file.
+  ModelType m_type;                 // enum ModelType { LR, FM, FFM }
+  uint64 m_memory_budget;           // max bytes of the loaded blocks.
+  int m_num_prefetch;               // blocks loaded ahead of the current.
+  FILE* m_file;                     // only read by the thread.
+  vector<uint64> m_offset;          // the blocks, and the end of the last.
+
+  vector<CompressedMatrix*> m_blocks;     // NULL if not loaded.
+  std::list<index_t> m_lru;               // loaded blocks, the most
+                                          // recently used first.
+  vector<std::list<index_t>::iterator> m_lru_pos;  // position in m_lru.
+  uint64 m_cached_bytes;            // memory of the loaded blocks.
+  uint64 m_num_loads;               // blocks read from disk.
+  vector<index_t> m_order;          // the order of reading blocks.
+  index_t m_pos;                    // current position in m_order.
+
+  std::thread m_thread;             // the prefetching thread.
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  bool m_stop;                      // ask the thread to quit.
+
+  // Main loop of the prefetching thread.
+  void Prefetch();
+  // Find the next block to load. Return false if all the blocks
+  // ahead are loaded, or there is no room for the next one.
+  bool NextToLoad(index_t* block);
+  // Evict the blocks that are not about to be read, until |size|
+  // more bytes fit in the budget. Return true if they fit.
+  bool MakeRoom(uint64 size);
+
+  DISALLOW_COPY_AND_ASSIGN(BlockCache);
+};
+
+} // namespace f2m
+
+#endif // F2M_READER_BLOCK_CACHE_H_
@@ -0,0 +1,139 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file tests block_cache.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "src/data/compressed_matrix.h"
+#include "src/data/data_structure.h"
+#include "src/reader/block_cache.h"
+
+using std::string;
+using std::vector;
+
+namespace f2m {
+
+const string kBlockFile = "/tmp/test_block_cache.blocks";
+const index_t kNumBlocks = 20;
+const index_t kRowsPerBlock = 100;
+
+// Write blocks whose rows are labeled by their number.
+void WriteBlocks() {
+  BlockWriter writer(kBlockFile, FM);
+  DMatrix matrix(kRowsPerBlock, FM);
+  matrix.InitSparseRow();
+  for (index_t b = 0; b < kNumBlocks; ++b) {
+    CompressedMatrix block(FM);
+    for (index_t i = 0; i < kRowsPerBlock; ++i) {
+      SparseRow* row = matrix.row[i];
+      row->resize(2);
+      row->idx[0] = b;
+      row->idx[1] = i + 1000;
+      row->X[0] = row->X[1] = 0.5;
+      matrix.Y[i] = b * kRowsPerBlock + i;
+    }
+    block.Append(matrix);
+    writer.Write(block);
+  }
+  writer.Finish();
+}
+
+// Check the rows of block |b|.
+void CheckBlock(const CompressedMatrix* block, index_t b) {
+  ASSERT_EQ(block->GetNumberOfRows(), kRowsPerBlock);
+  DMatrix matrix(1, FM);
+  matrix.InitSparseRow();
+  for (index_t i = 0; i < kRowsPerBlock; ++i) {
+    EXPECT_EQ(block->Decode(i, matrix.row[0]),
+              (real_t) (b * kRowsPerBlock + i));
+    EXPECT_EQ(matrix.row[0]->idx[0], b);
+    EXPECT_EQ(matrix.row[0]->X[1], (real_t) 0.5);
+  }
+}
+
+TEST(BlockCacheTest, BlockFile) {
+  EXPECT_FALSE(BlockCache::IsBlockFile(kBlockFile + ".none", FM));
+  {
+    // An unfinished file is removed.
+    BlockWriter writer(kBlockFile, FM);
+  }
+  EXPECT_FALSE(BlockCache::IsBlockFile(kBlockFile, FM));
+  WriteBlocks();
+  EXPECT_TRUE(BlockCache::IsBlockFile(kBlockFile, FM));
+  EXPECT_FALSE(BlockCache::IsBlockFile(kBlockFile, FFM));
+  // Parsed by another parser.
+  EXPECT_FALSE(BlockCache::IsBlockFile(kBlockFile, FM, 1));
+  unlink(kBlockFile.c_str());
+}
+
+TEST(BlockCacheTest, AllBlocksFit) {
+  WriteBlocks();
+  BlockCache cache(kBlockFile, FM, 1 << 30);
+  ASSERT_EQ(cache.GetNumberOfBlocks(), kNumBlocks);
+  vector<index_t> order(kNumBlocks);
+  for (index_t b = 0; b < kNumBlocks; ++b) {
+    order[b] = b;
+  }
+  std::mt19937 rng(2016);
+  for (int epoch = 0; epoch < 3; ++epoch) {
+    std::shuffle(order.begin(), order.end(), rng);
+    cache.SetOrder(order);
+    for (index_t pos = 0; pos < kNumBlocks; ++pos) {
+      CheckBlock(cache.Get(pos), order[pos]);
+    }
+  }
+  // Every block is read from disk only once.
+  EXPECT_EQ(cache.GetNumberOfLoads(), kNumBlocks);
+  unlink(kBlockFile.c_str());
+}
+
+TEST(BlockCacheTest, MemoryBudget) {
+  WriteBlocks();
+  uint64 block_bytes = 0;
+  {
+    BlockCache cache(kBlockFile, FM, 0, 0);
+    cache.SetOrder(vector<index_t>(1, 0));
+    block_bytes = cache.Get(0)->GetNumberOfBytes();
+  }
+  // Room for the current block and two more.
+  uint64 budget = 3 * block_bytes + block_bytes / 2;
+  BlockCache cache(kBlockFile, FM, budget, 2);
+  vector<index_t> order(kNumBlocks);
+  for (index_t b = 0; b < kNumBlocks; ++b) {
+    order[b] = b;
+  }
+  for (int epoch = 0; epoch < 2; ++epoch) {
+    cache.SetOrder(order);
+    for (index_t pos = 0; pos < kNumBlocks; ++pos) {
+      CheckBlock(cache.Get(pos), pos);
+      EXPECT_LE(cache.GetNumberOfBytes(), budget);
+    }
+  }
+  EXPECT_GE(cache.GetNumberOfLoads(), 2 * kNumBlocks - 3);
+  unlink(kBlockFile.c_str());
+}
+
+} // namespace f2m
@@ -0,0 +1,148 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file is the implementation of criteo_parser.h
+*/
+
+#include "src/reader/criteo_parser.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/base/common.h"
+#include "src/base/parse_number.h"
+#include "src/base/profiler.h"
+
+namespace f2m {
+
+namespace {
+
+// MurmurHash64A by Austin Appleby, which is in the public domain.
+uint64 Hash(const char* data, size_t len, uint64 seed) {
+  const uint64 m = 0xc6a4a7935bd1e995ULL;
+  const int r = 47;
+  uint64 h = seed ^ (len * m);
+  const char* end = data + (len & ~(size_t)7);
+  for (; data != end; data += 8) {
+    uint64 k;
+    memcpy(&k, data, 8);
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+  }
+  const unsigned char* tail = reinterpret_cast<const unsigned char*>(data);
+  switch (len & 7) {
+    case 7: h ^= uint64(tail[6]) << 48;
+    case 6: h ^= uint64(tail[5]) << 40;
+    case 5: h ^= uint64(tail[4]) << 32;
+    case 4: h ^= uint64(tail[3]) << 24;
+    case 3: h ^= uint64(tail[2]) << 16;
+    case 2: h ^= uint64(tail[1]) << 8;
+    case 1: h ^= uint64(tail[0]);
+            h *= m;
+  }
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+  return h;
+}
+
+} // namespace
+
+CriteoParser::CriteoParser(index_t num_numeric,
+                           index_t num_categorical,
+                           int hash_bits)
+  : m_num_numeric(num_numeric),
+    m_num_categorical(num_categorical) {
+  CHECK_GT(num_numeric + num_categorical, 0);
+  CHECK_GT(hash_bits, 0);
+  CHECK_LE(hash_bits, 31);
+  m_mask = (1U << hash_bits) - 1;
+}
+
+uint64 CriteoParser::Fingerprint() const {
+  const char kName[] = "criteo";
+  index_t config[] = { m_num_numeric, m_num_categorical, m_mask };
+  uint64 hash = FingerprintOf(kName, sizeof(kName), kFingerprintSeed);
+  return FingerprintOf(config, sizeof(config), hash);
+}
+
+int64 CriteoParser::NumericBucket(double value) {
+  if (value <= 2) return static_cast<int64>(floor(value));
+  double log_value = log(value);
+  return 3 + static_cast<int64>(log_value * log_value);
+}
+
+void CriteoParser::Parse(const StringList& list, DMatrix& matrix) {
+  F2M_PROFILE_SCOPE(PROFILE_PARSE);
+  index_t num_columns = GetNumberOfColumns();
+  uint64 nnz = 0, bytes = 0;
+  for (index_t i = 0; i < matrix.row_size; ++i) {
+    const char* pos = list[i].c_str();
+    const char* end = pos + list[i].size();
+    // parse Y
+    const char* tab = static_cast<const char*>(memchr(pos, '\t', end - pos));
+    const char* label_end = tab != NULL ? tab : end;
+    if (label_end == pos ||
+        ParseFloat(pos, label_end, &matrix.Y[i]) != label_end) {
+      BadItem(Item(pos, label_end));
+    }
+    pos = label_end + 1;
+    // parse row
+    SparseRow* row = matrix.row[i];
+    CHECK_NOTNULL(row);
+    // Every value is 1.
+    row->set_binary(true);
+    row->resize(num_columns);
+    index_t num = 0;
+    for (index_t c = 0; c < num_columns && pos <= end; ++c) {
+      tab = static_cast<const char*>(memchr(pos, '\t', end - pos));
+      const char* next = tab != NULL ? tab : end;
+      // An empty column is a missing value.
+      if (next > pos) {
+        uint64 hash = 0;
+        double value = 0;
+        // nan and inf have no bucket, so they are strings.
+        if (c < m_num_numeric && ParseDouble(pos, next, &value) == next &&
+            isfinite(value)) {
+          int64 bucket = NumericBucket(value);
+          hash = Hash(reinterpret_cast<const char*>(&bucket),
+                      sizeof(bucket), c);
+        } else {
+          hash = Hash(pos, next - pos, c);
+        }
+        row->idx[num] = hash & m_mask;
+        if (matrix.model_type == FFM) {
+          row->field[num] = c;
+        }
+        num++;
+      }
+      pos = next + 1;
+    }
+    row->resize(num);
+    nnz += num;
+    bytes += list[i].size();
+  }
+  if (m_filter != NULL) {
+    m_filter->Filter(matrix);
+  }
+  F2M_PROFILE_COUNT(PROFILE_PARSE, matrix.row_size, nnz, bytes);
+}
+
+} // namespace f2m
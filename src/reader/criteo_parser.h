@@ -0,0 +1,99 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file defines CriteoParser, which parses raw column-oriented
+TSV data, such as the Criteo display advertising logs.
+*/
+
+#ifndef F2M_READER_CRITEO_PARSER_H_
+#define F2M_READER_CRITEO_PARSER_H_
+
+#include <string>
+
+#include "src/base/common.h"
+#include "src/data/data_structure.h"
+#include "src/reader/parser.h"
+
+namespace f2m {
+
+/* -----------------------------------------------------------------------------
+ * CriteoParser reads the raw logs directly, so there is no need for a          *
+ * preprocessing job that turns the strings into integer ids. A line is         *
+ *                                                                              *
+ *   label \t numeric_1 ... \t numeric_n \t categorical_1 ... \t categorical_m  *
+ *                                                                              *
+ * e.g. 13 numeric and 26 categorical columns for Criteo. Empty columns are     *
+ * missing values and give no feature. Every other column gives one feature     *
+ * with value 1, and column c (from 0, not counting the label) is the field     *
+ * of the feature for FFM, so the model needs n + m fields.                     *
+ *                                                                              *
+ * A categorical token is hashed together with its column into the feature      *
+ * space of 2^hash_bits ids, so that the same string in two columns gives two   *
+ * features. A numeric column is first bucketized:                              *
+ *                                                                              *
+ *   [ bucket(v) = floor(v)             if v <= 2 ]                             *
+ *   [ bucket(v) = 3 + floor(log(v)^2)  otherwise ]                             *
+ *                                                                              *
+ * which keeps the small counts apart and merges the large ones, and then the   *
+ * bucket is hashed with its column. A numeric column that does not parse as    *
+ * a finite number, e.g. nan or inf, is hashed as a string. A label that does   *
+ * not parse as a number is a fatal error.                                      *
+ *                                                                              *
+ * The parser scans each line in place. It neither splits the line nor copies   *
+ * any token.                                                                   *
+ *                                                                              *
+ *   CriteoParser parser(13, 26, 20);                                           *
+ *   ReaderOptions options;                                                     *
+ *   options.parser = &parser;                                                  *
+ *   Reader reader(filename, num_samples, FFM, options);                        *
+ *   Model model(parser.GetNumberOfFeatures(), hyperparam, FFM, k,              *
+ *               parser.GetNumberOfColumns());                                  *
+ * -----------------------------------------------------------------------------
+ */
+class CriteoParser : public Parser {
+ public:
+  CriteoParser(index_t num_numeric = 13,
+               index_t num_categorical = 26,
+               int hash_bits = 20);
+  ~CriteoParser() {}
+
+  void Parse(const StringList& list, DMatrix& matrix);
+
+  // The columns and the hash bits decide the ids.
+  uint64 Fingerprint() const;
+
+  // Return the size of the feature space.
+  index_t GetNumberOfFeatures() const { return m_mask + 1; }
+
+  // Return the number of columns, which is the number of fields.
+  index_t GetNumberOfColumns() const {
+    return m_num_numeric + m_num_categorical;
+  }
+
+  // Return the bucket of a finite numeric value.
+  static int64 NumericBucket(double value);
+
+ private:
+  index_t m_num_numeric;            // the first columns are numeric.
+  index_t m_num_categorical;        // the others are categorical.
+  index_t m_mask;                   // 2^hash_bits - 1.
+
+  DISALLOW_COPY_AND_ASSIGN(CriteoParser);
+};
+
+} // namespace f2m
+
+#endif // F2M_READER_CRITEO_PARSER_H_
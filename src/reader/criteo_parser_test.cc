@@ -0,0 +1,157 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file tests criteo_parser.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "src/base/file_util.h"
+#include "src/data/data_structure.h"
+#include "src/reader/criteo_parser.h"
+#include "src/reader/reader.h"
+
+using std::string;
+using std::vector;
+
+namespace f2m {
+
+const index_t kNumNumeric = 3;
+const index_t kNumCategorical = 3;
+const int kHashBits = 20;
+
+TEST(CriteoParserTest, NumericBucket) {
+  EXPECT_EQ(CriteoParser::NumericBucket(-1), -1);
+  EXPECT_EQ(CriteoParser::NumericBucket(0), 0);
+  EXPECT_EQ(CriteoParser::NumericBucket(2), 2);
+  EXPECT_EQ(CriteoParser::NumericBucket(3), 4);
+  // log(100)^2 = 21.2 and log(110)^2 = 22.1
+  EXPECT_EQ(CriteoParser::NumericBucket(100), 24);
+  EXPECT_EQ(CriteoParser::NumericBucket(101), 24);
+  EXPECT_EQ(CriteoParser::NumericBucket(110), 25);
+}
+
+TEST(CriteoParserTest, ParseColumns) {
+  StringList list;
+  // Columns 1, 4 and 5 are missing.
+  list.push_back("1\t5\t\t100\tab12\t\t");
+  list.push_back("0\t101\tab12\t7\t\t05db9164\tab12");
+  list.push_back("0");
+  DMatrix matrix(list.size(), FFM);
+  matrix.InitSparseRow();
+  CriteoParser parser(kNumNumeric, kNumCategorical, kHashBits);
+  EXPECT_EQ(parser.GetNumberOfFeatures(), 1 << kHashBits);
+  EXPECT_EQ(parser.GetNumberOfColumns(), kNumNumeric + kNumCategorical);
+  parser.Parse(list, matrix);
+  EXPECT_EQ(matrix.Y[0], 1);
+  EXPECT_EQ(matrix.Y[1], 0);
+  SparseRow* row = matrix.row[0];
+  ASSERT_EQ(row->size, 3);
+  // Every value is 1.
+  EXPECT_TRUE(row->binary);
+  EXPECT_TRUE(row->X == NULL);
+  index_t fields[] = { 0, 2, 3 };
+  for (index_t j = 0; j < row->size; ++j) {
+    EXPECT_EQ(row->field[j], fields[j]);
+    EXPECT_LT(row->idx[j], 1 << kHashBits);
+  }
+  SparseRow* other = matrix.row[1];
+  ASSERT_EQ(other->size, 5);
+  // The same string in another column is another feature, and so
+  // is a numeric column that is not a number.
+  EXPECT_EQ(other->field[4], 5);
+  EXPECT_NE(other->idx[4], row->idx[2]);
+  EXPECT_NE(other->idx[1], row->idx[2]);
+  // 100 and 101 are in the same bucket of different columns.
+  EXPECT_NE(other->idx[0], row->idx[1]);
+  EXPECT_EQ(matrix.row[2]->size, 0);
+  // The same line always gives the same features.
+  list[1] = list[0];
+  parser.Parse(list, matrix);
+  for (index_t j = 0; j < row->size; ++j) {
+    EXPECT_EQ(matrix.row[1]->idx[j], row->idx[j]);
+  }
+}
+
+TEST(CriteoParserTest, SameBucketSameFeature) {
+  StringList list;
+  list.push_back("1\t100\t1\t\ta");
+  list.push_back("1\t101\t2\t\ta");
+  DMatrix matrix(list.size(), FM);
+  matrix.InitSparseRow();
+  CriteoParser parser(kNumNumeric, kNumCategorical, kHashBits);
+  parser.Parse(list, matrix);
+  ASSERT_EQ(matrix.row[0]->size, 3);
+  ASSERT_EQ(matrix.row[1]->size, 3);
+  EXPECT_EQ(matrix.row[0]->idx[0], matrix.row[1]->idx[0]);
+  EXPECT_NE(matrix.row[0]->idx[1], matrix.row[1]->idx[1]);
+  EXPECT_EQ(matrix.row[0]->idx[2], matrix.row[1]->idx[2]);
+  // Another feature space gives other ids.
+  CriteoParser other(kNumNumeric, kNumCategorical, kHashBits + 1);
+  EXPECT_NE(parser.Fingerprint(), other.Fingerprint());
+  EXPECT_NE(parser.Fingerprint(), Parser().Fingerprint());
+}
+
+TEST(CriteoParserTest, NonFiniteIsString) {
+  StringList list;
+  // Both are infinite, but they are different strings.
+  list.push_back("1\tinf");
+  list.push_back("1\t1e400");
+  list.push_back("1\tnan");
+  DMatrix matrix(list.size(), FM);
+  matrix.InitSparseRow();
+  CriteoParser parser(kNumNumeric, kNumCategorical, kHashBits);
+  parser.Parse(list, matrix);
+  for (index_t i = 0; i < matrix.row_size; ++i) {
+    ASSERT_EQ(matrix.row[i]->size, 1);
+  }
+  EXPECT_NE(matrix.row[0]->idx[0], matrix.row[1]->idx[0]);
+  EXPECT_NE(matrix.row[0]->idx[0], matrix.row[2]->idx[0]);
+}
+
+TEST(CriteoParserTest, ReadRawFile) {
+  const string kFilename = "/tmp/test_criteo_parser.txt";
+  const index_t kNumLines = 1000;
+  FILE* file = OpenFileOrDie(kFilename.c_str(), "w");
+  for (index_t i = 0; i < kNumLines; ++i) {
+    fprintf(file, "%d\t%u\t\t%u\t%x\t\t%x\n", i % 2, i, i % 7, i, i % 3);
+  }
+  Close(file);
+  CriteoParser parser(kNumNumeric, kNumCategorical, kHashBits);
+  ReaderOptions options(false, false);
+  options.parser = &parser;
+  Reader reader(kFilename, 100, FFM, options);
+  index_t num_rows = 0;
+  for (;;) {
+    DMatrix* matrix = reader.Samples();
+    if (matrix->row_size == 0) break;
+    for (index_t i = 0; i < matrix->row_size; ++i) {
+      ASSERT_EQ(matrix->row[i]->size, 4);
+      EXPECT_EQ(matrix->row[i]->field[3], 5);
+    }
+    num_rows += matrix->row_size;
+  }
+  EXPECT_EQ(num_rows, kNumLines);
+  unlink(kFilename.c_str());
+}
+
+} // namespace f2m
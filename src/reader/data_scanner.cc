@@ -0,0 +1,243 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file is the implementation of data_scanner.h
+*/
+
+#include "src/reader/data_scanner.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "src/base/char_scanner.h"
+#include "src/base/common.h"
+#include "src/base/file_util.h"
+#include "src/base/parallel.h"
+#include "src/base/parse_number.h"
+#include "src/base/timer.h"
+#include "src/reader/decompressor.h"
+#include "src/reader/parser.h"
+
+namespace f2m {
+
+// Every thread reads its range by blocks of this size.
+const uint32 kScanBlockSize = 4 * 1024 * 1024;
+// The longest line, the same as Reader.
+const uint32 kMaxScanLineSize = 100 * 1024;
+
+void DataStats::GetGradCapacity(ModelType type, index_t k,
+                                index_t batch_size,
+                                uint64* num_w, uint64* num_v) const {
+  CHECK_NOTNULL(num_w);
+  CHECK_NOTNULL(num_v);
+  *num_w = 0;
+  *num_v = 0;
+  // The largest batch holds the longest rows.
+  uint64 left = batch_size;
+  for (index_t r = row_size_hist.size(); r > 0 && left > 0; --r) {
+    uint64 rows = std::min<uint64>(row_size_hist[r - 1], left);
+    index_t size = r - 1;
+    left -= rows;
+    if (type == LR) {
+      *num_w += rows * size;
+    } else {
+      // The bias and the linear terms.
+      *num_w += rows * (size + 1);
+      *num_v += type == FM ? rows * size * k :
+                             rows * size * (size - 1) * k;
+    }
+  }
+}
+
+void DataStats::Merge(const DataStats& other) {
+  num_rows += other.num_rows;
+  nnz += other.nnz;
+  max_feature = std::max(max_feature, other.max_feature);
+  max_field = std::max(max_field, other.max_field);
+  max_row_size = std::max(max_row_size, other.max_row_size);
+  has_field = has_field || other.has_field;
+  if (row_size_hist.size() < other.row_size_hist.size()) {
+    row_size_hist.resize(other.row_size_hist.size(), 0);
+  }
+  for (size_t i = 0; i < other.row_size_hist.size(); ++i) {
+    row_size_hist[i] += other.row_size_hist[i];
+  }
+}
+
+namespace {
+
+void BadScanItem(const char* begin, const char* end) {
+  LOG(FATAL) << "Cannot scan the item: " << string(begin, end);
+}
+
+} // namespace
+
+void ScanLine(const char* begin, const char* end, ModelType type,
+              DataStats* stats) {
+  static const CharScanner delimiters(kDefaultDelimiters);
+  // Handle some windows txt format.
+  if (end > begin && end[-1] == '\r') --end;
+  index_t size = 0;
+  bool label = true;
+  delimiters.Split(begin, end, [&](const char* token,
+                                   const char* token_end) {
+    // Skip the label.
+    if (label) {
+      label = false;
+      return;
+    }
+    // The same items as Parser::Parse(): [ idx ] or [ idx:value ]
+    // for LR and FM, and [ field:idx ] or [ field:idx:value ] for
+    // FFM. The value is not read.
+    const char* pos = token;
+    if (type == FFM) {
+      index_t field = 0;
+      pos = ParseUInt32(pos, token_end, &field);
+      if (pos == NULL || pos == token_end || *pos != ':') {
+        BadScanItem(token, token_end);
+      }
+      pos++;
+      stats->has_field = true;
+      if (field > stats->max_field) stats->max_field = field;
+    }
+    index_t idx = 0;
+    pos = ParseUInt32(pos, token_end, &idx);
+    if (pos == NULL || (pos != token_end && *pos != ':')) {
+      BadScanItem(token, token_end);
+    }
+    if (idx > stats->max_feature) stats->max_feature = idx;
+    size++;
+  });
+  stats->num_rows++;
+  stats->nnz += size;
+  if (size > stats->max_row_size) stats->max_row_size = size;
+  if (stats->row_size_hist.size() <= size) {
+    stats->row_size_hist.resize(size + 1, 0);
+  }
+  stats->row_size_hist[size]++;
+}
+
+namespace {
+
+// Scan the lines that begin in [begin, end) of a plain file.
+void ScanRange(const string& filename, ModelType type,
+               uint64 begin, uint64 end, DataStats* stats) {
+  FILE* file = OpenFileOrDie(filename.c_str(), "r");
+  uint64 offset = begin;   // file offset of buffer[0].
+  if (begin > 0) {
+    // The line across |begin| belongs to the previous range,
+    // unless |begin| is the beginning of a line.
+    CHECK_EQ(fseeko(file, begin - 1, SEEK_SET), 0);
+    offset = begin - 1;
+    int c = 0;
+    do {
+      c = getc(file);
+      offset++;
+    } while (c != '\n' && c != EOF);
+  }
+  vector<char> buffer(kScanBlockSize + kMaxScanLineSize);
+  uint64 size = 0;         // bytes in the buffer.
+  uint64 line = 0;         // the beginning of the next line.
+  while (offset < end) {
+    size_t read_size = fread(buffer.data() + size, 1,
+                             buffer.size() - size, file);
+    size += read_size;
+    // Scan the complete lines that begin in the range.
+    while (offset + line < end) {
+      const char* line_begin = buffer.data() + line;
+      const char* newline = static_cast<const char*>(
+        memchr(line_begin, '\n', size - line));
+      if (newline == NULL) break;
+      ScanLine(line_begin, newline, type, stats);
+      line = newline - buffer.data() + 1;
+    }
+    if (offset + line >= end) break;
+    if (read_size == 0) {
+      // The last line of a file may not end with '\n'.
+      if (line < size) {
+        ScanLine(buffer.data() + line, buffer.data() + size, type,
+                 stats);
+      }
+      break;
+    }
+    if (size - line >= kMaxScanLineSize) {
+      LOG(FATAL) << "Encountered a too-long line.";
+    }
+    // Keep the partial line at the beginning of the buffer.
+    memmove(buffer.data(), buffer.data() + line, size - line);
+    offset += line;
+    size -= line;
+    line = 0;
+  }
+  Close(file);
+}
+
+} // namespace
+
+DataStats ScanData(const string& filename, ModelType type,
+                   int num_threads) {
+  CHECK_NE(filename.empty(), true);
+  if (num_threads <= 0) num_threads = GetNumberOfThreads();
+  Timer timer;
+  DataStats stats;
+  struct stat file_stat;
+  if (filename == "-" || stat(filename.c_str(), &file_stat) != 0 ||
+      !S_ISREG(file_stat.st_mode)) {
+    LOG(FATAL) << "Cannot scan " << filename
+               << ", which is not a regular file.";
+  }
+  if (Decompressor::IsCompressed(filename)) {
+    Decompressor decompressor(filename);
+    vector<char> line(kMaxScanLineSize);
+    for (;;) {
+      uint32 len = decompressor.ReadLine(line.data(), kMaxScanLineSize);
+      if (len == 0) break;
+      if (line[len - 1] == '\n') len--;
+      ScanLine(line.data(), line.data() + len, type, &stats);
+    }
+  } else {
+    uint64 file_size = file_stat.st_size;
+    // Small files are not worth the threads.
+    if (file_size < (uint64)num_threads * kScanBlockSize) {
+      num_threads = file_size / kScanBlockSize + 1;
+    }
+    vector<DataStats> parts(num_threads);
+    ParallelRun(num_threads, [&](int id) {
+      ScanRange(filename, type,
+                SplitBegin(file_size, num_threads, id),
+                SplitBegin(file_size, num_threads, id + 1),
+                &parts[id]);
+    });
+    for (int i = 0; i < num_threads; ++i) {
+      stats.Merge(parts[i]);
+    }
+  }
+  LOG(INFO) << "Scanned " << filename << " in " << timer.Elapsed()
+            << " seconds. rows: " << stats.num_rows
+            << " nnz: " << stats.nnz
+            << " features: " << stats.GetNumberOfFeatures()
+            << " fields: " << stats.GetNumberOfFields()
+            << " max row size: " << stats.max_row_size;
+  return stats;
+}
+
+} // namespace f2m
@@ -0,0 +1,107 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file defines ScanData(), which scans a data file before
+training to find out the shape of the model it needs.
+*/
+
+#ifndef F2M_READER_DATA_SCANNER_H_
+#define F2M_READER_DATA_SCANNER_H_
+
+#include <string>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/data/data_structure.h"
+
+using std::string;
+using std::vector;
+
+namespace f2m {
+
+// The shape of a data set in the idx:value or the
+// field:idx:value format.
+struct DataStats {
+  DataStats()
+    : num_rows(0), nnz(0), max_feature(0), max_field(0),
+      max_row_size(0), has_field(false) {}
+
+  uint64 num_rows;                  // number of lines.
+  uint64 nnz;                       // number of features of all rows.
+  index_t max_feature;              // the largest feature id.
+  index_t max_field;                // the largest field id.
+  index_t max_row_size;             // features of the longest row.
+  bool has_field;                   // in the field:idx:value format.
+  vector<uint64> row_size_hist;     // number of rows of each size.
+
+  // Return the feature_num and the field_num of a Model,
+  // which holds all the features and fields of the data.
+  index_t GetNumberOfFeatures() const {
+    return nnz > 0 ? max_feature + 1 : 0;
+  }
+  index_t GetNumberOfFields() const {
+    return has_field ? max_field + 1 : 0;
+  }
+
+  // Return the most linear and latent gradients that any batch
+  // of |batch_size| rows can give, which is the size of a
+  // SparseGrad that never grows during training.
+  void GetGradCapacity(ModelType type, index_t k, index_t batch_size,
+                       uint64* num_w, uint64* num_v) const;
+
+  // Add the stats of another part of the data.
+  void Merge(const DataStats& other);
+};
+
+/* -----------------------------------------------------------------------------
+ * ScanData() reads a data file once before training, so that the model can be  *
+ * sized exactly instead of by a guess:                                         *
+ *                                                                              *
+ *   DataStats stats = ScanData(filename, FFM);                                 *
+ *   Model model(stats.GetNumberOfFeatures(), hyperparam, FFM, k,               *
+ *               stats.GetNumberOfFields());                                    *
+ *   uint64 num_w, num_v;                                                       *
+ *   stats.GetGradCapacity(FFM, k, batch_size, &num_w, &num_v);                 *
+ *   SparseGrad grad(FFM);                                                      *
+ *   grad.reserve(num_w, num_v);                                                *
+ *                                                                              *
+ * OnlineLearner::Reserve() does the last four lines for the learner's own      *
+ * gradient, and checks the model against the stats.                            *
+ *                                                                              *
+ * A model that is too small for the data is indexed out of bounds by the       *
+ * losses, which do not check the feature ids for speed.                        *
+ *                                                                              *
+ * The scan reads the items of a line as Parser does for the model type, so     *
+ * that [ idx ] and [ field:idx ] without a value are counted too, but it does  *
+ * not parse the values or build any row. A bad or overflowing id is fatal. A   *
+ * plain file is split into even byte ranges that are scanned on num_threads    *
+ * threads, each with its own file handle, and a line belongs to the range of   *
+ * its first byte. A compressed file is scanned on one thread, as it cannot be  *
+ * split. Pipes and the stdin cannot be read twice, so they cannot be scanned.  *
+ * -----------------------------------------------------------------------------
+ */
+DataStats ScanData(const string& filename, ModelType type,
+                   int num_threads = 0);
+
+// Add the stats of one line [begin, end) of a |type| data set to
+// |stats|. The items of the line are separated by the default
+// delimiters of Parser.
+void ScanLine(const char* begin, const char* end, ModelType type,
+              DataStats* stats);
+
+} // namespace f2m
+
+#endif // F2M_READER_DATA_SCANNER_H_
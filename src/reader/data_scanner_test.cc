@@ -0,0 +1,202 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file tests data_scanner.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "src/base/file_util.h"
+#include "src/data/data_structure.h"
+#include "src/reader/data_scanner.h"
+#include "src/reader/reader.h"
+
+using std::string;
+using std::vector;
+
+namespace f2m {
+
+const string kPlainFile = "/tmp/test_data_scanner.txt";
+const string kGzipFile = "/tmp/test_data_scanner.txt.gz";
+
+TEST(DataScannerTest, ScanLine) {
+  DataStats stats;
+  const char* lr = "1\t3:0.5\t10:1\r";
+  ScanLine(lr, lr + strlen(lr), LR, &stats);
+  const char* ffm = "0\t2:7:0.5\t1:4:1\t5:3:1";
+  ScanLine(ffm, ffm + strlen(ffm), FFM, &stats);
+  const char* empty = "0";
+  ScanLine(empty, empty + strlen(empty), FFM, &stats);
+  EXPECT_EQ(stats.num_rows, 3);
+  EXPECT_EQ(stats.nnz, 5);
+  EXPECT_EQ(stats.max_feature, 10);
+  EXPECT_EQ(stats.max_field, 5);
+  EXPECT_EQ(stats.max_row_size, 3);
+  EXPECT_TRUE(stats.has_field);
+  EXPECT_EQ(stats.GetNumberOfFeatures(), 11);
+  EXPECT_EQ(stats.GetNumberOfFields(), 6);
+  ASSERT_EQ(stats.row_size_hist.size(), 4);
+  EXPECT_EQ(stats.row_size_hist[0], 1);
+  EXPECT_EQ(stats.row_size_hist[2], 1);
+  EXPECT_EQ(stats.row_size_hist[3], 1);
+}
+
+TEST(DataScannerTest, ScanLineWithoutValue) {
+  // A binary LR line, where the values are omitted.
+  DataStats lr_stats;
+  const char* lr = "1\t3\t12 4:1";
+  ScanLine(lr, lr + strlen(lr), LR, &lr_stats);
+  EXPECT_EQ(lr_stats.nnz, 3);
+  EXPECT_EQ(lr_stats.max_feature, 12);
+  EXPECT_FALSE(lr_stats.has_field);
+  EXPECT_EQ(lr_stats.GetNumberOfFeatures(), 13);
+  EXPECT_EQ(lr_stats.GetNumberOfFields(), 0);
+  // A binary FFM line, where [ field:idx ] has one colon.
+  DataStats ffm_stats;
+  const char* ffm = "0\t2:7\t9:4\t1:20:0.5";
+  ScanLine(ffm, ffm + strlen(ffm), FFM, &ffm_stats);
+  EXPECT_EQ(ffm_stats.nnz, 3);
+  EXPECT_EQ(ffm_stats.max_feature, 20);
+  EXPECT_EQ(ffm_stats.max_field, 9);
+  EXPECT_EQ(ffm_stats.GetNumberOfFeatures(), 21);
+  EXPECT_EQ(ffm_stats.GetNumberOfFields(), 10);
+  // The largest id, which fits in uint32.
+  DataStats max_stats;
+  const char* max = "1\t4294967295";
+  ScanLine(max, max + strlen(max), LR, &max_stats);
+  EXPECT_EQ(max_stats.max_feature, 4294967295u);
+}
+
+TEST(DataScannerTest, ScanThenParse) {
+  // Every item form that Parser accepts, each with the largest
+  // id of some lines, and the delimiters and the \r of a line,
+  // read by the scanner and by Reader.
+  const char* kLines[2][4] = {
+    { "1\t3:0.5\t10:1",
+      "0 17 4",
+      "1\t 2:1  25\r",
+      "0" },
+    { "1\t2:7:0.5\t1:4:1",
+      "0 8:3 2:30",
+      "1\t 11:1:1  3:5\r",
+      "0" },
+  };
+  const ModelType kTypes[2] = { LR, FFM };
+  for (int t = 0; t < 2; ++t) {
+    string text;
+    for (int i = 0; i < 4; ++i) {
+      text += string(kLines[t][i]) + "\n";
+    }
+    FILE* file = OpenFileOrDie(kPlainFile.c_str(), "w");
+    fwrite(text.data(), 1, text.size(), file);
+    Close(file);
+    DataStats stats = ScanData(kPlainFile, kTypes[t]);
+    Reader reader(kPlainFile, 4, kTypes[t], ReaderOptions(false, true));
+    DMatrix* matrix = reader.Samples();
+    unlink(kPlainFile.c_str());
+    ASSERT_TRUE(matrix != NULL);
+    // The scanned bounds hold every parsed id, and are tight.
+    uint64 nnz = 0;
+    index_t max_feature = 0, max_field = 0;
+    for (index_t i = 0; i < matrix->row_size; ++i) {
+      SparseRow* row = matrix->row[i];
+      for (index_t j = 0; j < row->size; ++j) {
+        EXPECT_LT(row->idx[j], stats.GetNumberOfFeatures());
+        max_feature = std::max(max_feature, row->idx[j]);
+        if (kTypes[t] == FFM) {
+          EXPECT_LT(row->field[j], stats.GetNumberOfFields());
+          max_field = std::max(max_field, row->field[j]);
+        }
+      }
+      nnz += row->size;
+    }
+    EXPECT_EQ(stats.num_rows, matrix->row_size);
+    EXPECT_EQ(stats.nnz, nnz);
+    EXPECT_EQ(stats.GetNumberOfFeatures(), max_feature + 1);
+    EXPECT_EQ(stats.GetNumberOfFields(),
+              kTypes[t] == FFM ? max_field + 1 : 0);
+  }
+}
+
+TEST(DataScannerTest, GradCapacity) {
+  DataStats stats;
+  // 10 rows of 2 features and 1 row of 4 features.
+  uint64 hist[] = { 0, 0, 10, 0, 1 };
+  stats.row_size_hist.assign(hist, hist + 5);
+  uint64 num_w = 0, num_v = 0;
+  stats.GetGradCapacity(LR, 0, 3, &num_w, &num_v);
+  EXPECT_EQ(num_w, 4 + 2 * 2);
+  EXPECT_EQ(num_v, 0);
+  stats.GetGradCapacity(FM, 8, 3, &num_w, &num_v);
+  EXPECT_EQ(num_w, 5 + 2 * 3);
+  EXPECT_EQ(num_v, (4 + 2 * 2) * 8);
+  stats.GetGradCapacity(FFM, 8, 100, &num_w, &num_v);
+  EXPECT_EQ(num_w, 5 + 10 * 3);
+  EXPECT_EQ(num_v, (4 * 3 + 10 * 2 * 1) * 8);
+}
+
+TEST(DataScannerTest, ParallelScan) {
+  // Large enough for several threads, with lines
+  // of different length across the ranges.
+  string text;
+  DataStats expected;
+  for (index_t i = 0; text.size() < 20 * 1024 * 1024; ++i) {
+    string line = "1";
+    for (index_t j = 0; j < i % 13; ++j) {
+      char token[64];
+      snprintf(token, sizeof(token), "\t%u:%u:0.5",
+               j, (i * 7919 + j) % 1000003);
+      line.append(token);
+    }
+    ScanLine(line.data(), line.data() + line.size(), FFM, &expected);
+    text += line + "\n";
+  }
+  // The last line does not end with '\n'.
+  text += "0\t1:1:1";
+  ScanLine(text.data() + text.size() - 7, text.data() + text.size(),
+           FFM, &expected);
+  FILE* file = OpenFileOrDie(kPlainFile.c_str(), "w");
+  fwrite(text.data(), 1, text.size(), file);
+  Close(file);
+  gzFile gz_file = gzopen(kGzipFile.c_str(), "wb");
+  gzwrite(gz_file, text.data(), text.size());
+  gzclose(gz_file);
+  const string kFiles[] = { kPlainFile, kGzipFile };
+  for (int f = 0; f < 2; ++f) {
+    for (int num_threads = 1; num_threads <= 4; ++num_threads) {
+      DataStats stats = ScanData(kFiles[f], FFM, num_threads);
+      EXPECT_EQ(stats.num_rows, expected.num_rows);
+      EXPECT_EQ(stats.nnz, expected.nnz);
+      EXPECT_EQ(stats.max_feature, expected.max_feature);
+      EXPECT_EQ(stats.max_field, expected.max_field);
+      EXPECT_EQ(stats.max_row_size, expected.max_row_size);
+      EXPECT_EQ(stats.row_size_hist, expected.row_size_hist);
+    }
+  }
+  unlink(kPlainFile.c_str());
+  unlink(kGzipFile.c_str());
+}
+
+} // namespace f2m
@@ -0,0 +1,307 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file is the implementation of decompressor.h
+*/
+
+#include "src/reader/decompressor.h"
+
+#include <string.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/base/file_util.h"
+
+using std::string;
+using std::vector;
+
+namespace f2m {
+
+const unsigned char kGzipMagic[] = { 0x1f, 0x8b };
+const unsigned char kZstdMagic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+
+// Read the first bytes of the file. Pipes are skipped, because
+// reading them would consume the data.
+static uint32 ReadMagic(const string& filename, unsigned char* magic) {
+  struct stat file_stat;
+  if (stat(filename.c_str(), &file_stat) != 0 ||
+      !S_ISREG(file_stat.st_mode)) {
+    return 0;
+  }
+  FILE* file = fopen(filename.c_str(), "r");
+  if (file == NULL) return 0;
+  uint32 len = fread(magic, 1, 4, file);
+  Close(file);
+  return len;
+}
+
+bool Decompressor::IsCompressed(const string& filename) {
+  unsigned char magic[4];
+  uint32 len = ReadMagic(filename, magic);
+  return (len >= 2 && memcmp(magic, kGzipMagic, 2) == 0) ||
+         (len >= 4 && memcmp(magic, kZstdMagic, 4) == 0);
+}
+
+Decompressor::Decompressor(const string& filename,
+                           uint32 block_size,
+                           int num_blocks)
+  : m_filename(filename),
+    m_block_size(block_size),
+    m_current(NULL),
+    m_pos(0),
+    m_eof(false),
+    m_stop(false),
+    m_gz_file(NULL) {
+  CHECK_GT(m_block_size, 0);
+  CHECK_GT(num_blocks, 0);
+  unsigned char magic[4];
+  uint32 len = ReadMagic(m_filename, magic);
+  if (len >= 2 && memcmp(magic, kGzipMagic, 2) == 0) {
+    m_format = GZIP;
+    m_gz_file = gzopen(m_filename.c_str(), "rb");
+    if (m_gz_file == NULL) {
+      LOG(FATAL) << "Cannot open file: " << m_filename;
+    }
+    // A large internal buffer means fewer read() calls.
+    gzbuffer(m_gz_file, 1024 * 1024);
+  } else if (len >= 4 && memcmp(magic, kZstdMagic, 4) == 0) {
+    m_format = ZSTD;
+#ifdef F2M_USE_ZSTD
+    m_file = OpenFileOrDie(m_filename.c_str(), "r");
+    m_zstd_stream = ZSTD_createDStream();
+    CHECK_NOTNULL(m_zstd_stream);
+    ZSTD_initDStream(m_zstd_stream);
+    m_zstd_in.resize(ZSTD_DStreamInSize());
+    m_in_size = 0;
+    m_in_pos = 0;
+    m_in_eof = false;
+    m_zstd_ret = 0;
+#else
+    LOG(FATAL) << "f2m was built without zstd support: " << m_filename;
+#endif
+  } else {
+    LOG(FATAL) << "Unknown compression format: " << m_filename;
+  }
+  m_blocks.resize(num_blocks);
+  for (int i = 0; i < num_blocks; ++i) {
+    m_blocks[i].data.resize(m_block_size);
+    m_blocks[i].size = 0;
+    m_free.push_back(&m_blocks[i]);
+  }
+  Start();
+}
+
+Decompressor::~Decompressor() {
+  Stop();
+  if (m_format == GZIP) {
+    gzclose(m_gz_file);
+  }
+#ifdef F2M_USE_ZSTD
+  if (m_format == ZSTD) {
+    ZSTD_freeDStream(m_zstd_stream);
+    Close(m_file);
+  }
+#endif
+}
+
+void Decompressor::Start() {
+  m_stop = false;
+  m_thread = std::thread(&Decompressor::Produce, this);
+}
+
+void Decompressor::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cond.notify_all();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+void Decompressor::Produce() {
+  for (;;) {
+    Block* block = NULL;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cond.wait(lock, [this] { return m_stop || !m_free.empty(); });
+      if (m_stop) return;
+      block = m_free.front();
+      m_free.pop_front();
+    }
+    // Decompress without holding the lock.
+    block->size = Decompress(block->data.data(), m_block_size);
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_full.push_back(block);
+    }
+    m_cond.notify_all();
+    // The empty block marks the end of file.
+    if (block->size == 0) return;
+  }
+}
+
+uint32 Decompressor::Decompress(char* buf, uint32 len) {
+  uint32 total = 0;
+  if (m_format == GZIP) {
+    while (total < len) {
+      int read_len = gzread(m_gz_file, buf + total, len - total);
+      if (read_len < 0) {
+        int errnum = 0;
+        LOG(FATAL) << "Decompress " << m_filename << " error: "
+                   << gzerror(m_gz_file, &errnum);
+      }
+      if (read_len == 0) {
+        // A file that ends before the gzip trailer is not a clean
+        // end of file, and neither is a bad trailer.
+        int errnum = 0;
+        const char* error = gzerror(m_gz_file, &errnum);
+        if (errnum != Z_OK || !gzeof(m_gz_file)) {
+          LOG(FATAL) << "Decompress " << m_filename << " error: "
+                     << (errnum != Z_OK ? error : "truncated file");
+        }
+        break;
+      }
+      total += read_len;
+    }
+  }
+#ifdef F2M_USE_ZSTD
+  if (m_format == ZSTD) {
+    ZSTD_outBuffer output = { buf, len, 0 };
+    while (output.pos < output.size) {
+      if (m_in_pos == m_in_size && !m_in_eof) {
+        m_in_size = fread(m_zstd_in.data(), 1, m_zstd_in.size(), m_file);
+        m_in_pos = 0;
+        m_in_eof = (m_in_size == 0);
+      }
+      ZSTD_inBuffer input = { m_zstd_in.data(), m_in_size, m_in_pos };
+      size_t last_pos = output.pos;
+      size_t ret = ZSTD_decompressStream(m_zstd_stream, &output, &input);
+      if (ZSTD_isError(ret)) {
+        LOG(FATAL) << "Decompress " << m_filename << " error: "
+                   << ZSTD_getErrorName(ret);
+      }
+      // 0 once a frame is complete. A call that does nothing
+      // after the end of a frame returns the size of the next
+      // frame header, so keep the last one that did something.
+      if (input.pos != m_in_pos || output.pos != last_pos) {
+        m_zstd_ret = ret;
+      }
+      m_in_pos = input.pos;
+      // Flushed all the buffered output.
+      if (m_in_eof && output.pos == last_pos) {
+        if (m_zstd_ret != 0) {
+          LOG(FATAL) << "Decompress " << m_filename
+                     << " error: truncated file";
+        }
+        break;
+      }
+    }
+    total = output.pos;
+  }
+#endif
+  return total;
+}
+
+bool Decompressor::NextBlock() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (m_current != NULL) {
+    m_free.push_back(m_current);
+    m_current = NULL;
+    m_cond.notify_all();
+  }
+  m_cond.wait(lock, [this] { return !m_full.empty(); });
+  m_current = m_full.front();
+  m_full.pop_front();
+  m_pos = 0;
+  if (m_current->size == 0) {
+    m_eof = true;
+    return false;
+  }
+  return true;
+}
+
+uint32 Decompressor::ReadLine(char* line, uint32 max_len) {
+  CHECK_GT(max_len, 1);
+  uint32 len = 0;
+  while (!m_eof && len + 1 < max_len) {
+    if (m_current == NULL || m_pos == m_current->size) {
+      if (!NextBlock()) break;
+    }
+    const char* begin = m_current->data.data() + m_pos;
+    uint32 copy_len = m_current->size - m_pos;
+    if (copy_len > max_len - 1 - len) {
+      copy_len = max_len - 1 - len;
+    }
+    const char* end = static_cast<const char*>(memchr(begin, '\n', copy_len));
+    if (end != NULL) {
+      copy_len = end - begin + 1;
+    }
+    memcpy(line + len, begin, copy_len);
+    len += copy_len;
+    m_pos += copy_len;
+    if (end != NULL) break;
+  }
+  line[len] = '\0';
+  return len;
+}
+
+void Decompressor::ReadAll(vector<char>* buf) {
+  CHECK_NOTNULL(buf);
+  while (!m_eof) {
+    if (m_current == NULL || m_pos == m_current->size) {
+      if (!NextBlock()) break;
+    }
+    buf->insert(buf->end(),
+                m_current->data.begin() + m_pos,
+                m_current->data.begin() + m_current->size);
+    m_pos = m_current->size;
+  }
+}
+
+void Decompressor::Rewind() {
+  Stop();
+  // All the blocks are free again.
+  m_free.clear();
+  m_full.clear();
+  for (size_t i = 0; i < m_blocks.size(); ++i) {
+    m_free.push_back(&m_blocks[i]);
+  }
+  m_current = NULL;
+  m_pos = 0;
+  m_eof = false;
+  if (m_format == GZIP) {
+    CHECK_EQ(gzrewind(m_gz_file), 0);
+  }
+#ifdef F2M_USE_ZSTD
+  if (m_format == ZSTD) {
+    rewind(m_file);
+    ZSTD_initDStream(m_zstd_stream);
+    m_in_size = 0;
+    m_in_pos = 0;
+    m_in_eof = false;
+    m_zstd_ret = 0;
+  }
+#endif
+  Start();
+}
+
+} // namespace f2m
@@ -0,0 +1,120 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file defines Decompressor, which decompresses a gzip or
+zstd file on a dedicated thread.
+*/
+
+#ifndef F2M_READER_DECOMPRESSOR_H_
+#define F2M_READER_DECOMPRESSOR_H_
+
+#include <stdio.h>
+#include <zlib.h>
+#ifdef F2M_USE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/base/common.h"
+
+using std::string;
+using std::vector;
+
+namespace f2m {
+
+// Decompressor reads a .gz or .zst file and returns its plain text.
+// Decompression runs on a dedicated thread, which fills large blocks
+// of text and hands them over through a bounded queue. In this way,
+// the CPU-bound decompression overlaps with parsing and training,
+// and no plain text is ever written to the disk.
+class Decompressor {
+ public:
+  enum Format { GZIP, ZSTD };
+
+  Decompressor(const string& filename,
+               uint32 block_size = 4 * 1024 * 1024,
+               int num_blocks = 4);
+  ~Decompressor();
+
+  // Return true if the file begins with the gzip or zstd magic number.
+  static bool IsCompressed(const string& filename);
+
+  // Read one line like fgets(): at most max_len-1 bytes including
+  // the '\n' are copied to |line|, which is then null-terminated.
+  // Return the number of bytes copied, or 0 at the end of file.
+  uint32 ReadLine(char* line, uint32 max_len);
+
+  // Append all the remaining text to |buf|.
+  void ReadAll(vector<char>* buf);
+
+  // Return to the beginning of the file.
+  void Rewind();
+
+ private:
+  struct Block {
+    vector<char> data;
+    uint32 size;                    // 0 marks the end of file.
+  };
+
+  string m_filename;                // the compressed file.
+  Format m_format;                  // enum Format { GZIP, ZSTD }
+  uint32 m_block_size;              // max plain bytes of each block.
+
+  vector<Block> m_blocks;           // all the blocks.
+  std::deque<Block*> m_free;        // blocks to be filled.
+  std::deque<Block*> m_full;        // blocks to be read.
+  Block* m_current;                 // the block we are reading.
+  uint32 m_pos;                     // read position in m_current.
+  bool m_eof;                       // reached the end of file.
+
+  std::thread m_thread;             // the decompression thread.
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  bool m_stop;                      // ask the thread to quit.
+
+  gzFile m_gz_file;                 // for GZIP.
+#ifdef F2M_USE_ZSTD
+  FILE* m_file;                     // for ZSTD.
+  ZSTD_DStream* m_zstd_stream;
+  vector<char> m_zstd_in;           // compressed input buffer.
+  size_t m_in_size;                 // bytes in m_zstd_in.
+  size_t m_in_pos;                  // read position in m_zstd_in.
+  bool m_in_eof;                    // no more compressed input.
+  size_t m_zstd_ret;                // 0 if the last frame is complete.
+#endif
+
+  // Main loop of the decompression thread.
+  void Produce();
+  // Fill |buf| with at most |len| plain bytes.
+  uint32 Decompress(char* buf, uint32 len);
+  // Switch m_current to the next full block.
+  bool NextBlock();
+  void Start();
+  void Stop();
+
+  DISALLOW_COPY_AND_ASSIGN(Decompressor);
+};
+
+} // namespace f2m
+
+#endif // F2M_READER_DECOMPRESSOR_H_
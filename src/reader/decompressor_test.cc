@@ -0,0 +1,182 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file tests decompressor.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+#include <zlib.h>
+#ifdef F2M_USE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <string>
+#include <vector>
+
+#include "src/base/file_util.h"
+#include "src/data/data_structure.h"
+#include "src/reader/decompressor.h"
+#include "src/reader/reader.h"
+
+using std::string;
+using std::vector;
+
+namespace f2m {
+
+const string kPlainFile = "/tmp/test_decompressor.txt";
+const string kGzipFile = "/tmp/test_decompressor.txt.gz";
+const string kZstdFile = "/tmp/test_decompressor.txt.zst";
+const index_t kNumLines = 10000;
+const index_t kNumSamples = 100;
+const uint32 kMaxLen = 1024;
+
+// Lines of different length, so they cross the block boundaries.
+string Line(index_t i) {
+  string line = "1";
+  for (index_t j = 0; j <= i % 5; ++j) {
+    line += "\t" + std::to_string(j) + ":0.5";
+  }
+  return line + "\n";
+}
+
+class DecompressorTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    string text;
+    for (index_t i = 0; i < kNumLines; ++i) {
+      text += Line(i);
+    }
+    FILE* file = OpenFileOrDie(kPlainFile.c_str(), "w");
+    WriteDataToDisk(file, text.data(), text.size());
+    Close(file);
+    gzFile gz_file = gzopen(kGzipFile.c_str(), "wb");
+    ASSERT_TRUE(gz_file != NULL);
+    EXPECT_EQ(gzwrite(gz_file, text.data(), text.size()), text.size());
+    gzclose(gz_file);
+#ifdef F2M_USE_ZSTD
+    vector<char> buf(ZSTD_compressBound(text.size()));
+    size_t len = ZSTD_compress(buf.data(), buf.size(),
+                               text.data(), text.size(), 1);
+    ASSERT_FALSE(ZSTD_isError(len));
+    file = OpenFileOrDie(kZstdFile.c_str(), "w");
+    WriteDataToDisk(file, buf.data(), len);
+    Close(file);
+#endif
+  }
+};
+
+void CheckLines(Decompressor* decompressor) {
+  char line[kMaxLen];
+  for (index_t i = 0; i < kNumLines; ++i) {
+    uint32 len = decompressor->ReadLine(line, kMaxLen);
+    EXPECT_EQ(string(line, len), Line(i));
+  }
+  EXPECT_EQ(decompressor->ReadLine(line, kMaxLen), 0);
+}
+
+TEST_F(DecompressorTest, IsCompressed) {
+  EXPECT_FALSE(Decompressor::IsCompressed(kPlainFile));
+  EXPECT_TRUE(Decompressor::IsCompressed(kGzipFile));
+}
+
+TEST_F(DecompressorTest, ReadLineAcrossBlocks) {
+  // Tiny blocks split almost every line.
+  Decompressor decompressor(kGzipFile, 7, 3);
+  CheckLines(&decompressor);
+  decompressor.Rewind();
+  CheckLines(&decompressor);
+}
+
+TEST_F(DecompressorTest, ReadAll) {
+  Decompressor decompressor(kGzipFile, 4096, 2);
+  char line[kMaxLen];
+  uint32 len = decompressor.ReadLine(line, kMaxLen);
+  EXPECT_EQ(string(line, len), Line(0));
+  vector<char> buf;
+  decompressor.ReadAll(&buf);
+  string text;
+  for (index_t i = 1; i < kNumLines; ++i) {
+    text += Line(i);
+  }
+  EXPECT_EQ(string(buf.begin(), buf.end()), text);
+}
+
+#ifdef F2M_USE_ZSTD
+TEST_F(DecompressorTest, Zstd) {
+  EXPECT_TRUE(Decompressor::IsCompressed(kZstdFile));
+  Decompressor decompressor(kZstdFile, 7, 3);
+  CheckLines(&decompressor);
+  decompressor.Rewind();
+  CheckLines(&decompressor);
+}
+#endif
+
+// Copy the first half of |filename| into |truncated|.
+void WriteTruncated(const string& filename, const string& truncated) {
+  FILE* file = OpenFileOrDie(filename.c_str(), "r");
+  vector<char> buf(1 << 20);
+  size_t len = fread(buf.data(), 1, buf.size(), file);
+  Close(file);
+  file = OpenFileOrDie(truncated.c_str(), "w");
+  WriteDataToDisk(file, buf.data(), len / 2);
+  Close(file);
+}
+
+// Read all of |filename|, which must not end cleanly.
+void ReadAll(const string& filename) {
+  Decompressor decompressor(filename);
+  vector<char> buf;
+  decompressor.ReadAll(&buf);
+}
+
+TEST_F(DecompressorTest, Truncated) {
+  // A truncated file is an error, not a shorter file.
+  string gz_truncated = kGzipFile + ".part";
+  WriteTruncated(kGzipFile, gz_truncated);
+  EXPECT_DEATH(ReadAll(gz_truncated), "part error");
+  unlink(gz_truncated.c_str());
+#ifdef F2M_USE_ZSTD
+  string zstd_truncated = kZstdFile + ".part";
+  WriteTruncated(kZstdFile, zstd_truncated);
+  EXPECT_DEATH(ReadAll(zstd_truncated), "truncated file");
+  unlink(zstd_truncated.c_str());
+#endif
+}
+
+TEST_F(DecompressorTest, Reader) {
+  // Read the compressed file from disk in a loop.
+  Reader reader_disk(kGzipFile, kNumSamples, LR, true);
+  for (index_t i = 0; i < 3 * kNumLines / kNumSamples; ++i) {
+    DMatrix* matrix = reader_disk.Samples();
+    EXPECT_EQ(matrix->row_size, kNumSamples);
+    EXPECT_EQ(matrix->row[0]->size, 1);
+    EXPECT_EQ(matrix->row[kNumSamples-1]->size, 5);
+  }
+  // Load the compressed file into memory.
+  Reader reader_mem(kGzipFile, kNumSamples, LR, false, true);
+  index_t num_rows = 0;
+  for (;;) {
+    DMatrix* matrix = reader_mem.Samples();
+    num_rows += matrix->row_size;
+    if (matrix->row_size != kNumSamples) break;
+  }
+  EXPECT_EQ(num_rows, kNumLines);
+}
+
+} // namespace f2m
@@ -0,0 +1,158 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file is the implementation of feature_filter.h
+*/
+
+#include "src/reader/feature_filter.h"
+
+#include <stdio.h>
+
+#include <random>
+
+#include "src/base/common.h"
+#include "src/base/file_util.h"
+
+namespace f2m {
+
+const index_t FeatureFilter::kRareFeature;
+
+FeatureFilter::FeatureFilter(uint32 min_count,
+                             index_t max_features,
+                             uint32 width,
+                             int depth)
+  : m_min_count(min_count),
+    m_max_features(max_features),
+    m_width(width),
+    m_depth(depth),
+    m_frozen(false),
+    m_num_rare(0),
+    m_num_occurrences(0) {
+  CHECK_GT(m_min_count, 0);
+  CHECK_GT(m_max_features, 1);
+  CHECK_GT(m_depth, 0);
+  // The multiply-shift hash needs a power of 2.
+  CHECK_GT(m_width, 1);
+  CHECK_EQ(m_width & (m_width - 1), 0);
+  m_shift = 64;
+  for (uint32 w = m_width; w > 1; w >>= 1) m_shift--;
+  // Random odd multipliers, one for each row.
+  std::mt19937_64 rng(m_width + m_depth);
+  m_seeds.resize(m_depth);
+  for (int d = 0; d < m_depth; ++d) {
+    m_seeds[d] = rng() | 1;
+  }
+  m_counters.resize((uint64)m_depth * m_width, 0);
+}
+
+void FeatureFilter::Filter(DMatrix& matrix) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  CountRows(matrix);
+  RemapRows(matrix);
+}
+
+void FeatureFilter::Count(const DMatrix& matrix) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  CountRows(matrix);
+}
+
+void FeatureFilter::Remap(DMatrix& matrix) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  RemapRows(matrix);
+}
+
+void FeatureFilter::CountRows(const DMatrix& matrix) {
+  if (m_frozen) return;
+  for (index_t i = 0; i < matrix.row_size; ++i) {
+    const SparseRow* row = matrix.row[i];
+    for (index_t j = 0; j < row->size; ++j) {
+      Add(row->idx[j]);
+    }
+  }
+}
+
+void FeatureFilter::RemapRows(DMatrix& matrix) {
+  for (index_t i = 0; i < matrix.row_size; ++i) {
+    SparseRow* row = matrix.row[i];
+    for (index_t j = 0; j < row->size; ++j) {
+      row->idx[j] = Map(row->idx[j]);
+    }
+    m_num_occurrences += row->size;
+  }
+}
+
+uint32 FeatureFilter::Estimate(index_t id) const {
+  uint32 count = m_counters[Slot(0, id)];
+  for (int d = 1; d < m_depth; ++d) {
+    if (m_counters[Slot(d, id)] < count) {
+      count = m_counters[Slot(d, id)];
+    }
+  }
+  return count;
+}
+
+void FeatureFilter::Add(index_t id) {
+  // Admitted features need no more counting.
+  if (m_admitted.count(id) > 0) return;
+  // Conservative update: the estimate becomes count + 1,
+  // and no counter is increased beyond it.
+  uint32 count = Estimate(id) + 1;
+  if (count == 0) return;  // saturated.
+  for (int d = 0; d < m_depth; ++d) {
+    uint32& counter = m_counters[Slot(d, id)];
+    if (counter < count) counter = count;
+  }
+}
+
+index_t FeatureFilter::Map(index_t id) {
+  std::unordered_map<index_t, index_t>::const_iterator it =
+    m_admitted.find(id);
+  if (it != m_admitted.end()) return it->second;
+  if (m_frozen ||
+      Estimate(id) < m_min_count ||
+      m_admitted.size() + 1 >= m_max_features) {
+    m_num_rare++;
+    return kRareFeature;
+  }
+  index_t model_id = m_admitted.size() + 1;
+  m_admitted[id] = model_id;
+  return model_id;
+}
+
+void FeatureFilter::Save(const string& filename) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  FILE* file = OpenFileOrDie(filename.c_str(), "w");
+  for (std::unordered_map<index_t, index_t>::const_iterator it =
+       m_admitted.begin(); it != m_admitted.end(); ++it) {
+    fprintf(file, "%u %u\n", it->first, it->second);
+  }
+  Close(file);
+}
+
+void FeatureFilter::Load(const string& filename) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  FILE* file = OpenFileOrDie(filename.c_str(), "r");
+  m_admitted.clear();
+  index_t id = 0, model_id = 0;
+  while (fscanf(file, "%u %u", &id, &model_id) == 2) {
+    CHECK_GT(model_id, 0);
+    CHECK_LT(model_id, m_max_features);
+    m_admitted[id] = model_id;
+  }
+  Close(file);
+}
+
+} // namespace f2m
@@ -0,0 +1,151 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file defines FeatureFilter, which keeps the rare features
+out of the model at ingest time.
+*/
+
+#ifndef F2M_READER_FEATURE_FILTER_H_
+#define F2M_READER_FEATURE_FILTER_H_
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/data/data_structure.h"
+
+using std::string;
+using std::vector;
+
+namespace f2m {
+
+/* -----------------------------------------------------------------------------
+ * Most feature ids of a CTR log show up only a few times, but each of them     *
+ * still takes a full latent block in the model and in the optimizer state.     *
+ * FeatureFilter counts the occurrences of the feature ids with a count-min     *
+ * sketch, and admits a feature into the model only when its count reaches      *
+ * min_count. The admitted features are renumbered densely from 1 in the order  *
+ * of admission, and all the other features share the bucket 0:                 *
+ *                                                                              *
+ *   FeatureFilter filter(min_count = 5, max_features = 1000000);               *
+ *   ReaderOptions options;                                                     *
+ *   options.filter = &filter;                                                  *
+ *   Reader reader(filename, num_samples, FM, options);                         *
+ *   Model model(filter.GetNumberOfFeatures(), hyperparam, FM, k);              *
+ *   ... train ...                                                              *
+ *   filter.Save(map_file);  // to be loaded for prediction.                    *
+ *                                                                              *
+ * So the model only needs max_features features however many distinct ids      *
+ * the data has. When max_features - 1 features have been admitted, the later   *
+ * features go to the shared bucket too.                                        *
+ *                                                                              *
+ * The parser calls Filter() for every batch. All the occurrences of a batch    *
+ * are counted before any of them is mapped, so an in-memory reader, which      *
+ * parses the whole data as one batch, maps every feature by its total count.   *
+ * An in-memory reader that compresses the data parses it in blocks, so it      *
+ * calls Count() on all the blocks first and then Remap() on each of them, to   *
+ * the same effect.                                                             *
+ * A streaming reader maps the first few occurrences of a feature to the        *
+ * shared bucket, until the feature has been seen min_count times.              *
+ *                                                                              *
+ * The sketch takes depth * width counters of 4 bytes, and overestimates a      *
+ * count by at most e/width of all the occurrences with probability 1-e^-depth. *
+ * We use the conservative update, which only increments the counters that      *
+ * equal the current estimate, and is much more accurate for skewed data.       *
+ *                                                                              *
+ * A filter can be shared by several readers, e.g., for training and for        *
+ * validation. Filter() locks the filter once per batch. After Freeze(), no     *
+ * more feature is counted or admitted, which is what prediction needs.         *
+ * -----------------------------------------------------------------------------
+ */
+class FeatureFilter {
+ public:
+  // The id of the bucket shared by all the rare features.
+  static const index_t kRareFeature = 0;
+
+  FeatureFilter(uint32 min_count,
+                index_t max_features,
+                uint32 width = 1 << 20,
+                int depth = 4);
+  ~FeatureFilter() {}
+
+  // Count the features of |matrix|, and then replace
+  // their ids by the ids in the model.
+  void Filter(DMatrix& matrix);
+
+  // The two halves of Filter(), so that all the data can be
+  // counted before any of it is mapped, e.g., by a reader
+  // that parses the data a block at a time.
+  void Count(const DMatrix& matrix);
+  void Remap(DMatrix& matrix);
+
+  // Stop counting and admitting features.
+  void Freeze() { m_frozen = true; }
+
+  // Return the estimated count of feature |id|.
+  uint32 Estimate(index_t id) const;
+
+  // Return the number of features the model needs,
+  // including the shared bucket.
+  index_t GetNumberOfFeatures() const { return m_max_features; }
+
+  // Return the number of admitted features.
+  index_t GetNumberOfAdmitted() const { return m_admitted.size(); }
+
+  // Return the number of occurrences mapped to the
+  // shared bucket, and of all the occurrences.
+  uint64 GetNumberOfRare() const { return m_num_rare; }
+  uint64 GetNumberOfOccurrences() const { return m_num_occurrences; }
+
+  // Save the map from the feature ids to the ids in the model,
+  // one "id model_id" pair a line, or load it into a filter.
+  void Save(const string& filename);
+  void Load(const string& filename);
+
+ private:
+  uint32 m_min_count;               // admit a feature at this count.
+  index_t m_max_features;           // the size of the model.
+  uint32 m_width;                   // counters of each row of the sketch.
+  int m_depth;                      // rows of the sketch.
+  int m_shift;                      // 64 - log2(m_width).
+  vector<uint64> m_seeds;           // hash multiplier of each row.
+  vector<uint32> m_counters;        // depth * width counters.
+  std::unordered_map<index_t, index_t> m_admitted;  // id -> model id.
+  bool m_frozen;                    // no more counting.
+  uint64 m_num_rare;                // occurrences in the shared bucket.
+  uint64 m_num_occurrences;         // all the occurrences.
+  std::mutex m_mutex;
+
+  // Return the position of the counter of feature |id| in row |d|.
+  uint64 Slot(int d, index_t id) const {
+    return (uint64)d * m_width + ((id * m_seeds[d]) >> m_shift);
+  }
+  // Count one occurrence of feature |id|.
+  void Add(index_t id);
+  // Return the model id of feature |id|.
+  index_t Map(index_t id);
+  // Count() and Remap() with m_mutex held.
+  void CountRows(const DMatrix& matrix);
+  void RemapRows(DMatrix& matrix);
+
+  DISALLOW_COPY_AND_ASSIGN(FeatureFilter);
+};
+
+} // namespace f2m
+
+#endif // F2M_READER_FEATURE_FILTER_H_
@@ -0,0 +1,121 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file tests feature_filter.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "src/data/data_structure.h"
+#include "src/reader/feature_filter.h"
+#include "src/reader/parser.h"
+
+using std::string;
+using std::vector;
+
+namespace f2m {
+
+// Return a batch of one-feature rows with the given ids.
+void MakeBatch(const vector<index_t>& ids, DMatrix& matrix) {
+  matrix.resize(ids.size());
+  matrix.ResetSparseRow();
+  for (index_t i = 0; i < ids.size(); ++i) {
+    matrix.row[i]->resize(1);
+    matrix.row[i]->idx[0] = ids[i];
+    matrix.row[i]->X[0] = 1.0;
+  }
+}
+
+TEST(FeatureFilterTest, NeverUnderestimates) {
+  // A small sketch, so that there are collisions.
+  FeatureFilter filter(1000000, 2, 1 << 14, 4);
+  const index_t kNumIds = 5000;
+  vector<index_t> ids;
+  for (index_t id = 0; id < kNumIds; ++id) {
+    for (index_t c = 0; c <= id % 7; ++c) ids.push_back(id * 7919);
+  }
+  DMatrix matrix;
+  MakeBatch(ids, matrix);
+  filter.Filter(matrix);
+  index_t num_exact = 0;
+  for (index_t id = 0; id < kNumIds; ++id) {
+    uint32 estimate = filter.Estimate(id * 7919);
+    ASSERT_GE(estimate, id % 7 + 1);
+    num_exact += estimate == id % 7 + 1;
+  }
+  // Most of the estimates are still exact.
+  EXPECT_GT(num_exact, kNumIds / 2);
+}
+
+TEST(FeatureFilterTest, AdmitsFrequentFeatures) {
+  FeatureFilter filter(3, 3);
+  DMatrix matrix;
+  // A batch is counted before it is mapped.
+  index_t first[] = { 7, 9, 7, 7 };
+  MakeBatch(vector<index_t>(first, first + 4), matrix);
+  filter.Filter(matrix);
+  EXPECT_EQ(matrix.row[0]->idx[0], 1);
+  EXPECT_EQ(matrix.row[1]->idx[0], FeatureFilter::kRareFeature);
+  EXPECT_EQ(matrix.row[2]->idx[0], 1);
+  EXPECT_EQ(matrix.row[3]->idx[0], 1);
+  // Feature 9 reaches the count in the second batch,
+  // and there is no room left for feature 11.
+  index_t second[] = { 9, 11, 9, 11, 11, 7 };
+  MakeBatch(vector<index_t>(second, second + 6), matrix);
+  filter.Filter(matrix);
+  EXPECT_EQ(matrix.row[0]->idx[0], 2);
+  EXPECT_EQ(matrix.row[1]->idx[0], FeatureFilter::kRareFeature);
+  EXPECT_EQ(matrix.row[5]->idx[0], 1);
+  EXPECT_EQ(filter.GetNumberOfAdmitted(), 2);
+  EXPECT_EQ(filter.GetNumberOfRare(), 4);
+  EXPECT_EQ(filter.GetNumberOfOccurrences(), 10);
+}
+
+TEST(FeatureFilterTest, SaveAndLoad) {
+  const string kMapFile = "/tmp/test_feature_filter.map";
+  FeatureFilter filter(2, 100);
+  Parser parser;
+  parser.SetFeatureFilter(&filter);
+  StringList list;
+  list.push_back("1\t5:1\t6:1");
+  list.push_back("0\t5:1\t8:1");
+  DMatrix matrix(list.size());
+  matrix.InitSparseRow();
+  parser.Parse(list, matrix);
+  EXPECT_EQ(matrix.row[0]->idx[0], 1);
+  EXPECT_EQ(matrix.row[0]->idx[1], FeatureFilter::kRareFeature);
+  EXPECT_EQ(matrix.row[1]->idx[0], 1);
+  filter.Save(kMapFile);
+  // A frozen filter maps the features as it was trained.
+  FeatureFilter loaded(2, 100);
+  loaded.Load(kMapFile);
+  loaded.Freeze();
+  parser.SetFeatureFilter(&loaded);
+  list[0] = "1\t6:1\t5:1";
+  list[1] = "0\t6:1\t5:1";
+  parser.Parse(list, matrix);
+  EXPECT_EQ(matrix.row[1]->idx[0], FeatureFilter::kRareFeature);
+  EXPECT_EQ(matrix.row[1]->idx[1], 1);
+  EXPECT_EQ(loaded.GetNumberOfAdmitted(), 1);
+  unlink(kMapFile.c_str());
+}
+
+} // namespace f2m
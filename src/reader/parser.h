@@ -24,14 +24,19 @@ output to a DMatrix format.
 #ifndef F2M_READER_PARSER_H_
 #define F2M_READER_PARSER_H_
 
-#include <stdlib.h>
+#include <math.h>
+#include <string.h>
 
+#include <utility>
 #include <vector>
 #include <string>
 
+#include "src/base/char_scanner.h"
 #include "src/base/common.h"
-#include "src/base/split_string.h"
+#include "src/base/parse_number.h"
+#include "src/base/profiler.h"
 #include "src/data/data_structure.h"
+#include "src/reader/feature_filter.h"
 
 using std::vector;
 using std::string;
@@ -40,13 +45,43 @@ namespace f2m {
 
 typedef vector<string> StringList;
 
+// The default delimiters between the label and the features,
+// which read both the tab-separated files and the
+// space-separated (libsvm) files.
+const char kDefaultDelimiters[] = "\t ";
+
 // Given a StringList, parse it to the DMatrix format.
+// If a FeatureFilter is set, the feature ids of every parsed
+// batch are replaced by the ids the filter gives them.
+// A row whose values are all 1 becomes a binary row, which
+// does not store the values, see SparseRow::set_binary().
 class Parser {
  public:
+  // The label and the features of a line are separated by any
+  // of the |delimiters|, and there can be several of them
+  // between two items.
+  explicit Parser(const char* delimiters = kDefaultDelimiters)
+    : m_filter(NULL), m_delimiters(delimiters),
+      m_delimiter_chars(delimiters) {}
+  virtual ~Parser() {}
+
+  // NULL for no filter.
+  void SetFeatureFilter(FeatureFilter* filter) { m_filter = filter; }
+
+  // Return a hash of how the parser maps a line to a row, so
+  // that the rows parsed by another parser, e.g. in a block
+  // file, are not taken for ours.
+  virtual uint64 Fingerprint() const {
+    return FingerprintOf(m_delimiter_chars.data(), m_delimiter_chars.size(),
+                         kFingerprintSeed);
+  }
+
   virtual void Parse(const StringList& list, 
                      DMatrix& matrix) {
+    F2M_PROFILE_SCOPE(PROFILE_PARSE);
     CHECK_GE(list.size(), 0);
     CHECK_GE(matrix.row_size, 0);
+    uint64 nnz = 0, bytes = 0;
     // Note that here we need to use the matrix.row_size 
     // as the bound because sometimes this size could be smaller
     // than the size of StringList.
@@ -54,30 +89,99 @@ class Parser {
       // Parse the following format:
       // [ Y idx:value \table idx:value ... ] for LR and FM, or
       // [ Y field:idx:value \table field:idx:value ... ] for FFM.
-      StringList items;
-      SplitStringUsing(list[i], "\t", &items);
-      int len = items.size();
+      // The value of an item can be omitted, as in [ idx ]
+      // or in [ field:idx ], and then it is 1. A label or a
+      // value such as nan, inf or 1e999 is a bad item, as it
+      // would make the whole model NaN.
+      const char* line = list[i].c_str();
+      m_items.clear();
+      m_delimiters.Split(line, line + list[i].size(),
+                         [&](const char* begin, const char* end) {
+        m_items.push_back(Item(begin, end));
+      });
+      CHECK_GT(m_items.size(), 0);
+      int len = m_items.size();
       // parse Y
-      matrix.Y[i] = atof(items[0].c_str());
+      if (ParseFloat(m_items[0].first, m_items[0].second,
+                     &matrix.Y[i]) != m_items[0].second ||
+          !isfinite(matrix.Y[i])) {
+        BadItem(m_items[0]);
+      }
       // parse row
       CHECK_NOTNULL(matrix.row[i]);
-      matrix.row[i]->resize(len-1);
+      SparseRow* row = matrix.row[i];
+      // We do not know yet if the row is binary, and a
+      // binary row does not allocate the values.
+      row->set_binary(true);
+      row->resize(len-1);
+      m_values.resize(len-1);
+      bool binary = true;
       for (int j = 1; j < len; ++j) {
-        StringList tmp_item; 
-        SplitStringUsing(items[j], ":", &tmp_item);
+        const char* pos = m_items[j].first;
+        const char* end = m_items[j].second;
         if (matrix.model_type == FFM) {
-          CHECK_EQ(tmp_item.size(), 3);
-          matrix.row[i]->field[j-1] = atoi(tmp_item[0].c_str());
-          matrix.row[i]->idx[j-1] = atoi(tmp_item[1].c_str());
-          matrix.row[i]->X[j-1] = atof(tmp_item[2].c_str());
-        } else { // LR or FM
-          CHECK_EQ(tmp_item.size(), 2);
-          matrix.row[i]->idx[j-1] = atoi(tmp_item[0].c_str());
-          matrix.row[i]->X[j-1] = atof(tmp_item[1].c_str());
+          pos = ParseUInt32(pos, end, &row->field[j-1]);
+          if (pos == NULL || pos == end || *pos != ':') {
+            BadItem(m_items[j]);
+          }
+          pos++;
+        }
+        pos = ParseUInt32(pos, end, &row->idx[j-1]);
+        if (pos == NULL) {
+          BadItem(m_items[j]);
+        }
+        // The value is 1 if it is omitted.
+        real_t value = 1;
+        if (pos != end &&
+            (*pos != ':' || ParseFloat(pos + 1, end, &value) != end ||
+             !isfinite(value))) {
+          BadItem(m_items[j]);
         }
+        m_values[j-1] = value;
+        binary = binary && value == 1;
       }
+      // A row of 1s does not keep its values.
+      row->set_binary(binary);
+      if (!binary) {
+        memcpy(row->X, m_values.data(), (len-1) * sizeof(real_t));
+      }
+      nnz += len-1;
+      bytes += list[i].size();
+    }
+    if (m_filter != NULL) {
+      m_filter->Filter(matrix);
     }
+    F2M_PROFILE_COUNT(PROFILE_PARSE, matrix.row_size, nnz, bytes);
   }
+
+ protected:
+  typedef std::pair<const char*, const char*> Item;
+
+  static const uint64 kFingerprintSeed = 0xcbf29ce484222325ULL;
+
+  // FNV-1a of the |size| bytes at |data|, starting from |seed|.
+  static uint64 FingerprintOf(const void* data, size_t size, uint64 seed) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64 hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+      hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+  }
+
+  FeatureFilter* m_filter;          // map the feature ids.
+
+  // An item with a bad number, or an id that overflows index_t.
+  static void BadItem(const Item& item) {
+    LOG(FATAL) << "Cannot parse the item: "
+               << string(item.first, item.second);
+  }
+
+ private:
+  CharScanner m_delimiters;         // find the items of a line.
+  string m_delimiter_chars;         // the delimiters, for Fingerprint().
+  vector<Item> m_items;             // [begin, end) of every item.
+  vector<real_t> m_values;          // the values of a row.
 };
 
 } // namespace f2m
@@ -22,6 +22,7 @@ This file tests parser.h
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -51,8 +52,8 @@ TEST(PARSER_TEST, Parse_LR_FM) {
   EXPECT_EQ(matrix.row.size(), kNum_lines);
   EXPECT_EQ(matrix.Y.size(), kNum_lines);
   for (index_t i = 0; i < kNum_lines; ++i) {
-    EXPECT_EQ(matrix.row[i]->X.size(), kLen);
-    EXPECT_EQ(matrix.row[i]->idx.size(), kLen);
+    EXPECT_EQ(matrix.row[i]->size, kLen);
+    EXPECT_GE(matrix.row[i]->capacity, kLen);
     EXPECT_EQ(matrix.Y[i], (real_t(0)));
     for (index_t j = 0; j < kLen; ++j) {
       EXPECT_EQ(matrix.row[i]->X[j], (real_t)(0.123));
@@ -74,9 +75,9 @@ TEST(PARSER_TEST, Parse_FFM) {
   EXPECT_EQ(matrix.row.size(), kNum_lines);
   EXPECT_EQ(matrix.Y.size(), kNum_lines);
   for (index_t i = 0; i < kNum_lines; ++i) {
-    EXPECT_EQ(matrix.row[i]->X.size(), kLen);
-    EXPECT_EQ(matrix.row[i]->idx.size(), kLen);
-    EXPECT_EQ(matrix.row[i]->field.size(), kLen);
+    EXPECT_EQ(matrix.row[i]->size, kLen);
+    EXPECT_GE(matrix.row[i]->capacity, kLen);
+    EXPECT_TRUE(matrix.row[i]->field != NULL);
     EXPECT_EQ(matrix.Y[i], (real_t)(1));
     for (index_t j = 0; j < kLen; ++j) {
       EXPECT_EQ(matrix.row[i]->X[j], (real_t(0.123)));
@@ -86,4 +87,105 @@ TEST(PARSER_TEST, Parse_FFM) {
   }
 }
 
+TEST(PARSER_TEST, Delimiters) {
+  // A libsvm line with spaces, and a line with several
+  // tabs and spaces between the items.
+  StringList list;
+  list.push_back("1 3:1 10:0.5 21:1");
+  list.push_back("0\t 3:1\t\t10:0.5  21:1 ");
+  DMatrix matrix(list.size());
+  matrix.InitSparseRow();
+  Parser parser;
+  parser.Parse(list, matrix);
+  for (index_t i = 0; i < list.size(); ++i) {
+    EXPECT_EQ(matrix.Y[i], real_t(1 - i));
+    ASSERT_EQ(matrix.row[i]->size, 3);
+    EXPECT_EQ(matrix.row[i]->idx[0], 3);
+    EXPECT_EQ(matrix.row[i]->idx[1], 10);
+    EXPECT_EQ(matrix.row[i]->idx[2], 21);
+    EXPECT_EQ(matrix.row[i]->X[1], real_t(0.5));
+  }
+  // Other delimiters.
+  list.clear();
+  list.push_back("1,1:3:1,2:10:0.5");
+  DMatrix ffm_matrix(list.size(), FFM);
+  ffm_matrix.InitSparseRow();
+  Parser comma_parser(",");
+  comma_parser.Parse(list, ffm_matrix);
+  ASSERT_EQ(ffm_matrix.row[0]->size, 2);
+  EXPECT_EQ(ffm_matrix.row[0]->field[1], 2);
+  EXPECT_EQ(ffm_matrix.row[0]->idx[1], 10);
+  EXPECT_EQ(ffm_matrix.row[0]->X[1], real_t(0.5));
+}
+
+TEST(PARSER_TEST, BinaryRows) {
+  StringList list;
+  list.push_back("1 3:1 10:1 21:1");
+  list.push_back("0 3 10 21");
+  list.push_back("1 3:1 10:0.5 21");
+  DMatrix matrix(list.size());
+  matrix.InitSparseRow();
+  Parser parser;
+  parser.Parse(list, matrix);
+  // The rows of 1s do not store the values.
+  EXPECT_TRUE(matrix.row[0]->binary);
+  EXPECT_TRUE(matrix.row[0]->X == NULL);
+  EXPECT_TRUE(matrix.row[1]->binary);
+  EXPECT_FALSE(matrix.row[2]->binary);
+  EXPECT_EQ(matrix.row[2]->X[0], 1);
+  EXPECT_EQ(matrix.row[2]->X[1], real_t(0.5));
+  EXPECT_EQ(matrix.row[2]->X[2], 1);
+  for (index_t i = 0; i < list.size(); ++i) {
+    ASSERT_EQ(matrix.row[i]->size, 3);
+    EXPECT_EQ(matrix.row[i]->idx[2], 21);
+  }
+  // A row can change from binary to not binary and back.
+  std::swap(list[0], list[2]);
+  parser.Parse(list, matrix);
+  EXPECT_FALSE(matrix.row[0]->binary);
+  EXPECT_EQ(matrix.row[0]->X[1], real_t(0.5));
+  EXPECT_TRUE(matrix.row[2]->binary);
+  // FFM items without values.
+  list.clear();
+  list.push_back("1 0:3 1:10 2:21");
+  DMatrix ffm_matrix(list.size(), FFM);
+  ffm_matrix.InitSparseRow();
+  parser.Parse(list, ffm_matrix);
+  EXPECT_TRUE(ffm_matrix.row[0]->binary);
+  EXPECT_EQ(ffm_matrix.row[0]->field[2], 2);
+  EXPECT_EQ(ffm_matrix.row[0]->idx[2], 21);
+}
+
+
+// Parse a single |line| of a |type| data set.
+void ParseLine(const string& line, ModelType type) {
+  StringList list(1, line);
+  DMatrix matrix(1, type);
+  matrix.InitSparseRow();
+  Parser parser;
+  parser.Parse(list, matrix);
+}
+
+TEST(PARSER_TEST, NonFiniteNumbers) {
+  // Large and tiny numbers that are still finite.
+  StringList list;
+  list.push_back("3e38 3:1e-30 10:-3e38");
+  DMatrix matrix(list.size());
+  matrix.InitSparseRow();
+  Parser parser;
+  parser.Parse(list, matrix);
+  EXPECT_EQ(matrix.Y[0], real_t(3e38));
+  EXPECT_EQ(matrix.row[0]->X[0], real_t(1e-30));
+  EXPECT_EQ(matrix.row[0]->X[1], real_t(-3e38));
+  // A NaN or an infinity in a label or a value is a bad item.
+  EXPECT_DEATH(ParseLine("nan 3:1", LR), "Cannot parse the item: nan");
+  EXPECT_DEATH(ParseLine("-inf 3:1", LR), "Cannot parse the item: -inf");
+  EXPECT_DEATH(ParseLine("1e999 3:1", LR), "Cannot parse the item: 1e999");
+  EXPECT_DEATH(ParseLine("1 3:nan", LR), "Cannot parse the item: 3:nan");
+  EXPECT_DEATH(ParseLine("1 3:inf", FM), "Cannot parse the item: 3:inf");
+  EXPECT_DEATH(ParseLine("1 3:1e39", LR), "Cannot parse the item: 3:1e39");
+  EXPECT_DEATH(ParseLine("1 0:3:NaN", FFM),
+               "Cannot parse the item: 0:3:NaN");
+}
+
 } // namespace f2m
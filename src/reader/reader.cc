@@ -22,13 +22,21 @@ This file is the implementation of reader.h
 
 #include "src/reader/reader.h"
 
+#include <algorithm>
+#include <random>
 #include <vector>
 #include <string>
 
 #include <string.h>
+#include <sys/stat.h>
 
+#include "src/base/char_scanner.h"
 #include "src/base/common.h"
 #include "src/base/file_util.h"
+#include "src/base/parallel.h"
+#include "src/base/profiler.h"
+#include "src/reader/block_cache.h"
+#include "src/reader/decompressor.h"
 
 using std::vector;
 using std::string;
@@ -36,164 +44,577 @@ using std::string;
 namespace f2m {
 
 const uint32 kMaxLineSize = 100 * 1024; // 100 KB one line
+// The shuffle buffer holds this number of parsed blocks.
+const uint32 kShuffleBlocks = 16;
+const uint32 kShuffleSeed = 2016;
+// Do not split a small permutation among threads.
+const index_t kMinShuffleRows = 1 << 16;
+// Lines parsed at a time before they are compressed.
+const uint32 kCompressBlockRows = 1 << 16;
 
 typedef vector<string> StringList;
 
-uint32 ReadLineFromMemory(char* line, char* buf, 
-                          uint32 start_pos, uint32 len);
+// Copy the line at |pos| into |line| without the newline,
+// and return the beginning of the next line.
+static const char* NextLine(const CharScanner& newline,
+                            const char* pos,
+                            const char* end,
+                            string* line) {
+  const char* eol = newline.Find(pos, end);
+  if (eol - pos + 1 > kMaxLineSize) {
+    LOG(FATAL) << "Encountered a too-long line.";
+  }
+  const char* line_end = eol;
+  // Handle some windows txt format.
+  if (line_end > pos && line_end[-1] == '\r') {
+    line_end--;
+  }
+  line->assign(pos, line_end);
+  return eol + 1;
+}
+
+// Shuffle |order| in parallel using the method of Rao and Sandelius.
+// Every thread scatters its part of |order| into random buckets, and
+// then every bucket is shuffled by one thread using Fisher-Yates.
+// The result is a uniform random permutation.
+static void ParallelShuffle(vector<index_t>& order, uint32 seed) {
+  index_t size = order.size();
+  int num_threads = GetNumberOfThreads();
+  if (size / kMinShuffleRows < num_threads) {
+    num_threads = size / kMinShuffleRows;
+  }
+  if (num_threads <= 1) {
+    std::mt19937 rng(seed);
+    std::shuffle(order.begin(), order.end(), rng);
+    return;
+  }
+  // Scatter every row to a random bucket.
+  int num_buckets = num_threads;
+  vector<uint16> bucket(size);
+  vector<index_t> count(num_threads * num_buckets, 0);
+  ParallelRun(num_threads, [&](int t) {
+    std::mt19937 rng(seed + t);
+    std::uniform_int_distribution<int> dist(0, num_buckets - 1);
+    index_t* my_count = count.data() + t * num_buckets;
+    index_t end = SplitBegin(size, num_threads, t + 1);
+    for (index_t i = SplitBegin(size, num_threads, t); i < end; ++i) {
+      bucket[i] = dist(rng);
+      my_count[bucket[i]]++;
+    }
+  });
+  // Bucket b holds the rows of thread 0, 1, ... in order.
+  vector<index_t> offset(num_threads * num_buckets);
+  vector<index_t> bucket_begin(num_buckets + 1);
+  index_t sum = 0;
+  for (int b = 0; b < num_buckets; ++b) {
+    bucket_begin[b] = sum;
+    for (int t = 0; t < num_threads; ++t) {
+      offset[t * num_buckets + b] = sum;
+      sum += count[t * num_buckets + b];
+    }
+  }
+  bucket_begin[num_buckets] = sum;
+  vector<index_t> result(size);
+  ParallelRun(num_threads, [&](int t) {
+    index_t* my_offset = offset.data() + t * num_buckets;
+    index_t end = SplitBegin(size, num_threads, t + 1);
+    for (index_t i = SplitBegin(size, num_threads, t); i < end; ++i) {
+      result[my_offset[bucket[i]]++] = order[i];
+    }
+  });
+  // Shuffle every bucket.
+  ParallelRun(num_buckets, [&](int b) {
+    std::mt19937 rng(seed + num_threads + b);
+    std::shuffle(result.begin() + bucket_begin[b],
+                 result.begin() + bucket_begin[b + 1], rng);
+  });
+  order.swap(result);
+}
 
 Reader::Reader(const string& filename,
                int num_samples,
                ModelType type,
                bool loop,
                bool in_memory) :
+  Reader(filename, num_samples, type, ReaderOptions(loop, in_memory)) {}
+
+Reader::Reader(const string& filename,
+               int num_samples,
+               ModelType type,
+               const ReaderOptions& options) :
   m_filename(filename),
   m_num_samples(num_samples),
-  m_loop(loop),
-  m_in_memory(in_memory),
+  m_loop(options.loop),
+  m_in_memory(options.in_memory),
   m_type(type),
+  m_compress(options.compress),
+  m_compressed(type),
   m_data_buf(0, type),
-  m_data_samples(num_samples, type) {
+  m_data_samples(num_samples, type),
+  m_filter(options.filter),
+  m_shuffle(options.shuffle),
+  m_rng(kShuffleSeed),
+  m_epoch(0),
+  m_pos(0),
+  m_block(num_samples, type),
+  m_line(kMaxLineSize),
+  m_list(num_samples),
+  m_block_cache(NULL),
+  m_block_pos(0),
+  m_current_block(NULL),
+  m_row_pos(0) {
     CHECK_GT(m_num_samples, 0);
     CHECK_NE(m_filename.empty(), true);
-    m_file_ptr = OpenFileOrDie(m_filename.c_str(), "r");
+    m_parser = options.parser != NULL ? options.parser : &m_default_parser;
+    if (m_filter != NULL) {
+      m_parser->SetFeatureFilter(m_filter);
+    }
+    m_file_ptr = NULL;
+    m_decompressor = NULL;
+    m_seekable = true;
+    if (m_filename == "-") {
+      m_file_ptr = stdin;
+    } else if (Decompressor::IsCompressed(m_filename)) {
+      // Read .gz and .zst files without writing the plain text to disk.
+      m_decompressor = new Decompressor(m_filename);
+    } else {
+      m_file_ptr = OpenFileOrDie(m_filename.c_str(), "r");
+    }
+    // Pipes and the stdin cannot rewind or tell their size.
+    if (m_file_ptr != NULL) {
+      struct stat file_stat;
+      CHECK_EQ(fstat(fileno(m_file_ptr), &file_stat), 0);
+      m_seekable = S_ISREG(file_stat.st_mode);
+    }
+    if (!m_seekable && (m_loop || m_in_memory)) {
+      LOG(FATAL) << "Input stream " << m_filename
+                 << " cannot be read in a loop or into memory.";
+    }
     // If we have ennough memory, 
     // we can read all data into m_data_buf.
     if (m_in_memory) {
-      // get the size of current file.
-      fseek(m_file_ptr, 0, SEEK_END);
-      uint64 total_size = ftell(m_file_ptr);
-      rewind(m_file_ptr);
-      char* buffer = NULL;
-      try {
-        buffer = new char[total_size];
-      } catch (std::bad_alloc&) {
-        LOG(FATAL) << "Cannot allocate enough memory for Reader.";
-      }
-      // read all data
-      uint64 read_size = fread(buffer, 1, total_size, m_file_ptr);
-      if (read_size != total_size) {
-        LOG(FATAL) << "Read file error: " << m_filename;
-      }
-      // get the number of line.
-      uint32 num_line = 0;
-      for (uint64 i = 0; i < total_size; ++i) {
-        if (buffer[i] == '\n') {
-          num_line++;
+      if (m_compress) {
+        // Stream the text into the compressed rows, so
+        // that the whole text is never in memory.
+        CompressFile();
+        LOG(INFO) << "Compressed " << m_compressed.GetNumberOfNonZero()
+                  << " features of " << m_filename << " into "
+                  << m_compressed.GetNumberOfBytes() << " bytes.";
+      } else {
+        vector<char> buffer;
+        if (m_decompressor != NULL) {
+          m_decompressor->ReadAll(&buffer);
+        } else {
+          // get the size of current file.
+          fseek(m_file_ptr, 0, SEEK_END);
+          uint64 file_size = ftell(m_file_ptr);
+          rewind(m_file_ptr);
+          try {
+            buffer.resize(file_size);
+          } catch (std::bad_alloc&) {
+            LOG(FATAL) << "Cannot allocate enough memory for Reader.";
+          }
+          // read all data
+          uint64 read_size = fread(buffer.data(), 1, file_size, m_file_ptr);
+          if (read_size != file_size) {
+            LOG(FATAL) << "Read file error: " << m_filename;
+          }
         }
-      }
-      m_data_buf.resize(num_line);
-      m_data_buf.InitSparseRow();
-      // parse line to StringList.
-      StringList list(num_line);
-      char* line = new char[kMaxLineSize];
-      uint32 start_pos = 0;
-      for (uint32 i = 0; i < num_line; ++i) {
-        uint32 read_size = ReadLineFromMemory(line, buffer,
-                                              start_pos,
-                                              total_size);
-        if (read_size == 0) {
-          LOG(FATAL) << "Read error: " << read_size << " bytes.";
+        uint64 total_size = buffer.size();
+        const char* pos = buffer.data();
+        const char* end = pos + total_size;
+        // get the number of line.
+        CharScanner newline("\n");
+        uint32 num_line = newline.Count(pos, end);
+        m_data_buf.resize(num_line);
+        m_data_buf.InitSparseRow();
+        // parse line to StringList.
+        StringList list(num_line);
+        for (uint32 i = 0; i < num_line; ++i) {
+          pos = NextLine(newline, pos, end, &list[i]);
         }
-        start_pos += read_size;
-        line[read_size-1] = '\0';
-        // Handle some windows txt format.
-        if (read_size > 1 && line[read_size-2] == '\r') {
-          line[read_size-2] = '\0';
+        // parse StringList to DMatrix
+        m_parser->Parse(list, m_data_buf);
+      }
+      if (m_shuffle) {
+        index_t num_rows = GetNumberOfRowsInMemory();
+        m_order.resize(num_rows);
+        for (index_t i = 0; i < num_rows; ++i) {
+          m_order[i] = i;
         }
-        list[i].assign(line);
+        ParallelShuffle(m_order, kShuffleSeed);
       }
-      // parse StringList to DMatrix
-      m_parser.Parse(list, m_data_buf);
+    } else if (m_shuffle) {
+      // Batches are filled with the rows of the shuffle buffer.
+      m_data_samples.resize(0);
     } else { // Sample data from disk file.
       m_data_samples.InitSparseRow();
     }
 }
 
+void Reader::CompressFile() {
+  // Parse a block of lines at a time, so that only the
+  // compressed rows of all the data stay in memory.
+  // The filter maps the uncompressed data by the total
+  // count of every feature, and so do we: the first pass
+  // only counts, and the second one reads the file again
+  // to map and compress.
+  if (m_filter != NULL) {
+    m_parser->SetFeatureFilter(NULL);
+  }
+  DMatrix block(m_type);
+  StringList list(kCompressBlockRows);
+  for (int pass = m_filter != NULL ? 0 : 1; pass < 2; ++pass) {
+    Rewind();
+    uint32 num_line = kCompressBlockRows;
+    while (num_line == kCompressBlockRows) {
+      for (num_line = 0; num_line < kCompressBlockRows; ++num_line) {
+        if (ReadTextLine(&list[num_line]) == 0) break;
+      }
+      if (num_line == 0) break;
+      block.resize(num_line);
+      block.ResetSparseRow();
+      m_parser->Parse(list, block);
+      if (pass == 0) {
+        m_filter->Count(block);
+        continue;
+      }
+      if (m_filter != NULL) {
+        m_filter->Remap(block);
+      }
+      m_compressed.Append(block);
+    }
+  }
+  m_compressed.Shrink();
+  if (m_filter != NULL) {
+    m_parser->SetFeatureFilter(m_filter);
+  }
+}
+
 Reader::~Reader() {
-  if (m_file_ptr != NULL) {
+  if (m_file_ptr != NULL && m_file_ptr != stdin) {
     Close(m_file_ptr);
     m_file_ptr = NULL;
   }
+  if (m_decompressor != NULL) {
+    delete m_decompressor;
+    m_decompressor = NULL;
+  }
+  if (m_block_cache != NULL) {
+    delete m_block_cache;
+    m_block_cache = NULL;
+  }
 }
 
 DMatrix* Reader::Samples() {
+  if (m_block_cache != NULL) {
+    return SampleFromBlocks();
+  }
   return m_in_memory ? SampleFromMemory() :
                        SampleFromDisk();
 }
 
 DMatrix* Reader::SampleFromDisk() {
-  static char* line = new char[kMaxLineSize];
-  static StringList list(m_num_samples);
+  if (m_shuffle) {
+    return SampleFromShuffleBuffer();
+  }
   // Sample m_num_samples lines data from disk
+  uint32 num_line = ReadLines();
+  // End of file
+  if (num_line != m_num_samples) {
+    m_data_samples.resize(num_line);
+  }
+  // The rows of the last batch are not used any more.
+  m_data_samples.ResetSparseRow();
+  m_parser->Parse(m_list, m_data_samples);
+  return &m_data_samples;
+}
+
+DMatrix* Reader::SampleFromShuffleBuffer() {
+  // The rows returned last time can be reused now.
+  for (index_t i = 0; i < m_data_samples.row_size; ++i) {
+    m_free_rows.push_back(m_data_samples.row[i]);
+  }
+  // Refill the shuffle buffer block by block, so that
+  // we still read the file sequentially.
+  index_t capacity = kShuffleBlocks * m_num_samples;
+  while (m_pool_rows.size() + m_num_samples <= capacity) {
+    uint32 num_line = ReadLines();
+    if (num_line == 0) break;
+    m_block.resize(num_line);
+    for (index_t i = 0; i < num_line; ++i) {
+      if (m_free_rows.empty()) {
+        m_block.row[i] = m_block.arena.New<SparseRow>(m_type,
+                                                      &m_block.arena);
+      } else {
+        m_block.row[i] = m_free_rows.back();
+        m_free_rows.pop_back();
+      }
+    }
+    m_parser->Parse(m_list, m_block);
+    m_pool_rows.insert(m_pool_rows.end(), m_block.row.begin(),
+                       m_block.row.begin() + num_line);
+    m_pool_y.insert(m_pool_y.end(), m_block.Y.begin(),
+                    m_block.Y.begin() + num_line);
+    // End of file
+    if (num_line != m_num_samples) break;
+  }
+  // Draw rows from the shuffle buffer at random.
+  index_t num_line = m_num_samples;
+  if (m_pool_rows.size() < num_line) {
+    num_line = m_pool_rows.size();
+  }
+  m_data_samples.resize(num_line);
+  for (index_t i = 0; i < num_line; ++i) {
+    index_t j = m_rng() % m_pool_rows.size();
+    m_data_samples.row[i] = m_pool_rows[j];
+    m_data_samples.Y[i] = m_pool_y[j];
+    m_pool_rows[j] = m_pool_rows.back();
+    m_pool_y[j] = m_pool_y.back();
+    m_pool_rows.pop_back();
+    m_pool_y.pop_back();
+  }
+  return &m_data_samples;
+}
+
+uint32 Reader::ReadLines() {
+  F2M_PROFILE_SCOPE(PROFILE_READ);
   uint32 num_line = 0;
+  uint64 num_bytes = 0;
   for (uint32 i = 0; i < m_num_samples; ++i) {
-    if (fgets(line, kMaxLineSize, m_file_ptr) == NULL) {
+    uint32 read_len = ReadTextLine(&m_list[i]);
+    if (read_len == 0) {
       // Either ferror or feof. 
       if (m_loop) {
-        fseek(m_file_ptr, 0, SEEK_SET);
+        EndOfEpoch();
+        Rewind();
         i--; // re-read
         continue;
-      } else break;
-    }
-    uint32 read_len = strlen(line);
-    if (line[read_len-1] != '\n') {
-      LOG(FATAL) << "Encountered a too-long line.";
-    } else {
-      line[read_len-1] = '\0';
-      // Handle some windows txt format.
-      if (read_len > 1 && line[read_len-2] == '\r') {
-        line[read_len-2] = '\0';
+      } else {
+        // Only one epoch without loop.
+        if (m_epoch == 0) EndOfEpoch();
+        break;
       }
     }
-    list[i].assign(line);
+    num_bytes += read_len;
     num_line++;
   }
-  // End of file
-  if (num_line != m_num_samples) {
-    m_data_samples.resize(num_line);
+  F2M_PROFILE_COUNT(PROFILE_READ, num_line, 0, num_bytes);
+  return num_line;
+}
+
+uint32 Reader::ReadTextLine(string* str) {
+  char* line = m_line.data();
+  uint32 read_len = ReadLine(line);
+  if (read_len == 0) return 0;
+  if (line[read_len-1] != '\n') {
+    // The last line of a file may not end with '\n'.
+    if (read_len + 1 == kMaxLineSize) {
+      LOG(FATAL) << "Encountered a too-long line.";
+    }
+  } else {
+    line[read_len-1] = '\0';
+    // Handle some windows txt format.
+    if (read_len > 1 && line[read_len-2] == '\r') {
+      line[read_len-2] = '\0';
+    }
   }
-  m_parser.Parse(list, m_data_samples);
-  return &m_data_samples;
+  str->assign(line);
+  return read_len;
 }
 
 DMatrix* Reader::SampleFromMemory() {
-  static index_t pos = 0;
+  F2M_PROFILE_SCOPE(PROFILE_READ);
+  if (m_compress) {
+    // The rows decoded for the last batch are not used any more.
+    m_data_samples.resize(m_num_samples);
+    m_data_samples.ResetSparseRow();
+  }
   uint32 num_line = 0;
   for (index_t i = 0; i < m_num_samples; ++i) {
     // End of file
-    if (pos >= m_data_buf.row_size) {
+    if (m_pos >= GetNumberOfRowsInMemory()) {
       if (m_loop) {
-        pos = 0;
+        m_pos = 0;
+        EndOfEpoch();
+        // Walk a new permutation in the next epoch.
+        if (m_shuffle) {
+          ParallelShuffle(m_order, kShuffleSeed + m_epoch);
+        }
       } else {
+        // Only one epoch without loop.
+        if (m_epoch == 0) EndOfEpoch();
         break;
       }
     }
     // Copy data from buffer to data samples
-    m_data_samples.row[i] = m_data_buf.row[pos];
-    m_data_samples.Y[i] = m_data_buf.Y[pos];
-    pos++;
+    index_t index = m_shuffle ? m_order[m_pos] : m_pos;
+    if (m_compress) {
+      m_data_samples.Y[i] = m_compressed.Decode(index,
+                                                m_data_samples.row[i]);
+    } else {
+      m_data_samples.row[i] = m_data_buf.row[index];
+      m_data_samples.Y[i] = m_data_buf.Y[index];
+    }
+    m_pos++;
     num_line++;
   }
   // End of file
   if (num_line != m_num_samples) {
     m_data_samples.resize(num_line);
   }
+  F2M_PROFILE_COUNT(PROFILE_READ, num_line, 0, 0);
   return &m_data_samples;
 }
 
-uint32 ReadLineFromMemory(char* line, char* buf, 
-                          uint32 start_pos, uint32 len) {
-  // End of the file
-  if (start_pos >= len) return 0;
-  uint32 end_pos = start_pos;
-  while (*(buf+end_pos) != '\n') {++end_pos;}
-  uint32 read_size = end_pos - start_pos + 1;
-  if (read_size > kMaxLineSize) {
-    LOG(FATAL) << "Encountered a too-long line.";
+void Reader::Restart() {
+  CHECK_EQ(m_seekable, true);
+  if (m_block_cache != NULL) {
+    StartBlockEpoch();
+  } else if (m_in_memory) {
+    m_pos = 0;
+  } else {
+    Rewind();
+  }
+  // The last batch of the data may have been shorter.
+  if (m_in_memory || !m_shuffle) {
+    m_data_samples.resize(m_num_samples);
+  }
+}
+
+DMatrix* Reader::SampleFromBlocks() {
+  F2M_PROFILE_SCOPE(PROFILE_READ);
+  // The rows decoded for the last batch are not used any more.
+  m_data_samples.resize(m_num_samples);
+  m_data_samples.ResetSparseRow();
+  uint32 num_line = 0;
+  for (index_t i = 0; i < m_num_samples; ++i) {
+    if ((m_current_block == NULL ||
+         m_row_pos >= m_current_block->GetNumberOfRows()) &&
+        !NextBlock()) {
+      break;
+    }
+    index_t index = m_shuffle ? m_row_order[m_row_pos] : m_row_pos;
+    m_data_samples.Y[i] = m_current_block->Decode(index,
+                                                  m_data_samples.row[i]);
+    m_row_pos++;
+    num_line++;
+  }
+  // End of file
+  if (num_line != m_num_samples) {
+    m_data_samples.resize(num_line);
+  }
+  F2M_PROFILE_COUNT(PROFILE_READ, num_line, 0, 0);
+  return &m_data_samples;
+}
+
+bool Reader::NextBlock() {
+  // End of file
+  if (m_block_pos >= m_block_order.size()) {
+    if (!m_loop) {
+      // Only one epoch without loop.
+      if (m_epoch == 0) EndOfEpoch();
+      return false;
+    }
+    EndOfEpoch();
+    StartBlockEpoch();
+  }
+  m_current_block = m_block_cache->Get(m_block_pos++);
+  m_row_pos = 0;
+  if (m_shuffle) {
+    m_row_order.resize(m_current_block->GetNumberOfRows());
+    for (index_t j = 0; j < m_row_order.size(); ++j) {
+      m_row_order[j] = j;
+    }
+    std::shuffle(m_row_order.begin(), m_row_order.end(), m_rng);
+  }
+  return true;
+}
+
+void Reader::StartBlockEpoch() {
+  m_block_order.resize(m_block_cache->GetNumberOfBlocks());
+  for (index_t i = 0; i < m_block_order.size(); ++i) {
+    m_block_order[i] = i;
+  }
+  if (m_shuffle) {
+    std::shuffle(m_block_order.begin(), m_block_order.end(), m_rng);
+  }
+  m_block_cache->SetOrder(m_block_order);
+  m_block_pos = 0;
+  m_current_block = NULL;
+}
+
+void Reader::UseBlockCache(const string& block_file,
+                           uint64 memory_budget,
+                           uint64 block_bytes) {
+  CHECK_EQ(m_in_memory, false);
+  CHECK(m_block_cache == NULL);
+  // Reuse the block file of an earlier run, if it was parsed
+  // the same way. A filter admits the features as it sees them,
+  // and it would see nothing, so then we always parse again.
+  bool up_to_date = false;
+  uint64 fingerprint = m_parser->Fingerprint();
+  if (m_filename != "-" && m_filter == NULL &&
+      BlockCache::IsBlockFile(block_file, m_type, fingerprint)) {
+    struct stat input_stat, block_stat;
+    CHECK_EQ(stat(m_filename.c_str(), &input_stat), 0);
+    CHECK_EQ(stat(block_file.c_str(), &block_stat), 0);
+    up_to_date = block_stat.st_mtime >= input_stat.st_mtime;
+  }
+  if (!up_to_date) {
+    WriteBlockFile(block_file, block_bytes);
+  }
+  m_block_cache = new BlockCache(block_file, m_type, memory_budget);
+  CHECK_GT(m_block_cache->GetNumberOfBlocks(), 0);
+  StartBlockEpoch();
+}
+
+void Reader::WriteBlockFile(const string& block_file, uint64 block_bytes) {
+  BlockWriter writer(block_file, m_type, m_parser->Fingerprint());
+  CompressedMatrix block(m_type);
+  DMatrix batch(m_type);
+  uint32 num_line = 0;
+  do {
+    num_line = 0;
+    while (num_line < m_num_samples &&
+           ReadTextLine(&m_list[num_line]) > 0) {
+      num_line++;
+    }
+    batch.resize(num_line);
+    batch.ResetSparseRow();
+    m_parser->Parse(m_list, batch);
+    block.Append(batch);
+    if (block.GetNumberOfBytes() >= block_bytes ||
+        (num_line < m_num_samples && block.GetNumberOfRows() > 0)) {
+      writer.Write(block);
+      block.Clear();
+    }
+  } while (num_line == m_num_samples);
+  writer.Finish();
+  LOG(INFO) << "Wrote the blocks of " << m_filename
+            << " to " << block_file;
+}
+
+void Reader::EndOfEpoch() {
+  m_epoch++;
+}
+
+uint32 Reader::ReadLine(char* line) {
+  if (m_decompressor != NULL) {
+    return m_decompressor->ReadLine(line, kMaxLineSize);
+  }
+  if (fgets(line, kMaxLineSize, m_file_ptr) == NULL) {
+    return 0;
+  }
+  return strlen(line);
+}
+
+void Reader::Rewind() {
+  if (m_decompressor != NULL) {
+    m_decompressor->Rewind();
+  } else {
+    fseek(m_file_ptr, 0, SEEK_SET);
   }
-  memcpy(line, buf+start_pos, read_size);
-  return read_size;
 }
 
 } // namespace f2m
@@ -24,11 +24,14 @@ in each iteration.
 #ifndef F2M_READER_READER_H_
 #define F2M_READER_READER_H_
 
+#include <random>
 #include <string>
 #include <vector>
 
 #include "src/base/common.h"
+#include "src/data/compressed_matrix.h"
 #include "src/data/data_structure.h"
+#include "src/reader/block_cache.h"
 #include "src/reader/parser.h"
 
 using std::vector;
@@ -36,6 +39,29 @@ using std::string;
 
 namespace f2m {
 
+class Decompressor;
+
+// The options of a Reader besides the input, the batch size and the
+// model type. The defaults read the idx:value format from disk in a
+// loop, so that a caller only sets the options it needs:
+//
+//   ReaderOptions options;
+//   options.in_memory = true;
+//   options.compress = true;
+//   Reader reader(filename, num_samples, FFM, options);
+struct ReaderOptions {
+  ReaderOptions(bool loop = true, bool in_memory = false)
+    : loop(loop), in_memory(in_memory), shuffle(false),
+      filter(NULL), parser(NULL), compress(false) {}
+
+  bool loop;                        // continue to sample data in a loop.
+  bool in_memory;                   // load all data into memory.
+  bool shuffle;                     // shuffle the data.
+  FeatureFilter* filter;            // NULL for no feature filter.
+  Parser* parser;                   // NULL for the idx:value format.
+  bool compress;                    // compress the in-memory data.
+};
+
 /* -----------------------------------------------------------------------------
  * We can use Reader class like this (Pseudocode):                              *
  *                                                                              *
@@ -101,6 +127,73 @@ namespace f2m {
  *                                                                              *
  *   }                                                                          *
  *                                                                              *
+ * The input file can be compressed by gzip or zstd. Reader detects them by     *
+ * the magic number and decompresses them on a dedicated thread, so there is    *
+ * no need to decompress the data to disk first.                                *
+ *                                                                              *
+ * The input can also be a stream that cannot seek, such as a named pipe or     *
+ * the stdin (use "-" as the filename). A stream is read only once, so it must  *
+ * be opened with loop = false and in_memory = false:                           *
+ *                                                                              *
+ *   Reader reader(filename = "-",                                              *
+ *                 num_samples = 100,                                           *
+ *                 model_type = LR,                                             *
+ *                 loop = false);                                               *
+ *                                                                              *
+ * The other options are set in a ReaderOptions. SGD converges faster if it     *
+ * does not see the same order in every epoch, so we can ask Reader to          *
+ * shuffle the data:                                                            *
+ *                                                                              *
+ *   ReaderOptions options(loop = true, in_memory = true);                      *
+ *   options.shuffle = true;                                                    *
+ *   Reader reader(filename = "/tmp/testdata",                                  *
+ *                 num_samples = 100,                                           *
+ *                 model_type = LR,                                             *
+ *                 options);                                                    *
+ *                                                                              *
+ * For in-memory data, Reader walks a new random permutation of the rows in     *
+ * each epoch. The permutation is generated in parallel and only row indices    *
+ * are moved, not the rows. For data on disk, Reader still reads the file       *
+ * sequentially, but keeps a bounded shuffle buffer of a few parsed blocks,     *
+ * and fills each batch with rows drawn from the buffer at random.              *
+ *                                                                              *
+ * The in-memory data takes much less memory with options.compress: the rows    *
+ * are kept varint-encoded in a CompressedMatrix (see compressed_matrix.h), and *
+ * are decoded again when they are sampled. The text is read and encoded a      *
+ * block of lines at a time, and is never in memory as a whole. With a filter,  *
+ * the input is read twice, first to count the features and then to encode the  *
+ * rows.                                                                        *
+ *                                                                              *
+ * Data larger than the memory can be trained on for many epochs without        *
+ * parsing the text again. UseBlockCache() converts the input into a file of    *
+ * compressed blocks once, and then reads the blocks through a BlockCache (see  *
+ * block_cache.h), which prefetches the next blocks on its own thread and       *
+ * keeps the recently used ones within a memory budget:                         *
+ *                                                                              *
+ *   ReaderOptions options(loop = true, in_memory = false);                     *
+ *   options.shuffle = true;                                                    *
+ *   Reader reader("/tmp/testdata", num_samples = 100, LR, options);            *
+ *   reader.UseBlockCache("/tmp/testdata.blocks",                               *
+ *                        memory_budget = 8GB);                                 *
+ *                                                                              *
+ * With shuffle, the blocks are read in a random order, and the rows of each    *
+ * block are also shuffled.                                                     *
+ *                                                                              *
+ * Reader parses the idx:value format by default. Raw column-oriented TSV       *
+ * logs can be read with a CriteoParser (see criteo_parser.h) instead, by       *
+ * setting options.parser.                                                      *
+ *                                                                              *
+ * With a FeatureFilter in options.filter (see feature_filter.h), the rare      *
+ * feature ids are mapped to a shared bucket as they are parsed, and the other  *
+ * ids are renumbered densely, so that the model can be much smaller. The       *
+ * in-memory data is mapped by the total count of every feature, with or        *
+ * without compress.                                                            *
+ *                                                                              *
+ * Reader keeps all of its state in the instance, so we can use many readers    *
+ * at the same time, e.g. a training and a validation stream, or one reader     *
+ * per worker thread on its own shard. Each reader can run on its own thread,   *
+ * but one reader must not be used by two threads at the same time.             *
+ *                                                                              *
  * Reader is an algorithm-agnostic class and can mask the details of            *
  * the data source (on disk or in memory), and it is flexible for               *
  * different gradient descent methods (e.g., SGD, mini-batch GD, and            *
@@ -116,25 +209,106 @@ class Reader {
          bool loop = true, // Continue to sample data in a loop.
          bool in_memory = false); // Reader samples data from disk file 
                                   // by default.
+  Reader(const string& filename,
+         int num_samples,
+         ModelType type,
+         const ReaderOptions& options);
   ~Reader();
 
   // Return a pointer to the DMatrix.
   DMatrix* Samples();
 
+  // Return true if the input is a pipe or the stdin.
+  bool IsStream() const { return !m_seekable; }
+
+  // Return the most rows of a DMatrix from Samples().
+  int GetNumberOfSamples() const { return m_num_samples; }
+
+  // Return the number of epochs finished, so that the training
+  // loop can tell an epoch, e.g., to log the profile.
+  uint32 GetNumberOfEpochs() const { return m_epoch; }
+
+  // Go back to the beginning of the data, so that a reader
+  // without loop can read it once more, e.g., for validation.
+  void Restart();
+
+  // Read the data from |block_file| instead of the text. The input
+  // is parsed into the block file first, unless it is already there,
+  // newer than the input and parsed by the same kind of parser.
+  // With a feature filter, the input is always parsed again, so
+  // that the filter sees the features. At most |memory_budget|
+  // bytes of the blocks are kept in memory.
+  void UseBlockCache(const string& block_file,
+                     uint64 memory_budget,
+                     uint64 block_bytes = kDefaultBlockBytes);
+
  private:
   string m_filename;                // indentify the input file.
   int m_num_samples;                // the number of data samples in each sampling.
   bool m_loop;                      // sample data in a loop.
   bool m_in_memory;                 // load all data into memory.
   FILE* m_file_ptr;                 // maintain current file pointer.
+  bool m_seekable;                  // false for pipes and the stdin.
+  Decompressor* m_decompressor;     // NULL for plain text file.
   ModelType m_type;                 // enum ModelType { LR, FM, FFM }
+  bool m_compress;                  // compress the in-memory data.
+  CompressedMatrix m_compressed;    // in-memory rows when compressed.
 
   DMatrix m_data_buf;               // bufferring all parsed data in memory.
   DMatrix m_data_samples;           // data samples
-  Parser m_parser;                  // Parse StringList to the DMatrix format.
+  Parser m_default_parser;          // Parse the idx:value format.
+  Parser* m_parser;                 // Parse StringList to the DMatrix format.
+  FeatureFilter* m_filter;          // NULL for no feature filter.
+
+  bool m_shuffle;                   // shuffle the data.
+  std::mt19937 m_rng;               // random generator for shuffling.
+  uint32 m_epoch;                   // number of finished epochs.
+  index_t m_pos;                    // next position in the in-memory data.
+  vector<index_t> m_order;          // permutation of the in-memory rows.
+  vector<SparseRow*> m_pool_rows;   // shuffle buffer of parsed rows.
+  vector<real_t> m_pool_y;          // labels of the rows in shuffle buffer.
+  vector<SparseRow*> m_free_rows;   // parsed rows that can be reused.
+  DMatrix m_block;                  // a block of rows parsed from disk, its
+                                    // arena stores the shuffle buffer.
+  vector<char> m_line;              // buffer of the line being read.
+  StringList m_list;                // lines of the batch being read.
+  BlockCache* m_block_cache;        // NULL unless reading a block file.
+  vector<index_t> m_block_order;    // the order of blocks in this epoch.
+  index_t m_block_pos;              // next position in m_block_order.
+  const CompressedMatrix* m_current_block;  // the block being read.
+  vector<index_t> m_row_order;      // the order of rows in the block.
+  index_t m_row_pos;                // next position in m_row_order.
 
   DMatrix* SampleFromDisk();
+  DMatrix* SampleFromShuffleBuffer();
+  // Read at most m_num_samples lines into m_list, and
+  // return the number of lines.
+  uint32 ReadLines();
+  // Read one line from disk file, and return its length.
+  uint32 ReadLine(char* line);
+  // Read one line without the newline into |line|, and
+  // return the number of bytes read, or 0 at end of file.
+  uint32 ReadTextLine(string* line);
+  // Return to the beginning of the file.
+  void Rewind();
   DMatrix* SampleFromMemory();
+  DMatrix* SampleFromBlocks();
+  // Move on to the next block, and return false at end of file.
+  bool NextBlock();
+  // Read the blocks in a new order.
+  void StartBlockEpoch();
+  // Parse all the input into |block_file|.
+  void WriteBlockFile(const string& block_file, uint64 block_bytes);
+  // Read the whole input into m_compressed a block at a time.
+  // With a filter, read it twice: count all the blocks first.
+  void CompressFile();
+  // The number of rows loaded into memory.
+  index_t GetNumberOfRowsInMemory() const {
+    return m_compress ? m_compressed.GetNumberOfRows() :
+                        m_data_buf.row_size;
+  }
+  // Count an epoch.
+  void EndOfEpoch();
 
   DISALLOW_COPY_AND_ASSIGN(Reader);
 };
@@ -22,10 +22,16 @@ This file tests reader.h
 
 #include "gtest/gtest.h"
 
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "src/base/file_util.h"
+#include "src/reader/feature_filter.h"
 #include "src/reader/reader.h"
 #include "src/data/data_structure.h"
 
@@ -171,4 +177,319 @@ TEST_F(ReaderTest, SampleFromMemoryInLoop) {
     CheckFFM(matrix);
   }
 }
+
+// Write a file whose i-th line has label i.
+string WriteLabeledFile() {
+  string filename = kTestfilename + "_labeled.txt";
+  FILE* file = OpenFileOrDie(filename.c_str(), "w");
+  for (index_t i = 0; i < kNumLines / 10; ++i) {
+    fprintf(file, "%u\t0:0.123\t1:0.123\n", i);
+  }
+  Close(file);
+  return filename;
+}
+
+// Read |num_rows| labels from |reader|.
+vector<index_t> ReadLabels(Reader& reader, index_t num_rows) {
+  vector<index_t> labels;
+  while (labels.size() < num_rows) {
+    DMatrix* matrix = reader.Samples();
+    if (matrix->row_size == 0) break;
+    for (index_t i = 0; i < matrix->row_size; ++i) {
+      EXPECT_EQ(matrix->row[i]->size, (index_t)2);
+      labels.push_back((index_t)matrix->Y[i]);
+    }
+  }
+  return labels;
+}
+
+// Every row appears exactly once, but not in the file order.
+void CheckPermutation(vector<index_t> labels, index_t num_rows) {
+  EXPECT_EQ(labels.size(), num_rows);
+  bool in_order = true;
+  for (index_t i = 0; i < labels.size(); ++i) {
+    if (labels[i] != i) in_order = false;
+  }
+  EXPECT_FALSE(in_order);
+  std::sort(labels.begin(), labels.end());
+  for (index_t i = 0; i < labels.size(); ++i) {
+    EXPECT_EQ(labels[i], i);
+  }
+}
+
+TEST_F(ReaderTest, ShuffleInMemory) {
+  string filename = WriteLabeledFile();
+  index_t num_rows = kNumLines / 10;
+  ReaderOptions options(true, true);
+  options.shuffle = true;
+  Reader reader(filename, kNumSamples, LR, options);
+  vector<index_t> first = ReadLabels(reader, num_rows);
+  vector<index_t> second = ReadLabels(reader, num_rows);
+  // Every epoch walks a different permutation.
+  EXPECT_NE(first, second);
+  CheckPermutation(first, num_rows);
+  CheckPermutation(second, num_rows);
+}
+
+TEST_F(ReaderTest, CompressInMemory) {
+  string lr_file = kTestfilename + "_LR.txt";
+  string ffm_file = kTestfilename + "_ffm.txt";
+  ReaderOptions options(true, true);
+  options.compress = true;
+  // lr
+  Reader reader_lr(lr_file, kNumSamples, LR, options);
+  DMatrix* matrix = NULL;
+  for (int i = 0; i < iteration_num; ++i) {
+    matrix = reader_lr.Samples();
+    CheckLR(matrix);
+  }
+  // ffm
+  Reader reader_ffm(ffm_file, kNumSamples, FFM, options);
+  for (int i = 0; i < iteration_num; ++i) {
+    matrix = reader_ffm.Samples();
+    CheckFFM(matrix);
+  }
+  // The compressed data is shuffled in the same order.
+  string filename = WriteLabeledFile();
+  index_t num_rows = kNumLines / 10;
+  options.shuffle = true;
+  Reader compressed(filename, kNumSamples, LR, options);
+  options.compress = false;
+  Reader reader(filename, kNumSamples, LR, options);
+  for (int epoch = 0; epoch < 2; ++epoch) {
+    EXPECT_EQ(ReadLabels(reader, num_rows),
+              ReadLabels(compressed, num_rows));
+  }
+}
+
+// A compressed row holds the same features, but sorted by idx,
+// so a sum over the row is only equal within a rounding error.
+TEST_F(ReaderTest, CompressSortsRows) {
+  string filename = kTestfilename + "_unsorted.txt";
+  FILE* file = OpenFileOrDie(filename.c_str(), "w");
+  for (index_t i = 0; i < kNumSamples; ++i) {
+    fprintf(file, "1\t%u:0.1\t%u:3e5\t%u:-3e5\t%u:0.7\n",
+            3999 - i, 1000 + i, 2000 + i, i);
+  }
+  Close(file);
+  ReaderOptions options(false, true);
+  Reader reader(filename, kNumSamples, LR, options);
+  options.compress = true;
+  Reader compressed(filename, kNumSamples, LR, options);
+  DMatrix* expected = reader.Samples();
+  DMatrix* matrix = compressed.Samples();
+  ASSERT_EQ(matrix->row_size, expected->row_size);
+  for (index_t i = 0; i < matrix->row_size; ++i) {
+    SparseRow* row = matrix->row[i];
+    SparseRow* expected_row = expected->row[i];
+    ASSERT_EQ(row->size, expected_row->size);
+    vector<std::pair<index_t, real_t> > items, expected_items;
+    real_t sum = 0, expected_sum = 0;
+    for (index_t j = 0; j < row->size; ++j) {
+      items.push_back(std::make_pair(row->idx[j], row->X[j]));
+      expected_items.push_back(std::make_pair(expected_row->idx[j],
+                                              expected_row->X[j]));
+      sum += row->X[j] * (row->idx[j] % 7 + 1);
+      expected_sum += expected_row->X[j] * (expected_row->idx[j] % 7 + 1);
+    }
+    for (index_t j = 1; j < row->size; ++j) {
+      EXPECT_LT(row->idx[j-1], row->idx[j]);
+    }
+    std::sort(expected_items.begin(), expected_items.end());
+    EXPECT_EQ(items, expected_items);
+    EXPECT_NEAR(sum, expected_sum, 1e-6 * 3e5 * 7 * 4);
+  }
+  unlink(filename.c_str());
+}
+
+// A compressed reader parses the data in blocks, but its filter
+// must still map every feature by its total count.
+TEST_F(ReaderTest, CompressWithFilter) {
+  string filename = kTestfilename + "_filter.txt";
+  string gz_filename = filename + ".gz";
+  FILE* file = OpenFileOrDie(filename.c_str(), "w");
+  gzFile gz_file = gzopen(gz_filename.c_str(), "wb");
+  // Feature 7 is seen once in the first block and then
+  // three more times in the second block.
+  for (index_t i = 0; i < kNumLines; ++i) {
+    bool rare = i == 0 || (i >= 90000 && i < 90003);
+    fprintf(file, "%s\n", rare ? "1\t7:1" : "0\t1:1");
+    gzprintf(gz_file, "%s\n", rare ? "1\t7:1" : "0\t1:1");
+  }
+  Close(file);
+  gzclose(gz_file);
+  // The compressed reader reads the input twice, and a
+  // .gz file is decompressed again for the second pass.
+  const string kFiles[] = { filename, gz_filename };
+  for (int f = 0; f < 2; ++f) {
+    FeatureFilter filter(3, 100), compressed_filter(3, 100);
+    ReaderOptions options(false, true);
+    options.filter = &filter;
+    Reader reader(filename, kNumSamples, LR, options);
+    options.filter = &compressed_filter;
+    options.compress = true;
+    Reader compressed(kFiles[f], kNumSamples, LR, options);
+    for (;;) {
+      DMatrix* expected = reader.Samples();
+      DMatrix* matrix = compressed.Samples();
+      ASSERT_EQ(matrix->row_size, expected->row_size);
+      if (matrix->row_size == 0) break;
+      for (index_t i = 0; i < matrix->row_size; ++i) {
+        ASSERT_EQ(matrix->row[i]->size, 1);
+        ASSERT_EQ(matrix->row[i]->idx[0], expected->row[i]->idx[0]);
+      }
+    }
+    EXPECT_EQ(compressed_filter.GetNumberOfAdmitted(), 2);
+    EXPECT_EQ(compressed_filter.GetNumberOfRare(), 0);
+  }
+  unlink(filename.c_str());
+  unlink(gz_filename.c_str());
+}
+
+TEST_F(ReaderTest, ShuffleFromDisk) {
+  string filename = WriteLabeledFile();
+  index_t num_rows = kNumLines / 10;
+  ReaderOptions options(false, false);
+  options.shuffle = true;
+  Reader reader(filename, kNumSamples, LR, options);
+  vector<index_t> labels = ReadLabels(reader, num_rows + 1);
+  CheckPermutation(labels, num_rows);
+  // The reader keeps returning empty batches at end of file.
+  EXPECT_EQ(reader.Samples()->row_size, (index_t)0);
+}
+
+TEST_F(ReaderTest, BlockCache) {
+  string lr_file = kTestfilename + "_LR.txt";
+  string ffm_file = kTestfilename + "_ffm.txt";
+  string block_file = kTestfilename + ".blocks";
+  // Blocks of about 64 KB, and room for a few of them.
+  Reader reader_lr(lr_file, kNumSamples, LR, true);
+  reader_lr.UseBlockCache(block_file, 256 * 1024, 64 * 1024);
+  DMatrix* matrix = NULL;
+  for (int i = 0; i < iteration_num; ++i) {
+    matrix = reader_lr.Samples();
+    CheckLR(matrix);
+  }
+  Reader reader_ffm(ffm_file, kNumSamples, FFM, true);
+  reader_ffm.UseBlockCache(block_file, 256 * 1024, 64 * 1024);
+  for (int i = 0; i < iteration_num; ++i) {
+    matrix = reader_ffm.Samples();
+    CheckFFM(matrix);
+  }
+  unlink(block_file.c_str());
+  // Every row is read once in each epoch.
+  string filename = WriteLabeledFile();
+  index_t num_rows = kNumLines / 10;
+  Reader reader(filename, kNumSamples, LR, false);
+  reader.UseBlockCache(block_file, 256 * 1024, 64 * 1024);
+  vector<index_t> labels = ReadLabels(reader, num_rows + 1);
+  EXPECT_EQ(labels.size(), num_rows);
+  for (index_t i = 0; i < labels.size(); ++i) {
+    EXPECT_EQ(labels[i], i);
+  }
+  EXPECT_EQ(reader.Samples()->row_size, (index_t)0);
+  // The block file is reused, and shuffled in every epoch.
+  ReaderOptions options(true, false);
+  options.shuffle = true;
+  Reader shuffled(filename, kNumSamples, LR, options);
+  shuffled.UseBlockCache(block_file, 256 * 1024);
+  vector<index_t> first = ReadLabels(shuffled, num_rows);
+  vector<index_t> second = ReadLabels(shuffled, num_rows);
+  EXPECT_NE(first, second);
+  CheckPermutation(first, num_rows);
+  CheckPermutation(second, num_rows);
+  // Another parser parses the input again.
+  Parser tab_parser("\t");
+  EXPECT_NE(tab_parser.Fingerprint(), Parser().Fingerprint());
+  options.parser = &tab_parser;
+  Reader reparsed(filename, kNumSamples, LR, options);
+  reparsed.UseBlockCache(block_file, 256 * 1024);
+  EXPECT_TRUE(BlockCache::IsBlockFile(block_file, LR,
+                                      tab_parser.Fingerprint()));
+  // So does a reader with a filter, which must see the features.
+  FeatureFilter filter(1, 100);
+  options.filter = &filter;
+  Reader filtered(filename, kNumSamples, LR, options);
+  filtered.UseBlockCache(block_file, 256 * 1024);
+  EXPECT_EQ(filter.GetNumberOfAdmitted(), 2);
+  unlink(block_file.c_str());
+}
+
+TEST_F(ReaderTest, InterleavedReaders) {
+  string lr_file = kTestfilename + "_LR.txt";
+  string ffm_file = kTestfilename + "_ffm.txt";
+  // Two readers with different batch sizes on one thread.
+  Reader reader_lr(lr_file, kNumSamples, LR, false);
+  Reader reader_ffm(ffm_file, kNumSamples / 2, FFM, false);
+  index_t lr_rows = 0, ffm_rows = 0;
+  for (;;) {
+    DMatrix* lr = reader_lr.Samples();
+    DMatrix* ffm = reader_ffm.Samples();
+    if (lr->row_size == 0 && ffm->row_size == 0) break;
+    if (lr->row_size == kNumSamples) CheckLR(lr);
+    for (index_t i = 0; i < ffm->row_size; ++i) {
+      EXPECT_EQ(ffm->Y[i], (real_t)1);
+      EXPECT_EQ(ffm->row[i]->field[kFeatureNum-1], kFeatureNum-1);
+    }
+    lr_rows += lr->row_size;
+    ffm_rows += ffm->row_size;
+  }
+  EXPECT_EQ(lr_rows, kNumLines);
+  EXPECT_EQ(ffm_rows, kNumLines);
+}
+
+TEST_F(ReaderTest, ConcurrentReaders) {
+  string lr_file = kTestfilename + "_LR.txt";
+  string ffm_file = kTestfilename + "_ffm.txt";
+  const int kNumReaders = 8;
+  vector<index_t> num_rows(kNumReaders, 0);
+  vector<std::thread> threads;
+  for (int t = 0; t < kNumReaders; ++t) {
+    threads.push_back(std::thread([&, t]() {
+      bool ffm = t % 2;
+      // Cover the disk, the in-memory and the shuffled readers.
+      ReaderOptions options(false, t % 4 >= 2);
+      options.shuffle = t >= 4;
+      Reader reader(ffm ? ffm_file : lr_file, kNumSamples,
+                    ffm ? FFM : LR, options);
+      for (;;) {
+        DMatrix* matrix = reader.Samples();
+        if (matrix->row_size == 0) break;
+        for (index_t i = 0; i < matrix->row_size; ++i) {
+          ASSERT_EQ(matrix->Y[i], (real_t)(ffm ? 1 : 0));
+          ASSERT_EQ(matrix->row[i]->size, kFeatureNum);
+          ASSERT_EQ(matrix->row[i]->idx[kFeatureNum-1], kFeatureNum-1);
+        }
+        num_rows[t] += matrix->row_size;
+      }
+    }));
+  }
+  for (int t = 0; t < kNumReaders; ++t) {
+    threads[t].join();
+    EXPECT_EQ(num_rows[t], kNumLines);
+  }
+}
+
+TEST_F(ReaderTest, Restart) {
+  string lr_file = kTestfilename + "_LR.txt";
+  // The last batch is shorter than the others.
+  const index_t kBatchSize = 3000;
+  for (int mode = 0; mode < 3; ++mode) {
+    ReaderOptions options(false, mode == 1);
+    options.shuffle = mode == 2;
+    Reader reader(lr_file, kBatchSize, LR, options);
+    for (int pass = 0; pass < 2; ++pass) {
+      index_t num_rows = 0;
+      for (;;) {
+        DMatrix* matrix = reader.Samples();
+        if (matrix->row_size == 0) break;
+        EXPECT_EQ(matrix->row[0]->idx[kFeatureNum-1], kFeatureNum-1);
+        num_rows += matrix->row_size;
+      }
+      EXPECT_EQ(num_rows, kNumLines);
+      reader.Restart();
+    }
+  }
+}
+
 } // namespace f2m
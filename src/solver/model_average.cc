@@ -0,0 +1,196 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file is the implementation of model_average.h
+*/
+
+#include "src/solver/model_average.h"
+
+#include <string.h>
+
+#include <vector>
+
+#include "src/base/common.h"
+
+using std::vector;
+
+namespace f2m {
+
+// Each block holds 1024 parameters (4 KB), which is the
+// granularity of the touched-block tracking.
+const index_t kBlockShift = 10;
+const index_t kBlockSize = 1 << kBlockShift;
+
+ModelAverage::ModelAverage(const vector<Model*>& replicas,
+                           int sync_interval,
+                           bool sparse_sync)
+  : m_replicas(replicas),
+    m_sync_interval(sync_interval),
+    m_sparse_sync(sparse_sync),
+    m_active(replicas.size()),
+    m_generation(0),
+    m_done(0),
+    m_done_generation(0),
+    m_final(false) {
+  CHECK_GT(m_replicas.size(), 0);
+  CHECK_GT(m_sync_interval, 0);
+  for (size_t i = 0; i < m_replicas.size(); ++i) {
+    CHECK_NOTNULL(m_replicas[i]);
+  }
+  m_num_parameters = m_replicas[0]->GetNumberOfParameters();
+  m_num_blocks = (m_num_parameters + kBlockSize - 1) / kBlockSize;
+  // Broadcast the first replica.
+  ParameterVector* source = m_replicas[0]->GetParameter();
+  for (size_t i = 1; i < m_replicas.size(); ++i) {
+    CHECK_EQ(m_replicas[i]->GetNumberOfParameters(), m_num_parameters);
+    ParameterVector* param = m_replicas[i]->GetParameter();
+    if (param == source) continue;  // a shared replica.
+    memcpy(param->data(), source->data(), m_num_parameters * sizeof(real_t));
+  }
+  m_dirty.resize(m_replicas.size(), vector<uint8>(m_num_blocks, 0));
+  m_steps.resize(m_replicas.size(), 0);
+  m_retired.resize(m_replicas.size(), 0);
+  m_retiring.resize(m_replicas.size(), false);
+}
+
+void ModelAverage::Step(int worker_id, const SparseGrad& grad) {
+  CHECK_GE(worker_id, 0);
+  CHECK_LT(worker_id, m_replicas.size());
+  CHECK(!m_retired[worker_id]);
+  if (m_sparse_sync) {
+    vector<uint8>& dirty = m_dirty[worker_id];
+    for (index_t i = 0; i < grad.size_w; ++i) {
+      dirty[grad.pos_w[i] >> kBlockShift] = 1;
+    }
+    for (index_t i = 0; i < grad.size_v; ++i) {
+      dirty[grad.pos_v[i] >> kBlockShift] = 1;
+    }
+  }
+  if (++m_steps[worker_id] % m_sync_interval == 0) {
+    Sync(worker_id, false);
+  }
+}
+
+void ModelAverage::Finish(int worker_id) {
+  CHECK_GE(worker_id, 0);
+  CHECK_LT(worker_id, m_replicas.size());
+  CHECK(!m_retired[worker_id]);
+  Sync(worker_id, true);
+  m_retired[worker_id] = 1;
+}
+
+uint64 ModelAverage::GetNumberOfSyncs() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_generation;
+}
+
+void ModelAverage::Sync(int worker_id, bool retire) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  index_t rank = m_arrived.size();
+  m_arrived.push_back(worker_id);
+  m_retiring[worker_id] = retire;
+  uint64 generation = m_generation;
+  if (m_arrived.size() == m_active) {
+    // The last arriving worker prepares current sync.
+    m_members.swap(m_arrived);
+    m_arrived.clear();
+    m_blocks.clear();
+    for (index_t b = 0; b < m_num_blocks; ++b) {
+      bool touched = !m_sparse_sync;
+      for (size_t i = 0; !touched && i < m_members.size(); ++i) {
+        touched = m_dirty[m_members[i]][b] != 0;
+      }
+      if (touched) {
+        m_blocks.push_back(b);
+      }
+    }
+    for (size_t i = 0; i < m_members.size(); ++i) {
+      if (m_retiring[m_members[i]]) {
+        --m_active;
+      }
+    }
+    m_final = (m_active == 0);
+    ++m_generation;
+    m_cond.notify_all();
+  } else {
+    m_cond.wait(lock, [&] { return m_generation != generation; });
+  }
+  lock.unlock();
+
+  // Every member averages its own slice of the blocks.
+  index_t num_members = m_members.size();
+  index_t num_blocks = m_blocks.size();
+  AverageBlocks(num_blocks * rank / num_members,
+                num_blocks * (rank + 1) / num_members);
+  // The touched blocks of this replica are now in sync.
+  if (m_sparse_sync) {
+    vector<uint8>& dirty = m_dirty[worker_id];
+    memset(dirty.data(), 0, dirty.size());
+  }
+
+  // Nobody can go on training until the average is done.
+  lock.lock();
+  if (++m_done == num_members) {
+    m_done = 0;
+    // All the replicas hold the same model at the end.
+    if (m_final) {
+      ParameterVector* source = m_replicas[worker_id]->GetParameter();
+      for (size_t i = 0; i < m_replicas.size(); ++i) {
+        ParameterVector* param = m_replicas[i]->GetParameter();
+        if (param != source) {
+          memcpy(param->data(), source->data(),
+                 m_num_parameters * sizeof(real_t));
+        }
+      }
+    }
+    ++m_done_generation;
+    m_cond.notify_all();
+  } else {
+    m_cond.wait(lock, [&] { return m_done_generation > generation; });
+  }
+}
+
+void ModelAverage::AverageBlocks(index_t begin, index_t end) {
+  index_t num_members = m_members.size();
+  real_t scale = 1.0 / num_members;
+  vector<real_t> sum(kBlockSize);
+  for (index_t i = begin; i < end; ++i) {
+    index_t start = m_blocks[i] << kBlockShift;
+    index_t len = kBlockSize;
+    if (start + len > m_num_parameters) {
+      len = m_num_parameters - start;
+    }
+    real_t* first = m_replicas[m_members[0]]->GetParameter()->data() + start;
+    for (index_t j = 0; j < len; ++j) {
+      sum[j] = first[j];
+    }
+    for (index_t m = 1; m < num_members; ++m) {
+      real_t* param = m_replicas[m_members[m]]->GetParameter()->data() + start;
+      for (index_t j = 0; j < len; ++j) {
+        sum[j] += param[j];
+      }
+    }
+    for (index_t m = 0; m < num_members; ++m) {
+      real_t* param = m_replicas[m_members[m]]->GetParameter()->data() + start;
+      for (index_t j = 0; j < len; ++j) {
+        param[j] = sum[j] * scale;
+      }
+    }
+  }
+}
+
+} // namespace f2m
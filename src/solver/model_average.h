@@ -0,0 +1,134 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                     *
+ *                                                                              *
+ * Licensed under the Apache License, Version 2.0 (the "License");              *
+ * you may not use this file except in compliance with the License.             *
+ * You may obtain a copy of the License at                                      *
+ *                                                                              *
+ *     http://www.apache.org/licenses/LICENSE-2.0                               *
+ *                                                                              *
+ *  Unless required by applicable law or agreed to in writing, software         *
+ *  distributed under the License is distributed on an "AS IS" BASIS,           *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ *  See the License for the specific language governing permissions and         *
+ *  limitations under the License.                                              *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file defines ModelAverage, which keeps a set of Model replicas
+in sync by periodically averaging their parameters.
+*/
+
+#ifndef F2M_SOLVER_MODEL_AVERAGE_H_
+#define F2M_SOLVER_MODEL_AVERAGE_H_
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include "src/base/common.h"
+#include "src/data/data_structure.h"
+#include "src/data/model_parameters.h"
+
+using std::vector;
+
+namespace f2m {
+
+/* -----------------------------------------------------------------------------
+ * ModelAverage is an alternative scale-out mode to the parameter server.       *
+ * K workers (threads) each own a full Model replica and train on a disjoint    *
+ * data shard with the normal Loss and Updater. Every M batches they meet at    *
+ * a barrier and average their parameters in shared memory. Between two syncs   *
+ * there is no synchronization at all, so the workers scale almost linearly.    *
+ *                                                                              *
+ * We can use ModelAverage like this (Pseudocode):                              *
+ *                                                                              *
+ *   // One replica per worker, all with the same shape.                        *
+ *   vector<Model*> replicas = ... ;                                            *
+ *   ModelAverage average(replicas,                                             *
+ *                        sync_interval = 10, // average every 10 batches       *
+ *                        sparse_sync = true);                                  *
+ *                                                                              *
+ *   // Worker thread i:                                                        *
+ *   ReaderOptions options(loop = false);                                       *
+ *   Reader reader(shard_file[i], num_samples, LR, options);                    *
+ *   Loop until end of shard {                                                  *
+ *      DMatrix* matrix = reader.Samples();                                     *
+ *      loss.CalcGrad(matrix, *replicas[i], grad);                              *
+ *      updater[i].Update(grad);                                                *
+ *      average.Step(i, grad);  // blocks at the sync point                     *
+ *   }                                                                          *
+ *   average.Finish(i);                                                         *
+ *                                                                              *
+ * When sparse_sync is true, only the parameter blocks touched by some worker   *
+ * since the last sync are averaged. All the other blocks are still identical   *
+ * among the replicas, so the result is exactly the same as a full average.     *
+ *                                                                              *
+ * Several workers may also share a replica, e.g. one replica on each NUMA      *
+ * node for the workers of that node (see numa_util.h), and update it without   *
+ * locks between the syncs. Then replicas[i] is the replica of worker i, and    *
+ * a replica is weighted by the number of its workers in the average.           *
+ *                                                                              *
+ * A worker that runs out of data calls Finish(), which joins the next sync     *
+ * and then retires from the later ones. After the last worker finishes, all    *
+ * the replicas hold the same final model.                                      *
+ * -----------------------------------------------------------------------------
+ */
+class ModelAverage {
+ public:
+  // The parameters of replicas[0] are broadcast to the
+  // other replicas, so that all the workers start from
+  // the same model.
+  ModelAverage(const vector<Model*>& replicas,
+               int sync_interval,
+               bool sparse_sync = true);
+  ~ModelAverage() {}
+
+  // Record the positions updated by |grad| on the replica
+  // of |worker_id|, and average the replicas every
+  // |sync_interval| steps.
+  void Step(int worker_id, const SparseGrad& grad);
+
+  // Join the next sync and retire from the later ones.
+  void Finish(int worker_id);
+
+  // Get the number of syncs done so far.
+  uint64 GetNumberOfSyncs() const;
+
+ private:
+  vector<Model*> m_replicas;        // one replica for each worker.
+  int m_sync_interval;              // the number of batches between syncs.
+  bool m_sparse_sync;               // average touched blocks only.
+  index_t m_num_parameters;         // number of parameters of each replica.
+  index_t m_num_blocks;             // number of parameter blocks.
+
+  vector<vector<uint8> > m_dirty;   // touched blocks of each replica.
+  vector<uint64> m_steps;           // number of steps of each worker.
+  vector<uint8> m_retired;          // worker has called Finish().
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cond;
+  int m_active;                     // workers taking part in the syncs.
+  vector<int> m_arrived;            // workers waiting for current sync.
+  vector<bool> m_retiring;          // retire after current sync.
+  uint64 m_generation;              // number of syncs started.
+  int m_done;                       // workers finished current average.
+  uint64 m_done_generation;         // number of syncs finished.
+
+  // The state of current sync, which is written by the last
+  // arriving worker and read by all the workers of this sync.
+  vector<int> m_members;            // workers of current sync.
+  vector<index_t> m_blocks;         // blocks to be averaged.
+  bool m_final;                     // no worker is active after this sync.
+
+  // Wait for all the active workers and average their replicas.
+  void Sync(int worker_id, bool retire);
+  // Average the blocks in [m_blocks[begin], m_blocks[end]).
+  void AverageBlocks(index_t begin, index_t end);
+
+  DISALLOW_COPY_AND_ASSIGN(ModelAverage);
+};
+
+} // namespace f2m
+
+#endif // F2M_SOLVER_MODEL_AVERAGE_H_
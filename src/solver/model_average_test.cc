@@ -0,0 +1,161 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file tests model_average.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+
+#include "src/data/data_structure.h"
+#include "src/data/hyper_parameters.h"
+#include "src/data/model_parameters.h"
+#include "src/solver/model_average.h"
+
+using std::vector;
+
+namespace f2m {
+
+const index_t kFeatureNum = 10000;
+const int kNumWorkers = 4;
+const int kSyncInterval = 5;
+
+// Every step, worker |id| adds (id + 1) to one parameter.
+void Train(ModelAverage* average, Model* model,
+           int id, int num_steps) {
+  SparseGrad grad(1);
+  ParameterVector* param = model->GetParameter();
+  for (int s = 0; s < num_steps; ++s) {
+    index_t pos = (id * 7919 + s * 131) % (kFeatureNum + 1);
+    (*param)[pos] += id + 1;
+    grad.pos_w[0] = pos;
+    grad.size_w = 1;
+    average->Step(id, grad);
+  }
+  average->Finish(id);
+}
+
+void RunWorkers(vector<Model*>& replicas, bool sparse_sync,
+                const vector<int>& num_steps) {
+  ModelAverage average(replicas, kSyncInterval, sparse_sync);
+  vector<std::thread> threads;
+  for (int i = 0; i < kNumWorkers; ++i) {
+    threads.push_back(std::thread(Train, &average, replicas[i],
+                                  i, num_steps[i]));
+  }
+  for (int i = 0; i < kNumWorkers; ++i) {
+    threads[i].join();
+  }
+  EXPECT_GT(average.GetNumberOfSyncs(), 0);
+}
+
+void CheckSameReplicas(const vector<Model*>& replicas) {
+  ParameterVector* first = replicas[0]->GetParameter();
+  for (int i = 1; i < kNumWorkers; ++i) {
+    ParameterVector* param = replicas[i]->GetParameter();
+    for (index_t j = 0; j < first->size(); ++j) {
+      EXPECT_EQ((*first)[j], (*param)[j]);
+    }
+  }
+}
+
+class ModelAverageTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    F2M_PARAM hyperparam;
+    for (int i = 0; i < kNumWorkers; ++i) {
+      replicas.push_back(new Model(kFeatureNum, hyperparam));
+      ParameterVector* param = replicas[i]->GetParameter();
+      for (index_t j = 0; j < param->size(); ++j) {
+        (*param)[j] = i;
+      }
+    }
+  }
+  virtual void TearDown() {
+    for (int i = 0; i < kNumWorkers; ++i) {
+      delete replicas[i];
+    }
+  }
+  vector<Model*> replicas;
+};
+
+TEST_F(ModelAverageTest, Broadcast) {
+  ModelAverage average(replicas, kSyncInterval);
+  CheckSameReplicas(replicas);
+  EXPECT_EQ((*replicas[kNumWorkers-1]->GetParameter())[0], (real_t)0);
+}
+
+TEST_F(ModelAverageTest, SparseSync) {
+  vector<int> num_steps(kNumWorkers, 100);
+  RunWorkers(replicas, true, num_steps);
+  CheckSameReplicas(replicas);
+  // The average of the replicas is the initial model plus
+  // the sum of all the updates divided by the number of workers.
+  vector<real_t> expected(kFeatureNum + 1, 0);
+  for (int i = 0; i < kNumWorkers; ++i) {
+    for (int s = 0; s < num_steps[i]; ++s) {
+      expected[(i * 7919 + s * 131) % (kFeatureNum + 1)] += i + 1;
+    }
+  }
+  ParameterVector* param = replicas[0]->GetParameter();
+  for (index_t j = 0; j < param->size(); ++j) {
+    EXPECT_FLOAT_EQ((*param)[j], expected[j] / kNumWorkers);
+  }
+}
+
+TEST_F(ModelAverageTest, SparseEqualsDense) {
+  vector<int> num_steps(kNumWorkers, 100);
+  RunWorkers(replicas, true, num_steps);
+  ParameterVector sparse = *replicas[0]->GetParameter();
+  for (int i = 0; i < kNumWorkers; ++i) {
+    ParameterVector* param = replicas[i]->GetParameter();
+    for (index_t j = 0; j < param->size(); ++j) {
+      (*param)[j] = 0;
+    }
+  }
+  RunWorkers(replicas, false, num_steps);
+  ParameterVector* dense = replicas[0]->GetParameter();
+  for (index_t j = 0; j < dense->size(); ++j) {
+    EXPECT_FLOAT_EQ(sparse[j], (*dense)[j]);
+  }
+}
+
+TEST_F(ModelAverageTest, UnevenShards) {
+  // Workers run out of data at different steps.
+  vector<int> num_steps;
+  for (int i = 0; i < kNumWorkers; ++i) {
+    num_steps.push_back(23 + 17 * i);
+  }
+  RunWorkers(replicas, true, num_steps);
+  CheckSameReplicas(replicas);
+}
+
+TEST_F(ModelAverageTest, SharedReplicas) {
+  // Two replicas, each shared by two workers, as with one
+  // replica for each of two NUMA nodes.
+  vector<Model*> shared;
+  for (int i = 0; i < kNumWorkers; ++i) {
+    shared.push_back(replicas[i / 2 * 2]);
+  }
+  vector<int> num_steps(kNumWorkers, 100);
+  RunWorkers(shared, true, num_steps);
+  CheckSameReplicas(shared);
+}
+
+} // namespace f2m
@@ -0,0 +1,185 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file compares the placements of model parameters on a
+NUMA machine: all on one node, interleaved over all nodes, one
+replica per node shared by the workers of that node, and one
+replica per worker on its local node (see numa_util.h).
+
+Usage: numa_benchmark [num_workers] [num_features] [rows_per_worker] [epochs]
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "src/base/numa_util.h"
+#include "src/base/timer.h"
+#include "src/data/data_structure.h"
+#include "src/data/hyper_parameters.h"
+#include "src/data/model_parameters.h"
+#include "src/loss/logit_loss.h"
+#include "src/solver/model_average.h"
+#include "src/update/updater.h"
+
+using std::vector;
+using namespace f2m;
+
+const index_t kRowSize = 32;
+const index_t kBatchSize = 100;
+const int kSyncInterval = 10;
+
+enum Layout { SINGLE_NODE, INTERLEAVED, PER_NODE, PER_WORKER };
+const char* kLayoutName[] = { "single-node", "interleaved",
+                              "per-node", "per-worker" };
+
+struct Config {
+  int num_workers;
+  index_t num_features;
+  index_t rows_per_worker;
+  int epochs;
+};
+
+// Generate the data shard of a worker. The worker calls this after
+// it is pinned, so the shard is first touched on its local node.
+void MakeShard(int worker_id, const Config& config, DMatrix* shard) {
+  std::mt19937 rng(worker_id);
+  shard->resize(config.rows_per_worker);
+  shard->InitSparseRow();
+  for (index_t i = 0; i < shard->row_size; ++i) {
+    SparseRow* row = shard->row[i];
+    row->resize(kRowSize);
+    for (index_t j = 0; j < kRowSize; ++j) {
+      row->idx[j] = rng() % config.num_features;
+      row->X[j] = 1.0;
+    }
+    shard->Y[i] = (rng() % 2) ? 1 : -1;
+  }
+}
+
+void Worker(int worker_id, const Config& config, Model* model,
+            ModelAverage* average, std::atomic<int>* ready,
+            std::atomic<bool>* start) {
+  PinThreadToNumaNode(NumaNodeOfWorker(worker_id));
+  DMatrix shard;
+  MakeShard(worker_id, config, &shard);
+  LogitLoss loss(NONE);
+  Updater updater(model, 0.01, 0, NONE);
+  SparseGrad grad;
+  DMatrix batch(kBatchSize);
+  ready->fetch_add(1);
+  while (!start->load()) std::this_thread::yield();
+  for (int e = 0; e < config.epochs; ++e) {
+    for (index_t i = 0; i + kBatchSize <= shard.row_size; i += kBatchSize) {
+      for (index_t j = 0; j < kBatchSize; ++j) {
+        batch.row[j] = shard.row[i + j];
+        batch.Y[j] = shard.Y[i + j];
+      }
+      loss.CalcGrad(&batch, *model, grad);
+      updater.Update(grad);
+      if (average != NULL) {
+        average->Step(worker_id, grad);
+      }
+    }
+  }
+  if (average != NULL) {
+    average->Finish(worker_id);
+  }
+}
+
+// Return the number of rows per second.
+double Run(Layout layout, const Config& config) {
+  F2M_PARAM hyperparam;
+  hyperparam.learning_rate = 0.01;
+  hyperparam.regu_lambda = 0;
+  hyperparam.regu_type = NONE;
+  // The models to delete, and the model of each worker.
+  vector<Model*> replicas;
+  vector<Model*> models;
+  ModelAverage* average = NULL;
+  if (layout == PER_NODE || layout == PER_WORKER) {
+    int num_replicas = layout == PER_NODE ?
+                       std::min(NumaNodes(), config.num_workers) :
+                       config.num_workers;
+    for (int i = 0; i < num_replicas; ++i) {
+      replicas.push_back(new Model(config.num_features, hyperparam));
+      replicas[i]->BindToNumaNode(NumaNodeOfWorker(i));
+    }
+    // The workers of a node share the replica of the node (Hogwild),
+    // and worker i runs on the node of replica i % num_replicas.
+    for (int i = 0; i < config.num_workers; ++i) {
+      models.push_back(replicas[i % num_replicas]);
+    }
+    average = new ModelAverage(models, kSyncInterval);
+  } else {
+    Model* model = new Model(config.num_features, hyperparam);
+    if (layout == SINGLE_NODE) {
+      model->BindToNumaNode(0);
+    } else {
+      model->InterleaveOnNumaNodes();
+    }
+    // All the workers update the shared model (Hogwild).
+    replicas.push_back(model);
+    models.assign(config.num_workers, model);
+  }
+  std::atomic<int> ready(0);
+  std::atomic<bool> start(false);
+  vector<std::thread> threads;
+  for (int i = 0; i < config.num_workers; ++i) {
+    threads.push_back(std::thread(Worker, i, config, models[i],
+                                  average, &ready, &start));
+  }
+  while (ready.load() < config.num_workers) std::this_thread::yield();
+  Timer timer;
+  start.store(true);
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+  double seconds = timer.Elapsed();
+  delete average;
+  for (size_t i = 0; i < replicas.size(); ++i) {
+    delete replicas[i];
+  }
+  double rows = static_cast<double>(config.rows_per_worker) *
+                config.epochs * config.num_workers;
+  return rows / seconds;
+}
+
+int main(int argc, char* argv[]) {
+  Config config;
+  config.num_workers = argc > 1 ? atoi(argv[1]) :
+                       std::thread::hardware_concurrency();
+  config.num_features = argc > 2 ? atol(argv[2]) : 10000000;
+  config.rows_per_worker = argc > 3 ? atol(argv[3]) : 100000;
+  config.epochs = argc > 4 ? atoi(argv[4]) : 5;
+  if (config.num_workers <= 0) config.num_workers = 1;
+  printf("nodes = %d, workers = %d, features = %u, "
+         "rows per worker = %u, epochs = %d\n",
+         NumaNodes(), config.num_workers, config.num_features,
+         config.rows_per_worker, config.epochs);
+  printf("%-12s %14s\n", "layout", "rows/sec");
+  for (int layout = SINGLE_NODE; layout <= PER_WORKER; ++layout) {
+    double rate = Run(static_cast<Layout>(layout), config);
+    printf("%-12s %14.0f\n", kLayoutName[layout], rate);
+  }
+  return 0;
+}
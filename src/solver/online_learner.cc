@@ -0,0 +1,175 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file is the implementation of online_learner.h
+*/
+
+#include "src/solver/online_learner.h"
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/base/profiler.h"
+#include "src/base/timer.h"
+
+using std::string;
+using std::vector;
+
+namespace f2m {
+
+OnlineLearner::OnlineLearner(Reader* reader,
+                             Loss* loss,
+                             Updater* updater,
+                             Model* model,
+                             uint64 report_interval,
+                             uint64 checkpoint_interval,
+                             const string& checkpoint_file)
+  : m_reader(reader),
+    m_loss(loss),
+    m_updater(updater),
+    m_model(model),
+    m_report_interval(report_interval),
+    m_checkpoint_interval(checkpoint_interval),
+    m_checkpoint_file(checkpoint_file),
+    m_validator(NULL),
+    m_validation_interval(0),
+    m_total_loss(0),
+    m_total_rows(0),
+    m_grad(model->GetModelType()) {
+  CHECK_NOTNULL(m_reader);
+  CHECK_NOTNULL(m_loss);
+  CHECK_NOTNULL(m_updater);
+  CHECK_NOTNULL(m_model);
+  CHECK_GT(m_report_interval, 0);
+  if (m_checkpoint_interval > 0) {
+    CHECK_NE(m_checkpoint_file.empty(), true);
+  }
+}
+
+uint64 OnlineLearner::Run() {
+  Timer timer;
+  double window_loss = 0;
+  uint64 window_rows = 0;
+  uint64 next_checkpoint = m_checkpoint_interval;
+  uint64 next_validation = m_validation_interval;
+  uint32 epoch = m_reader->GetNumberOfEpochs();
+  bool early_stop = false;
+  for (;;) {
+    DMatrix* matrix = m_reader->Samples();
+    // A reader that loops over a file also tells the epochs.
+    if (m_reader->GetNumberOfEpochs() != epoch) {
+      epoch = m_reader->GetNumberOfEpochs();
+      F2M_PROFILE_DUMP("epoch " + std::to_string(epoch));
+    }
+    // End of the stream.
+    if (matrix->row_size == 0) break;
+    // Progressive validation: predict the batch before
+    // the model is trained on it. The predictions come
+    // with the gradients from the same pass over the model.
+    m_loss->PredictAndCalcGrad(matrix, *m_model, m_pred, m_grad);
+    double batch_loss = m_loss->Evaluate(m_pred, matrix->Y) *
+                        matrix->row_size;
+    m_updater->Update(m_grad);
+    m_total_loss += batch_loss;
+    m_total_rows += matrix->row_size;
+    window_loss += batch_loss;
+    window_rows += matrix->row_size;
+    if (window_rows >= m_report_interval) {
+      double seconds = timer.Elapsed();
+      LOG(INFO) << "rows: " << m_total_rows
+                << " rolling logloss: " << window_loss / window_rows
+                << " progressive logloss: " << GetProgressiveLoss()
+                << " rows/sec: " << window_rows / seconds;
+      // A stream has no epoch, so we also log the profile of every window.
+      F2M_PROFILE_DUMP("last " + std::to_string(window_rows) + " rows");
+      window_loss = 0;
+      window_rows = 0;
+      timer.Reset();
+    }
+    if (m_checkpoint_interval > 0 && m_total_rows >= next_checkpoint) {
+      Checkpoint();
+      next_checkpoint = m_total_rows + m_checkpoint_interval;
+    }
+    if (m_validator != NULL) {
+      // Decide before submitting, so that no snapshot
+      // is taken after the decision.
+      if (m_validator->ShouldStop()) {
+        early_stop = true;
+        break;
+      }
+      // The validator may still be busy with the last snapshot,
+      // then we try again after the next batch.
+      if (m_total_rows >= next_validation &&
+          m_validator->Submit(*m_model, m_total_rows)) {
+        next_validation = m_total_rows + m_validation_interval;
+      }
+    }
+  }
+  LOG(INFO) << (early_stop ? "Validation stopped improving." :
+                             "End of stream.")
+            << " rows: " << m_total_rows
+            << " progressive logloss: " << GetProgressiveLoss();
+  if (m_validator != NULL) {
+    m_validator->Wait();
+    if (m_validator->RestoreBest(m_model)) {
+      LOG(INFO) << "Restored the best model at row "
+                << m_validator->GetBestStep() << ", validation logloss: "
+                << m_validator->GetBestResult().logloss;
+    }
+  }
+  if (!m_checkpoint_file.empty()) {
+    Checkpoint();
+  }
+  return m_total_rows;
+}
+
+void OnlineLearner::Reserve(const DataStats& stats) {
+  // The losses do not check the ids, so a model
+  // too small for the data is indexed out of bounds.
+  CHECK_LE(stats.GetNumberOfFeatures(), m_model->GetNumberOfFeatures());
+  if (m_model->GetModelType() == FFM) {
+    CHECK_LE(stats.GetNumberOfFields(), m_model->GetNumberOfFields());
+  }
+  uint64 num_w = 0, num_v = 0;
+  stats.GetGradCapacity(m_model->GetModelType(),
+                        m_model->GetSizeOfVector(),
+                        m_reader->GetNumberOfSamples(),
+                        &num_w, &num_v);
+  m_grad.reserve(num_w, num_v);
+}
+
+void OnlineLearner::SetValidator(Validator* validator, uint64 interval) {
+  CHECK_NOTNULL(validator);
+  CHECK_GT(interval, 0);
+  m_validator = validator;
+  m_validation_interval = interval;
+}
+
+void OnlineLearner::Checkpoint() {
+  CHECK_NE(m_checkpoint_file.empty(), true);
+  string tmp_file = m_checkpoint_file + ".tmp";
+  m_model->SaveModel(tmp_file);
+  if (rename(tmp_file.c_str(), m_checkpoint_file.c_str()) != 0) {
+    LOG(FATAL) << "Cannot rename " << tmp_file
+               << " to " << m_checkpoint_file;
+  }
+}
+
+} // namespace f2m
@@ -0,0 +1,128 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                     *
+ *                                                                              *
+ * Licensed under the Apache License, Version 2.0 (the "License");              *
+ * you may not use this file except in compliance with the License.             *
+ * You may obtain a copy of the License at                                      *
+ *                                                                              *
+ *     http://www.apache.org/licenses/LICENSE-2.0                               *
+ *                                                                              *
+ *  Unless required by applicable law or agreed to in writing, software         *
+ *  distributed under the License is distributed on an "AS IS" BASIS,           *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ *  See the License for the specific language governing permissions and         *
+ *  limitations under the License.                                              *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file defines OnlineLearner, which trains a model on an
+unbounded input stream with progressive validation.
+*/
+
+#ifndef F2M_SOLVER_ONLINE_LEARNER_H_
+#define F2M_SOLVER_ONLINE_LEARNER_H_
+
+#include <string>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/data/data_structure.h"
+#include "src/data/model_parameters.h"
+#include "src/loss/loss.h"
+#include "src/reader/data_scanner.h"
+#include "src/reader/reader.h"
+#include "src/solver/validator.h"
+#include "src/update/updater.h"
+
+using std::string;
+using std::vector;
+
+namespace f2m {
+
+/* -----------------------------------------------------------------------------
+ * OnlineLearner keeps a model fresh by training it directly on a stream, such  *
+ * as the stdin or a named pipe fed by a log shipper:                           *
+ *                                                                              *
+ *   ReaderOptions options(loop = false);                                       *
+ *   Reader reader("-", num_samples = 100, LR, options);                        *
+ *   OnlineLearner learner(&reader, &loss, &updater, &model,                    *
+ *                         report_interval = 100000,                            *
+ *                         checkpoint_interval = 10000000,                      *
+ *                         checkpoint_file = "/data/model.bin");                *
+ *   learner.Run();  // returns when the stream is closed.                      *
+ *                                                                              *
+ * Every batch is first predicted and then used to update the model, so the     *
+ * loss is always measured on examples the model has not been trained on        *
+ * (progressive validation). Every report_interval rows, the learner logs the   *
+ * logloss of these rows, the progressive logloss since the beginning and the   *
+ * throughput. Every checkpoint_interval rows, the model is saved to            *
+ * checkpoint_file. The checkpoint is written to a temporary file and then      *
+ * renamed, so a reader of the checkpoint never sees a half-written model.      *
+ *                                                                              *
+ * With SetValidator(), a snapshot of the model is validated on a held-out set  *
+ * every validation_interval rows, in the background (see validator.h). The     *
+ * learner stops once the validation loss stops improving, even if the stream   *
+ * goes on, e.g., a file read in a loop. At the end, the learner restores the   *
+ * best snapshot, so the last checkpoint holds the best model.                  *
+ *                                                                              *
+ * A stream cannot be scanned, but a file read in a loop can. Then Reserve()    *
+ * checks the model against the stats of ScanData() and sizes the gradient of   *
+ * the batches once, so that it does not grow while training:                   *
+ *                                                                              *
+ *   learner.Reserve(ScanData(filename, model_type));                           *
+ * -----------------------------------------------------------------------------
+ */
+class OnlineLearner {
+ public:
+  OnlineLearner(Reader* reader,
+                Loss* loss,
+                Updater* updater,
+                Model* model,
+                uint64 report_interval = 100000,
+                uint64 checkpoint_interval = 0, // 0 for no checkpoint.
+                const string& checkpoint_file = "");
+  ~OnlineLearner() {}
+
+  // Train until the end of the input stream.
+  // Return the number of rows we have seen.
+  uint64 Run();
+
+  // Get the mean progressive logloss of all the rows.
+  real_t GetProgressiveLoss() const {
+    return m_total_rows > 0 ? m_total_loss / m_total_rows : 0;
+  }
+
+  // Save current model to the checkpoint file.
+  void Checkpoint();
+
+  // Check that the model holds every feature and field of
+  // |stats|, and reserve the gradient of the largest batch.
+  void Reserve(const DataStats& stats);
+
+  // Validate a snapshot every |interval| rows, and stop
+  // training with the best snapshot when |validator| says so.
+  void SetValidator(Validator* validator, uint64 interval);
+
+ private:
+  Reader* m_reader;                 // read data samples from the stream.
+  Loss* m_loss;                     // predict and calculate the gradient.
+  Updater* m_updater;               // update the model.
+  Model* m_model;                   // the model to be trained.
+  uint64 m_report_interval;         // rows between two reports.
+  uint64 m_checkpoint_interval;     // rows between two checkpoints.
+  string m_checkpoint_file;         // save model to this file.
+  Validator* m_validator;           // NULL for no validation.
+  uint64 m_validation_interval;     // rows between two validations.
+
+  double m_total_loss;              // sum of the logloss of all rows.
+  uint64 m_total_rows;              // number of rows we have seen.
+
+  vector<real_t> m_pred;            // prediction of current batch.
+  SparseGrad m_grad;                // gradient of current batch.
+
+  DISALLOW_COPY_AND_ASSIGN(OnlineLearner);
+};
+
+} // namespace f2m
+
+#endif // F2M_SOLVER_ONLINE_LEARNER_H_
@@ -0,0 +1,136 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+
+/*
+This file tests online_learner.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/base/file_util.h"
+#include "src/data/data_structure.h"
+#include "src/data/hyper_parameters.h"
+#include "src/data/model_parameters.h"
+#include "src/loss/logit_loss.h"
+#include "src/reader/data_scanner.h"
+#include "src/reader/reader.h"
+#include "src/solver/online_learner.h"
+#include "src/solver/validator.h"
+#include "src/update/SGD_updater.h"
+
+using std::string;
+using std::vector;
+
+namespace f2m {
+
+const string kFifoName = "/tmp/test_online_learner.fifo";
+const string kCheckpointFile = "/tmp/test_online_learner.model";
+const string kPositive = "1\t1:1\n";
+const string kNegative = "-1\t2:1\n";
+const index_t kNumLines = 10000;
+
+// Feed the named pipe like a log shipper does.
+void WriteStream() {
+  FILE* file = OpenFileOrDie(kFifoName.c_str(), "w");
+  for (index_t i = 0; i < kNumLines; ++i) {
+    const string& line = (i % 2 == 0) ? kPositive : kNegative;
+    fwrite(line.c_str(), 1, line.size(), file);
+  }
+  Close(file);
+}
+
+TEST(OnlineLearnerTest, TrainFromPipe) {
+  unlink(kFifoName.c_str());
+  ASSERT_EQ(mkfifo(kFifoName.c_str(), 0600), 0);
+  std::thread writer(WriteStream);
+  F2M_PARAM hyperparam;
+  hyperparam.learning_rate = 0.1;
+  hyperparam.regu_lambda = 0;
+  hyperparam.regu_type = NONE;
+  Model model(2, hyperparam);
+  LogitLoss loss(NONE);
+  SGD_updater updater(&model, 0.1, 0, NONE);
+  Reader reader(kFifoName, 10, LR, false);
+  EXPECT_TRUE(reader.IsStream());
+  OnlineLearner learner(&reader, &loss, &updater, &model,
+                        1000, 1000, kCheckpointFile);
+  EXPECT_EQ(learner.Run(), kNumLines);
+  writer.join();
+  unlink(kFifoName.c_str());
+  // The model predicts every negative example as positive
+  // at the beginning, so the loss must go down.
+  EXPECT_LT(learner.GetProgressiveLoss(), 0.2);
+  // The last checkpoint holds the final model.
+  Model checkpoint(2, hyperparam);
+  checkpoint.LoadModel(kCheckpointFile);
+  ParameterVector* expected = model.GetParameter();
+  ParameterVector* actual = checkpoint.GetParameter();
+  for (index_t i = 0; i < expected->size(); ++i) {
+    EXPECT_EQ((*expected)[i], (*actual)[i]);
+  }
+}
+
+// 70% of the examples are positive.
+void WriteNoisyData(const string& filename, index_t num_lines) {
+  FILE* file = OpenFileOrDie(filename.c_str(), "w");
+  for (index_t i = 0; i < num_lines; ++i) {
+    fprintf(file, "%d\t1:1\n", i % 10 < 7 ? 1 : -1);
+  }
+  Close(file);
+}
+
+TEST(OnlineLearnerTest, EarlyStopping) {
+  const string kTrainFile = "/tmp/test_online_learner_train.txt";
+  const string kValidFile = "/tmp/test_online_learner_valid.txt";
+  WriteNoisyData(kTrainFile, 1000);
+  WriteNoisyData(kValidFile, 1000);
+  F2M_PARAM hyperparam;
+  hyperparam.learning_rate = 0.1;
+  hyperparam.regu_lambda = 0;
+  hyperparam.regu_type = NONE;
+  Model model(2, hyperparam);
+  LogitLoss loss(NONE);
+  SGD_updater updater(&model, 0.1, 0, NONE);
+  // The training data never ends, so only the validation can stop it.
+  Reader reader(kTrainFile, 10, LR, true);
+  Reader valid_reader(kValidFile, 100, LR, false, true);
+  LogitLoss valid_loss(NONE);
+  Validator validator(&valid_reader, &valid_loss, model, 3, 1e-3);
+  OnlineLearner learner(&reader, &loss, &updater, &model, 1000);
+  // A file can be scanned to size the gradient.
+  learner.Reserve(ScanData(kTrainFile, LR));
+  learner.SetValidator(&validator, 1000);
+  EXPECT_GT(learner.Run(), 0);
+  EXPECT_TRUE(validator.ShouldStop());
+  EXPECT_GE(validator.GetNumberOfValidations(), 4);
+  // The model is restored to the best snapshot.
+  MetricResult best = validator.GetBestResult();
+  real_t prob = 1.0 / (1.0 + exp(-(*model.GetParameter())[1]));
+  EXPECT_NEAR(-0.7 * log(prob) - 0.3 * log(1 - prob), best.logloss, 1e-4);
+  unlink(kTrainFile.c_str());
+  unlink(kValidFile.c_str());
+}
+
+} // namespace f2m
@@ -0,0 +1,200 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file is the implementation of validator.h
+*/
+
+#include "src/solver/validator.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "src/base/common.h"
+#include "src/base/profiler.h"
+#include "src/base/timer.h"
+
+namespace f2m {
+
+// Return an uninitialized model of the same shape as |model|.
+static Model* NewSnapshot(Model& model) {
+  F2M_PARAM hyperparam;
+  hyperparam.learning_rate = 0;
+  hyperparam.regu_lambda = model.GetLambda();
+  hyperparam.regu_type = NONE;
+  return new Model(model.GetNumberOfFeatures(), hyperparam,
+                   model.GetModelType(), model.GetSizeOfVector(),
+                   model.GetNumberOfFields(), false);
+}
+
+// Copy the parameters of |src| into |dst|.
+static void CopyParameters(Model& src, Model* dst) {
+  CHECK_EQ(src.GetNumberOfParameters(), dst->GetNumberOfParameters());
+  memcpy(dst->GetParameter()->data(), src.GetParameter()->data(),
+         src.GetNumberOfParameters() * sizeof(real_t));
+}
+
+Validator::Validator(Reader* reader,
+                     Loss* loss,
+                     Model& model,
+                     int patience,
+                     real_t min_delta)
+  : m_reader(reader),
+    m_loss(loss),
+    // The training threads need the cores more.
+    m_metric(1),
+    m_patience(patience),
+    m_min_delta(min_delta),
+    m_pending(false),
+    m_stop(false),
+    m_step(0),
+    m_num_validations(0),
+    m_best_step(0),
+    m_num_bad(0) {
+  CHECK_NOTNULL(m_reader);
+  CHECK_NOTNULL(m_loss);
+  CHECK_GT(m_patience, 0);
+  CHECK_GE(m_min_delta, 0);
+  memset(&m_best_result, 0, sizeof(m_best_result));
+  m_snapshot = NewSnapshot(model);
+  m_best = NewSnapshot(model);
+  m_thread = std::thread(&Validator::Run, this);
+}
+
+Validator::~Validator() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cond.notify_all();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+  delete m_snapshot;
+  delete m_best;
+}
+
+bool Validator::Submit(Model& model, uint64 step) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Once stopped, the best snapshot is final.
+    if (m_pending || m_num_bad >= m_patience) return false;
+  }
+  // The validation thread does not touch m_snapshot
+  // until m_pending is set.
+  CopyParameters(model, m_snapshot);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_step = step;
+    m_pending = true;
+  }
+  m_cond.notify_all();
+  return true;
+}
+
+void Validator::Wait() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_cond.wait(lock, [this] { return !m_pending; });
+}
+
+bool Validator::ShouldStop() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_num_bad >= m_patience;
+}
+
+bool Validator::RestoreBest(Model* model) {
+  CHECK_NOTNULL(model);
+  // m_best is swapped under the lock.
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_num_validations == 0) return false;
+  CopyParameters(*m_best, model);
+  return true;
+}
+
+uint64 Validator::GetNumberOfValidations() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_num_validations;
+}
+
+uint64 Validator::GetBestStep() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_best_step;
+}
+
+MetricResult Validator::GetBestResult() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_best_result;
+}
+
+void Validator::Run() {
+  // Validation is not a part of the training profile.
+  ExcludeThreadFromProfile();
+  for (;;) {
+    uint64 step = 0;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cond.wait(lock, [this] { return m_stop || m_pending; });
+      if (m_stop) return;
+      step = m_step;
+    }
+    // Validate without holding the lock.
+    Timer timer;
+    MetricResult result = Validate();
+    bool improved = false;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      improved = m_num_validations == 0 ||
+                 result.logloss < m_best_result.logloss - m_min_delta;
+      if (m_num_bad >= m_patience) {
+        // Submit() refuses snapshots after the stop, but
+        // be sure that the stop is never taken back.
+        improved = false;
+      } else if (improved) {
+        std::swap(m_snapshot, m_best);
+        m_best_step = step;
+        m_best_result = result;
+        m_num_bad = 0;
+      } else {
+        m_num_bad++;
+      }
+      m_num_validations++;
+      m_pending = false;
+    }
+    m_cond.notify_all();
+    LOG(INFO) << "validation step: " << step
+              << " logloss: " << result.logloss
+              << " auc: " << result.auc
+              << (improved ? " (best)" : "")
+              << " seconds: " << timer.Elapsed();
+  }
+}
+
+MetricResult Validator::Validate() {
+  m_metric.Reset();
+  for (;;) {
+    DMatrix* matrix = m_reader->Samples();
+    if (matrix->row_size == 0) break;
+    m_pred.resize(matrix->row_size);
+    m_loss->Predict(matrix, *m_snapshot, m_pred);
+    m_metric.Add(m_pred, matrix->Y);
+  }
+  m_reader->Restart();
+  MetricResult result = m_metric.Result();
+  CHECK_GT(result.count, 0);
+  return result;
+}
+
+} // namespace f2m
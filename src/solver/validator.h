@@ -0,0 +1,143 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file defines Validator, which validates snapshots of a model
+on a background thread and decides when training should stop.
+*/
+
+#ifndef F2M_SOLVER_VALIDATOR_H_
+#define F2M_SOLVER_VALIDATOR_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "src/base/common.h"
+#include "src/data/data_structure.h"
+#include "src/data/model_parameters.h"
+#include "src/loss/loss.h"
+#include "src/loss/metric.h"
+#include "src/reader/reader.h"
+
+using std::vector;
+
+namespace f2m {
+
+/* -----------------------------------------------------------------------------
+ * Validator scores a held-out data set without stalling the training:          *
+ *                                                                              *
+ *   ReaderOptions options(loop = false, in_memory = true);                     *
+ *   Reader valid_reader(valid_file, num_samples, LR, options);                 *
+ *   LogitLoss valid_loss(NONE);  // not shared with the trainer.               *
+ *   Validator validator(&valid_reader, &valid_loss, model,                     *
+ *                       patience = 3, min_delta = 1e-4);                       *
+ *   Loop {                                                                     *
+ *     ... train the model on a few batches ...                                 *
+ *     validator.Submit(model, step);                                           *
+ *     if (validator.ShouldStop()) break;                                       *
+ *   }                                                                          *
+ *   validator.Wait();                                                          *
+ *   validator.RestoreBest(&model);                                             *
+ *                                                                              *
+ * Submit() copies the parameters into a snapshot, which is then predicted by   *
+ * the validation thread with Loss::Predict over one pass of the reader, and    *
+ * scored by Metric. The trainer keeps on updating its own model meanwhile. If  *
+ * the last snapshot is still being validated, Submit() returns false at once,  *
+ * and the trainer simply tries again later.                                    *
+ *                                                                              *
+ * A snapshot improves if its logloss is lower than the best one by more than   *
+ * min_delta. The validator keeps the best snapshot, and ShouldStop() returns   *
+ * true after patience snapshots in a row did not improve. The stop is final:   *
+ * Submit() refuses any later snapshot, so ShouldStop() and the best snapshot   *
+ * do not change after the trainer decided to stop. The best and the next       *
+ * snapshot trade places instead of being copied, so the validator holds two    *
+ * copies of the model and copies the parameters once per Submit().             *
+ *                                                                              *
+ * The validation reader must not loop, because one pass of it is one           *
+ * validation, and the loss must not be used by any other thread.               *
+ * -----------------------------------------------------------------------------
+ */
+class Validator {
+ public:
+  // |model| gives the shape of the snapshots.
+  Validator(Reader* reader,
+            Loss* loss,
+            Model& model,
+            int patience = 3,
+            real_t min_delta = 0);
+  ~Validator();
+
+  // Hand a snapshot of |model| over to the validation thread.
+  // |step| identifies the snapshot, e.g., the number of rows
+  // the model has been trained on. Return false without
+  // copying if the last snapshot is still being validated,
+  // or if ShouldStop() is already true.
+  bool Submit(Model& model, uint64 step);
+
+  // Wait until the last snapshot is validated.
+  void Wait();
+
+  // Return true if the last |patience| snapshots did not
+  // improve on the best one. Once true, it stays true.
+  bool ShouldStop();
+
+  // Copy the best snapshot into |model|.
+  // Return false if no snapshot has been validated.
+  bool RestoreBest(Model* model);
+
+  // Get the number of validated snapshots.
+  uint64 GetNumberOfValidations();
+
+  // Get the step and the metrics of the best snapshot.
+  uint64 GetBestStep();
+  MetricResult GetBestResult();
+
+ private:
+  Reader* m_reader;                 // the validation data.
+  Loss* m_loss;                     // predict the validation data.
+  Metric m_metric;                  // score the predictions.
+  int m_patience;                   // snapshots without improvement.
+  real_t m_min_delta;               // the least improvement of logloss.
+
+  Model* m_snapshot;                // the snapshot to be validated.
+  Model* m_best;                    // the best snapshot so far.
+  vector<real_t> m_pred;            // predictions of current batch.
+
+  std::thread m_thread;             // the validation thread.
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  bool m_pending;                   // m_snapshot is not validated yet.
+  bool m_stop;                      // ask the thread to quit.
+  uint64 m_step;                    // step of m_snapshot.
+
+  // The results, which are guarded by m_mutex.
+  uint64 m_num_validations;         // number of validated snapshots.
+  uint64 m_best_step;               // step of m_best.
+  MetricResult m_best_result;       // metrics of m_best.
+  int m_num_bad;                    // snapshots since the best one.
+
+  // Main loop of the validation thread.
+  void Run();
+  // Score m_snapshot on one pass of the reader.
+  MetricResult Validate();
+
+  DISALLOW_COPY_AND_ASSIGN(Validator);
+};
+
+} // namespace f2m
+
+#endif // F2M_SOLVER_VALIDATOR_H_
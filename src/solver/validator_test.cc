@@ -0,0 +1,88 @@
+/* -------------------------------------------------------------------------- *
+ * Copyright (c) 2016 by contributors. All Rights Reserved.                   *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ *  Unless required by applicable law or agreed to in writing, software       *
+ *  distributed under the License is distributed on an "AS IS" BASIS,         *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+ *  See the License for the specific language governing permissions and       *
+ *  limitations under the License.                                            *
+ * -------------------------------------------------------------------------- */
+/*
+This file tests validator.h
+*/
+
+#include "gtest/gtest.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "src/base/file_util.h"
+#include "src/data/data_structure.h"
+#include "src/data/hyper_parameters.h"
+#include "src/data/model_parameters.h"
+#include "src/loss/logit_loss.h"
+#include "src/reader/reader.h"
+#include "src/solver/validator.h"
+
+using std::string;
+
+namespace f2m {
+
+const string kValidFile = "/tmp/test_validator.txt";
+const index_t kNumLines = 1000;
+
+// 70% of the examples are positive.
+void WriteValidationData() {
+  FILE* file = OpenFileOrDie(kValidFile.c_str(), "w");
+  for (index_t i = 0; i < kNumLines; ++i) {
+    fprintf(file, "%d\t1:1\n", i % 10 < 7 ? 1 : -1);
+  }
+  Close(file);
+}
+
+TEST(ValidatorTest, KeepsTheBestSnapshot) {
+  WriteValidationData();
+  F2M_PARAM hyperparam;
+  hyperparam.learning_rate = 0.1;
+  hyperparam.regu_lambda = 0;
+  hyperparam.regu_type = NONE;
+  Model model(2, hyperparam);
+  real_t* w = model.GetParameter()->data();
+  Reader reader(kValidFile, 100, LR, false, true);
+  LogitLoss loss(NONE);
+  Validator validator(&reader, &loss, model, 2);
+  EXPECT_FALSE(validator.RestoreBest(&model));
+  // The best weight is log(0.7 / 0.3).
+  const real_t kWeights[] = { 0.5, log(0.7 / 0.3), 0.6, 2.0 };
+  for (int i = 0; i < 4; ++i) {
+    w[1] = kWeights[i];
+    EXPECT_TRUE(validator.Submit(model, i));
+    validator.Wait();
+    EXPECT_EQ(validator.ShouldStop(), i == 3);
+  }
+  // The stop is final, even for a snapshot as good as the best.
+  w[1] = kWeights[1];
+  EXPECT_FALSE(validator.Submit(model, 4));
+  EXPECT_TRUE(validator.ShouldStop());
+  EXPECT_EQ(validator.GetNumberOfValidations(), 4);
+  EXPECT_EQ(validator.GetBestStep(), 1);
+  MetricResult best = validator.GetBestResult();
+  EXPECT_EQ(best.count, kNumLines);
+  // The entropy of the labels.
+  EXPECT_NEAR(best.logloss, -0.7 * log(0.7) - 0.3 * log(0.3), 1e-4);
+  // The model has been changed since, and is restored.
+  EXPECT_TRUE(validator.RestoreBest(&model));
+  EXPECT_FLOAT_EQ(w[1], kWeights[1]);
+  unlink(kValidFile.c_str());
+}
+
+} // namespace f2m
@@ -22,6 +22,7 @@
 #include "src/update/AdaGrad_updater.h"
 
 #include "src/base/common.h"
+#include "src/base/profiler.h"
 #include "src/data/data_structure.h"
 #include "cmath"                      // for sqrt()
 
@@ -45,6 +46,10 @@ AdaGrad_updater::AdaGrad_updater(Model* model,
       
       try {
          m_g_parameters.resize(model->GetNumberOfParameters(), m_ada_epsilon);
+         LOG(INFO) << "AdaGrad states take "
+                   << (m_g_parameters.size() * sizeof(real_t) >> 20) << " MB on "
+                   << PageBackingName(PageBackingOf(m_g_parameters.data()))
+                   << ".";
       }
       catch (std::bad_alloc&) {
          LOG(FATAL) << "Cannot allocate enough memory for \
@@ -53,7 +58,9 @@ AdaGrad_updater::AdaGrad_updater(Model* model,
    }
    
 void AdaGrad_updater::Update(const SparseGrad& grad) {
-   vector<real_t>* param = m_model->GetParameter();
+   F2M_PROFILE_SCOPE(PROFILE_UPDATE);
+   F2M_PROFILE_COUNT(PROFILE_UPDATE, 0, grad.size_w + grad.size_v, 0);
+   ParameterVector* param = m_model->GetParameter();
    CHECK_NOTNULL(param);
    ModelType type = m_model->GetModelType();
    if (type == LR || type == FM || type == FFM) {
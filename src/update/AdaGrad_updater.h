@@ -29,7 +29,7 @@
 #include "src/data/data_structure.h"
 
 namespace f2m {
-class AdaGrad_updater : private Updater {
+class AdaGrad_updater : public Updater {
  public:
    AdaGrad_updater(Model* model,
                    real_t learning_rate,
@@ -42,7 +42,7 @@ class AdaGrad_updater : private Updater {
    void Update(const SparseGrad& grad);
    
  private:
-   vector<real_t> m_g_parameters;      // store the sum of squares of gradients
+   ParameterVector m_g_parameters;     // store the sum of squares of gradients
    real_t m_ada_eta;                   // learning rate in AdaGrad
    real_t m_ada_epsilon;               // initial value of m_g_parameters
 
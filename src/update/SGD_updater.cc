@@ -22,11 +22,14 @@
 #include "src/update/SGD_updater.h"
 
 #include "src/base/common.h"
+#include "src/base/profiler.h"
 #include "src/data/data_structure.h"
 
 namespace f2m {
 void SGD_updater::Update(const SparseGrad& grad) {
-   vector<real_t>* param = m_model->GetParameter();
+   F2M_PROFILE_SCOPE(PROFILE_UPDATE);
+   F2M_PROFILE_COUNT(PROFILE_UPDATE, 0, grad.size_w + grad.size_v, 0);
+   ParameterVector* param = m_model->GetParameter();
    CHECK_NOTNULL(param);
    ModelType type = m_model->GetModelType();
    if (type == LR || type == FM || type ==  FFM) {
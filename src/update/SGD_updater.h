@@ -29,7 +29,7 @@ This file defines SGD_updater, which implements "updater"
 #include "src/data/data_structure.h"
 
 namespace f2m{
-class SGD_updater : private Updater {
+class SGD_updater : public Updater {
  public:
    SGD_updater(Model* model,
                real_t learning_rate,
@@ -23,16 +23,24 @@ This files implement updater.h
 #include "src/update/updater.h"
 
 #include "src/base/common.h"
+#include "src/base/profiler.h"
 #include "src/data/data_structure.h"
 
 namespace f2m {
 
 // Using simple SGD by defualt.
 void Updater::Update(const SparseGrad& grad) {
-  vector<real_t>* param = m_model->GetParameter();
-  if (m_model->GetModelType() == LR) {
-      
+  F2M_PROFILE_SCOPE(PROFILE_UPDATE);
+  F2M_PROFILE_COUNT(PROFILE_UPDATE, 0, grad.size_w + grad.size_v, 0);
+  ParameterVector* param = m_model->GetParameter();
+  for (index_t i = 0; i < grad.size_w; ++i) {
+    (*param)[grad.pos_w[i]] -= m_learning_rate * grad.w[i];
   }
-}    
+  if (m_model->GetModelType() != LR) {
+    for (index_t i = 0; i < grad.size_v; ++i) {
+      (*param)[grad.pos_v[i]] -= m_learning_rate * grad.v[i];
+    }
+  }
+}
 
 };